@@ -0,0 +1,253 @@
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "argagg.hpp"
+
+#include <hrd/profile.hpp>
+
+argagg::parser create_command_line_interface()
+{
+  return {{{"help", {"-h", "--help"}, "Display help information.", 0},
+      {"requests", {"--requests"}, "Number of synthetic requests to profile (default: 3000000).", 1},
+      {"levels", {"-l", "--levels"}, "Comma-separated block sizes of the hierarchy (default: 64,4096,2097152).", 1},
+      {"backend", {"--reuse-backend"}, "Reuse-distance backend: olken, fenwick, bplus, or multi (default: olken).", 1},
+      {"samples", {"--max-samples"}, "Lower the sample rate to profile at most this many blocks (default: 20000).", 1},
+      {"threads", {"-j", "--threads"}, "Number of threads to compare with a single thread (default: 3).", 1},
+      {"seed", {"--seed"}, "Seed for the random number generator of the requests (default: 1).", 1}}};
+}
+
+void print_usage(std::ostream &stream, argagg::parser const &arguments)
+{
+  argagg::fmt_ostream help(stream);
+
+  help << "Measure the throughput of HRD profiling, and check that profiling on several threads builds the same model "
+          "as on one, and that a checkpoint of it resumes with the olken and bplus backends to the same model.\n\n";
+  help << "hrd-bench [options] ARG [ARG...]\n\n";
+  help << arguments;
+}
+
+/**
+ * Measures the wall-clock time of a region of code.
+ */
+class stopwatch {
+public:
+  stopwatch() : m_start(std::chrono::steady_clock::now())
+  {
+  }
+
+  /**
+   * @return The seconds elapsed since construction.
+   */
+  double seconds() const
+  {
+    auto const elapsed = std::chrono::steady_clock::now() - m_start;
+
+    return std::chrono::duration<double>(elapsed).count();
+  }
+
+private:
+  std::chrono::steady_clock::time_point m_start;
+};
+
+/**
+ * A synthetic request.
+ */
+struct request {
+  std::uint64_t address;
+  hrd::operation op;
+};
+
+/**
+ * Generate reads and writes that mostly stay near the previous address, as a cache-filtered trace would, and jump
+ * often enough to keep reaching new blocks of the largest level.
+ */
+std::vector<request> generate_requests(std::uint64_t count, std::uint64_t seed)
+{
+  std::mt19937_64 rng(seed);
+  std::uniform_int_distribution<std::uint64_t> any_block(0, (std::uint64_t{1} << 30u) - 1);
+  std::uniform_int_distribution<std::int64_t> nearby(-64, 64);
+  std::bernoulli_distribution jump(0.1);
+  std::bernoulli_distribution write(0.3);
+
+  std::vector<request> requests(count);
+
+  std::uint64_t block = 0;
+  for(auto &r : requests) {
+    block = jump(rng) ? any_block(rng) : static_cast<std::uint64_t>(static_cast<std::int64_t>(block) + nearby(rng));
+
+    r.address = block * 64;
+    r.op = write(rng) ? hrd::operation::write : hrd::operation::read;
+  }
+
+  return requests;
+}
+
+/**
+ * Profile the requests, and report the requests profiled per second.
+ *
+ * @return The profile, after it has modelled every request.
+ */
+template <typename Tree>
+hrd::basic_profile<Tree> profile_requests(std::vector<request> const &requests,
+    std::vector<std::uint64_t> const &levels,
+    reuse_distance::shards const &sampler,
+    std::size_t threads)
+{
+  stopwatch timer;
+
+  hrd::basic_profile<Tree> profile(levels, sampler, threads);
+  for(auto const &r : requests) {
+    profile.update(r.address, r.op);
+  }
+  profile.finish();
+
+  auto const seconds = timer.seconds();
+
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << std::setw(4) << threads << " threads: profiled " << requests.size() << " requests in " << seconds
+            << " s, " << static_cast<double>(requests.size()) / seconds / 1e6 << " M requests/s, sampling rate "
+            << std::setprecision(6) << profile.sampler().rate() << std::endl;
+
+  return profile;
+}
+
+/**
+ * @return true if the profiles hold the same reuse and read/write models.
+ */
+template <typename TreeA, typename TreeB>
+bool same_models(hrd::basic_profile<TreeA> const &a, hrd::basic_profile<TreeB> const &b)
+{
+  if(a.ops_model != b.ops_model || a.sampler().scale() != b.sampler().scale()) {
+    return false;
+  }
+
+  for(std::size_t layer = 0; layer < a.reuse_model.size(); ++layer) {
+    auto const &x = a.reuse_model[layer];
+    auto const &y = b.reuse_model[layer];
+    if(x.precision() != y.precision() || x.cold() != y.cold() || x.counts() != y.counts()) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Checkpoint a profile halfway through the requests, resume the checkpoint with another backend, and check that it
+ * finishes with the same model as the uninterrupted profile.
+ *
+ * @throw std::runtime_error if the models differ.
+ */
+template <typename Tree, typename Resumed>
+void compare_resume(std::vector<request> const &requests,
+    std::vector<std::uint64_t> const &levels,
+    reuse_distance::shards const &sampler,
+    std::size_t threads,
+    hrd::basic_profile<Tree> const &expected,
+    std::string const &backend)
+{
+  std::stringstream checkpoint;
+  {
+    hrd::basic_profile<Tree> profile(levels, sampler, threads);
+    for(std::size_t i = 0; i < requests.size() / 2; i++) {
+      profile.update(requests[i].address, requests[i].op);
+    }
+
+    profile.checkpoint(checkpoint);
+  }
+
+  hrd::basic_profile<Resumed> profile(levels, sampler, threads);
+  profile.resume(checkpoint);
+  for(auto i = static_cast<std::size_t>(profile.count()); i < requests.size(); i++) {
+    profile.update(requests[i].address, requests[i].op);
+  }
+  profile.finish();
+
+  if(!same_models(expected, profile)) {
+    throw std::runtime_error("Resuming a checkpoint with the " + backend + " backend built a different model.");
+  }
+
+  std::cout << "resumed a checkpoint with the " << backend << " backend" << std::endl;
+}
+
+/**
+ * Profile the requests on one thread and on several, and check that both build the same model. The parallel profile
+ * is also checkpointed halfway and resumed with the olken and bplus backends, which must finish with the same model.
+ *
+ * @throw std::runtime_error if the models differ.
+ */
+template <typename Tree>
+void compare_threads(std::vector<request> const &requests,
+    std::vector<std::uint64_t> const &levels,
+    reuse_distance::shards const &sampler,
+    std::size_t threads)
+{
+  auto const sequential = profile_requests<Tree>(requests, levels, sampler, 1);
+  auto const parallel = profile_requests<Tree>(requests, levels, sampler, threads);
+
+  if(!same_models(sequential, parallel)) {
+    throw std::runtime_error("Profiling on " + std::to_string(threads) + " threads built a different model.");
+  }
+
+  compare_resume<Tree, reuse_distance::olken_tree>(requests, levels, sampler, threads, parallel, "olken");
+  compare_resume<Tree, reuse_distance::bplus_tree>(requests, levels, sampler, threads, parallel, "bplus");
+}
+
+int main(int argc, char **argv)
+{
+  try {
+    // Parse the command line.
+    auto interface = create_command_line_interface();
+    auto const arguments = interface.parse(argc, argv);
+
+    // Check if help was requested.
+    if(arguments["help"]) {
+      print_usage(std::cout, interface);
+
+      return EXIT_SUCCESS;
+    }
+
+    auto const requests = generate_requests(
+        arguments["requests"].as<std::uint64_t>(3000000), arguments["seed"].as<std::uint64_t>(1));
+
+    std::vector<std::uint64_t> levels;
+    std::stringstream stream(arguments["levels"].as<std::string>("64,4096,2097152"));
+    for(std::string level; std::getline(stream, level, ',');) {
+      levels.push_back(std::stoull(level));
+    }
+
+    reuse_distance::shards const sampler(1.0, arguments["samples"].as<std::size_t>(20000));
+
+    auto const threads = arguments["threads"].as<std::size_t>(3);
+    if(threads == 0) {
+      throw std::runtime_error("The number of threads must be greater than zero.");
+    }
+
+    auto const backend = arguments["backend"].as<std::string>("olken");
+    if(backend == "olken") {
+      compare_threads<reuse_distance::olken_tree>(requests, levels, sampler, threads);
+    } else if(backend == "fenwick") {
+      compare_threads<reuse_distance::fenwick_tree>(requests, levels, sampler, threads);
+    } else if(backend == "bplus") {
+      compare_threads<reuse_distance::bplus_tree>(requests, levels, sampler, threads);
+    } else if(backend == "multi") {
+      compare_threads<reuse_distance::multi_granularity<reuse_distance::bplus_tree>>(
+          requests, levels, sampler, threads);
+    } else {
+      throw std::runtime_error("Unknown backend: " + backend);
+    }
+  } catch(std::exception const &e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
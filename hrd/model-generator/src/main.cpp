@@ -14,7 +14,14 @@ argagg::parser create_command_line_interface()
   return {{{"help", {"-h", "--help"}, "Display help information.", 0},
       {"input", {"-i", "--input"}, "gem5 packet trace.", 1},
       {"output", {"-o", "--output"}, "Output file.", 1},
-      {"layers", {"-l", "--layers"}, "Layers of the hierarchy (default: 64,4096)", 1}}};
+      {"layers", {"-l", "--layers"}, "Layers of the hierarchy (default: 64,4096)", 1},
+      {"backend", {"--reuse-backend"}, "Reuse-distance backend: olken, compact, fenwick, bplus, multi, approximate, or reuse-time (default: olken)", 1},
+      {"rate", {"--sample-rate"}, "Fraction of blocks to profile, rounded down to a power of two (default: 1)", 1},
+      {"samples", {"--max-samples"}, "Lower the sample rate to profile at most this many blocks (default: 0, unlimited)", 1},
+      {"threads", {"-j", "--threads"}, "Number of threads to calculate reuse distances with (default: 1)", 1},
+      {"checkpoint", {"--checkpoint"}, "File to periodically checkpoint the profile to (default: none)", 1},
+      {"interval", {"--checkpoint-interval"}, "Number of requests between checkpoints (default: 100000000)", 1},
+      {"resume", {"--resume"}, "Resume from the checkpoint file, skipping the requests it has modelled", 0}}};
 }
 
 void print_usage(std::ostream &stream, argagg::parser const &arguments)
@@ -79,8 +86,37 @@ int main(int argc, char **argv)
     // Parse the layers from a comma-separated string (no spaces).
     auto layers = parse_layers(arguments["layers"].as<std::string>("64,4096"));
 
+    // Select how reuse distances are calculated.
+    auto const backend = arguments["backend"].as<std::string>("olken");
+
+    // Sample the blocks of the largest layer.
+    reuse_distance::shards const sampler(
+        arguments["rate"].as<double>(1.0), arguments["samples"].as<std::size_t>(0));
+
+    // Split the reuse-distance calculation over several threads.
+    auto const threads = arguments["threads"].as<std::size_t>(1);
+    if(threads == 0) {
+      throw std::runtime_error("The number of threads must be greater than zero.");
+    }
+
+    // Periodically save the profile, so an interrupted run can resume.
+    checkpoint_settings checkpoints;
+    checkpoints.filename = arguments["checkpoint"].as<std::string>("");
+    checkpoints.interval = arguments["interval"].as<std::uint64_t>(checkpoints.interval);
+    checkpoints.resume = arguments["resume"];
+    if(checkpoints.interval == 0) {
+      throw std::runtime_error("The checkpoint interval must be greater than zero.");
+    }
+    if(checkpoints.resume && checkpoints.filename.empty()) {
+      throw std::runtime_error("Missing path to the checkpoint to resume from.");
+    }
+    if(!checkpoints.filename.empty() && backend == "reuse-time") {
+      throw std::runtime_error("The reuse-time backend does not support checkpoints.");
+    }
+
     // Generate the model.
-    generate_hrd_model(input_filename, output_filename, std::move(layers));
+    generate_hrd_model(
+        input_filename, output_filename, std::move(layers), backend, sampler, threads, checkpoints);
   } catch(std::exception const &e) {
     spdlog::get("log")->error("{}", e.what());
 
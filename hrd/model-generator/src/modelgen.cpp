@@ -1,6 +1,7 @@
 #include "modelgen.hpp"
 
 #include <algorithm>
+#include <cstdio>
 #include <fstream>
 
 #include <ioproto/ofstream.hpp>
@@ -11,22 +12,100 @@
 
 static constexpr std::uint32_t GEM5_MAGIC_NUMBER = 0x356d6567;
 
-void generate_hrd_model(std::string const &input_filename,
-    std::string const &output_filename,
-    std::vector<std::uint64_t> layers)
+template <typename Tree>
+void write_checkpoint(hrd::basic_profile<Tree> const &model, std::string const &filename)
 {
-  std::sort(layers.begin(), layers.end());
+  // Write to a temporary file first, so a crash while writing never replaces the last good checkpoint.
+  auto const temporary = filename + ".tmp";
+  {
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    model.checkpoint(file);
 
-  spdlog::get("log")->info("{} layers have been configured and sorted.", layers.size());
-  for(std::size_t i = 0; i < layers.size(); ++i) {
-    spdlog::get("log")->info("Layer {} has a block size of {} bytes.", i, layers[i]);
+    if(!file.flush()) {
+      throw std::runtime_error("Failed to write the checkpoint " + temporary);
+    }
+  }
+
+  if(std::rename(temporary.c_str(), filename.c_str()) != 0) {
+    throw std::runtime_error("Failed to replace the checkpoint " + filename);
+  }
+
+  spdlog::get("log")->info("Checkpointed the profile after {} requests to {}.", model.count(), filename);
+}
+
+/**
+ * Log the statistics of the reuse-distance trees, which only the olken_tree collects (when built with the
+ * REUSE_DISTANCE_STATS CMake option).
+ */
+template <typename Tree>
+void log_tree_stats(hrd::basic_profile<Tree> const &)
+{
+}
+
+void log_tree_stats(hrd::basic_profile<reuse_distance::olken_tree> const &model)
+{
+  if(!reuse_distance::STATS_ENABLED) {
+    return;
+  }
+
+  auto const ratio = [](std::uint64_t numerator, std::uint64_t denominator) {
+    return denominator == 0 ? 0.0 : static_cast<double>(numerator) / static_cast<double>(denominator);
+  };
+
+  for(std::size_t layer = 0; layer < model.trees().size(); layer++) {
+    auto const stats = model.trees()[layer].stats();
+
+    spdlog::get("log")->info("Layer {} has {} nodes and a height of {}, with {:.2f} rotations per insert, {:.2f} "
+                             "rotations per erase, {:.2f} steps per position, and {:.2f} probes per lookup.",
+        layer,
+        stats.nodes,
+        stats.height,
+        ratio(stats.attach_rotations, stats.attaches),
+        ratio(stats.detach_rotations, stats.detaches),
+        ratio(stats.position_steps, stats.positions),
+        ratio(stats.probes, stats.lookups));
+  }
+}
+
+template <typename Tree>
+void resume_from_checkpoint(hrd::basic_profile<Tree> &model,
+    iogem5::packet_trace_reader &trace,
+    std::string const &filename)
+{
+  std::ifstream file(filename, std::ios::binary);
+  if(!file.good()) {
+    throw std::runtime_error("The checkpoint " + filename + " does not exist.");
+  }
+
+  model.resume(file);
+
+  // Skip the requests that the checkpoint has already modelled.
+  iogem5::packet packet{};
+  for(std::uint64_t i = 0; i < model.count(); i++) {
+    if(!trace.read(&packet)) {
+      throw std::runtime_error("The trace is shorter than the checkpoint " + filename);
+    }
   }
 
-  std::ifstream input_file(input_filename);
-  iogem5::packet_trace_reader trace(input_file);
+  spdlog::get("log")->info("Resumed the profile from {} after {} requests.", filename, model.count());
+}
+
+template <typename Tree>
+void generate(std::string const &input_filename,
+    std::string const &output_filename,
+    std::vector<std::uint64_t> const &layers,
+    reuse_distance::shards const &sampler,
+    std::size_t threads,
+    checkpoint_settings const &checkpoints)
+{
+  // Decompress the trace on another thread, while this one updates the model.
+  iogem5::packet_trace_reader trace(input_filename, ioproto::read_mode::async);
   spdlog::get("log")->info("Opened trace file: {}", input_filename);
 
-  hrd::profile model(layers);
+  hrd::basic_profile<Tree> model(layers, sampler, threads);
+  if(checkpoints.resume) {
+    resume_from_checkpoint(model, trace, checkpoints.filename);
+  }
 
   // Loop through all the packets in the trace.
   iogem5::packet packet{};
@@ -48,10 +127,22 @@ void generate_hrd_model(std::string const &input_filename,
     if(model.count() % 1000000 == 0) {
       spdlog::get("log")->info("{} requests have been modelled so far ({} unique addresses).",
           model.count(), model.unique_addresses());
+      log_tree_stats(model);
+    }
+
+    if(!checkpoints.filename.empty() && model.count() % checkpoints.interval == 0) {
+      write_checkpoint(model, checkpoints.filename);
     }
   }
 
+  model.finish();
+
   spdlog::get("log")->info("{} requests have been modelled.", model.count());
+  log_tree_stats(model);
+  if(model.sampler().scale() > 1) {
+    spdlog::get("log")->info("1 in {} blocks were profiled, the counts have been scaled up to match.",
+        model.sampler().scale());
+  }
   spdlog::get("log")->info("There were {} unique addresses in the range {} to {}.",
       model.unique_addresses(), model.min_address, model.max_address);
 
@@ -63,3 +154,46 @@ void generate_hrd_model(std::string const &input_filename,
     spdlog::get("log")->info("The model metadata has been written to the output.");
   }
 }
+
+void generate_hrd_model(std::string const &input_filename,
+    std::string const &output_filename,
+    std::vector<std::uint64_t> layers,
+    std::string const &backend,
+    reuse_distance::shards const &sampler,
+    std::size_t threads,
+    checkpoint_settings const &checkpoints)
+{
+  std::sort(layers.begin(), layers.end());
+
+  spdlog::get("log")->info("{} layers have been configured and sorted.", layers.size());
+  for(std::size_t i = 0; i < layers.size(); ++i) {
+    spdlog::get("log")->info("Layer {} has a block size of {} bytes.", i, layers[i]);
+  }
+
+  spdlog::get("log")->info(
+      "Reuse distances will be calculated with the {} backend on {} thread(s).", backend, threads);
+  if(backend == "olken") {
+    generate<reuse_distance::olken_tree>(
+        input_filename, output_filename, layers, sampler, threads, checkpoints);
+  } else if(backend == "compact") {
+    generate<reuse_distance::compact_tree>(
+        input_filename, output_filename, layers, sampler, threads, checkpoints);
+  } else if(backend == "reuse-time") {
+    generate<reuse_distance::reuse_time_tracker>(
+        input_filename, output_filename, layers, sampler, threads, checkpoints);
+  } else if(backend == "approximate") {
+    generate<reuse_distance::approximate_tree>(
+        input_filename, output_filename, layers, sampler, threads, checkpoints);
+  } else if(backend == "fenwick") {
+    generate<reuse_distance::fenwick_tree>(
+        input_filename, output_filename, layers, sampler, threads, checkpoints);
+  } else if(backend == "bplus") {
+    generate<reuse_distance::bplus_tree>(
+        input_filename, output_filename, layers, sampler, threads, checkpoints);
+  } else if(backend == "multi") {
+    generate<reuse_distance::multi_granularity<reuse_distance::bplus_tree>>(
+        input_filename, output_filename, layers, sampler, threads, checkpoints);
+  } else {
+    throw std::runtime_error("Unknown reuse-distance backend: " + backend);
+  }
+}
@@ -1,20 +1,44 @@
 #ifndef HRD_CLONING_MODELGEN_HPP
 #define HRD_CLONING_MODELGEN_HPP
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
+#include <reuse-distance/shards.hpp>
+
 #include "hrd/profile.hpp"
 
+/**
+ * Where and how often the profile is checkpointed while the trace is read.
+ */
+struct checkpoint_settings {
+  /** The file to write checkpoints to, or empty to never checkpoint. */
+  std::string filename;
+  /** The number of requests between two checkpoints. */
+  std::uint64_t interval = 100000000;
+  /** Restore the profile from the checkpoint file, and skip the requests it has already modelled. */
+  bool resume = false;
+};
+
 /**
  * Generate and serialize an HRD statistical profile.
  *
  * @param input_filename The trace file to read memory requests from.
  * @param output_filename The model file to serialize to.
  * @param layers The block sizes to use in the hierarchy.
+ * @param backend The reuse-distance backend to profile with (olken, compact, fenwick, bplus, multi, approximate, or
+ *                reuse-time).
+ * @param sampler Selects the blocks of the largest layer to profile.
+ * @param threads The number of threads to calculate reuse distances with.
+ * @param checkpoints Where and how often to checkpoint the profile.
  */
 void generate_hrd_model(std::string const &input_filename,
     std::string const &output_filename,
-    std::vector<std::uint64_t> layers);
+    std::vector<std::uint64_t> layers,
+    std::string const &backend,
+    reuse_distance::shards const &sampler,
+    std::size_t threads,
+    checkpoint_settings const &checkpoints);
 
 #endif //HRD_CLONING_MODELGEN_HPP
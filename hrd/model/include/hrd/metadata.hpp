@@ -18,7 +18,8 @@ profile read(ioproto::istream &stream, std::uint64_t *request_count = nullptr);
 /**
  * Append a profile to the output stream.
  */
-void append(ioproto::ofstream &stream, profile const &p);
+template <typename Tree>
+void append(ioproto::ofstream &stream, basic_profile<Tree> const &p);
 }
 
 #endif //HRD_CLONING_METADATA_HPP
@@ -2,32 +2,48 @@
 #define HRD_CLONING_PROFILE_HPP
 
 #include <cstdint>
-#include <map>
+#include <istream>
+#include <ostream>
 #include <unordered_map>
 #include <vector>
 
+#include <reuse-distance/approximate.hpp>
+#include <reuse-distance/bplus.hpp>
+#include <reuse-distance/compact.hpp>
+#include <reuse-distance/fenwick.hpp>
+#include <reuse-distance/multi-granularity.hpp>
 #include <reuse-distance/olken.hpp>
+#include <reuse-distance/reuse-time.hpp>
+#include <reuse-distance/shards.hpp>
 
 #include <hrd/request-type.hpp>
+#include <hrd/reuse-histogram.hpp>
 
 namespace hrd {
 
-/**
- * Captures the distribution of reuse distances.
- */
-using reuse_histogram = std::map<double, std::uint64_t>;
-
 /**
  * A module for building Hierarchical Reuse Distance models.
+ *
+ * @tparam Tree The reuse-distance backend used per level (e.g., reuse_distance::olken_tree), which must support
+ * reuse_distance::access, or a reuse_distance::multi_granularity to track all levels (of power-of-two block sizes) at
+ * once.
  */
-class profile {
+template <typename Tree>
+class basic_profile {
 public:
   /**
    * Constructor.
    *
    * @param levels The block sizes to consider, assumed to be an ascending order.
+   * @param sampler Selects the blocks of the largest level to profile, the default profiles every block.
+   * @param threads The number of threads to calculate reuse distances with. With more than one thread, requests are
+   * buffered and modelled in batches.
+   *
+   * @throw std::invalid_argument if the backend is a multi_granularity and the block sizes are not powers of two.
    */
-  explicit profile(std::vector<std::uint64_t> levels);
+  explicit basic_profile(std::vector<std::uint64_t> levels,
+      reuse_distance::shards sampler = reuse_distance::shards(),
+      std::size_t threads = 1);
 
   /**
    * Update the reuse distance model and read/write model.
@@ -38,7 +54,41 @@ public:
   void update(std::uint64_t address, operation op);
 
   /**
-   * @return The number of unique addresses modelled by the profile.
+   * Model any buffered requests, which must be done before reading the models.
+   */
+  void flush();
+
+  /**
+   * Model any buffered requests and, for a backend that measures reuse times, convert the reuse model into reuse
+   * distances. Must be called once, after the last update.
+   */
+  void finish();
+
+  /**
+   * Write the state of the profile, so that profiling can resume after the last request modelled. Any buffered
+   * requests are written as they are, so checkpoints do not change the batches that are modelled in parallel.
+   *
+   * @param stream The binary stream to write to.
+   *
+   * @throw std::runtime_error if the stream fails, or the backend does not support checkpoints.
+   */
+  void checkpoint(std::ostream &stream) const;
+
+  /**
+   * Replace the state of the profile with a checkpoint, after which the trace should continue from request count().
+   *
+   * The trees are rebuilt from snapshots (see reuse_distance::snapshot), so the checkpoint may have been written with
+   * another backend.
+   *
+   * @param stream The binary stream to read from.
+   *
+   * @throw std::runtime_error if the stream does not hold a checkpoint of a profile with the same levels, or a level
+   * holds an access that is not earlier than the buffered requests.
+   */
+  void resume(std::istream &stream);
+
+  /**
+   * @return The number of unique addresses modelled by the profile (estimated when sampling).
    */
   std::size_t unique_addresses() const;
 
@@ -47,6 +97,16 @@ public:
    */
   std::uint64_t count() const;
 
+  /**
+   * @return The sampler that selects which blocks are profiled.
+   */
+  reuse_distance::shards const &sampler() const;
+
+  /**
+   * @return The reuse-distance trees per level of the hierarchy, or a single multi_granularity for all levels.
+   */
+  std::vector<Tree> const &trees() const;
+
 public:
   /** The block sizes per level of the hierarchy. */
   std::vector<std::uint64_t> layers;
@@ -62,17 +122,42 @@ public:
 private:
   void model_reuse(std::uint64_t address);
 
+  void record_reuse(std::uint64_t address, std::vector<double> const &distances);
+
   void model_operation(std::uint64_t address, operation op);
 
+  void evict_unsampled();
+
+  // The end of the buffered requests from start that can be modelled as one batch, before the sampling rate changes.
+  std::size_t batch_end(std::size_t start) const;
+
+  // Drop the buffered requests from start whose blocks are no longer sampled.
+  void drop_unsampled(std::size_t start);
+
 private:
   // Logical time counter.
   std::uint64_t m_time = 0;
-  // The reuse distance data structures per level of the hierarchy.
-  std::vector<reuse_distance::olken_tree> m_info;
+  // The reuse distance data structures per level of the hierarchy, or a single multi_granularity for all levels.
+  std::vector<Tree> m_info;
   // The current state of a unique address in memory.
   std::unordered_map<std::uint64_t, memory_state> m_states;
+  // Selects the blocks of the largest level that are profiled.
+  reuse_distance::shards m_sampler;
+  // The number of threads to calculate reuse distances with.
+  std::size_t m_threads;
+  // The sampled requests that have not been modelled yet.
+  std::vector<std::uint64_t> m_pending_addresses;
+  std::vector<operation> m_pending_ops;
+  // The reuse distance of one request per level, and of every buffered request per level.
+  std::vector<double> m_distances;
+  std::vector<std::vector<double>> m_batch_distances;
 };
 
+/**
+ * An HRD profile that uses the olken_tree to calculate reuse distances.
+ */
+using profile = basic_profile<reuse_distance::olken_tree>;
+
 } // namespace hrd
 
 #endif // HRD_CLONING_PROFILE_HPP
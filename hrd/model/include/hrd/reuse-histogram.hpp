@@ -0,0 +1,173 @@
+#ifndef HRD_CLONING_REUSE_HISTOGRAM_HPP
+#define HRD_CLONING_REUSE_HISTOGRAM_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace hrd {
+
+/**
+ * Captures the distribution of reuse distances.
+ *
+ * Distances are rounded to the nearest integer and counted in a flat array of bins. Distances below 2^p, where p is the
+ * precision, each have their own bin. Above that, every power of two is split into 2^(p-1) bins of equal width, so a
+ * bin spans less than 2^(1-p) of the distances it holds (0.2% with the default precision). First accesses, which have
+ * an infinite reuse distance, are counted separately.
+ */
+class reuse_histogram {
+public:
+  /** The default precision, which keeps distances below 1024 exact. */
+  static constexpr unsigned DEFAULT_PRECISION = 10;
+
+  /**
+   * Constructor.
+   *
+   * @param precision The number of significant bits kept of each distance, in the range [1, 24].
+   *
+   * @throw std::invalid_argument if the precision is out of range.
+   */
+  explicit reuse_histogram(unsigned precision = DEFAULT_PRECISION);
+
+  /**
+   * @return The number of significant bits kept of each distance.
+   */
+  unsigned precision() const;
+
+  /**
+   * Count accesses with a reuse distance.
+   *
+   * @param distance The reuse distance, or infinity for a first access.
+   * @param count The number of accesses.
+   */
+  void add(double distance, std::uint64_t count = 1)
+  {
+    if(distance == std::numeric_limits<double>::infinity()) {
+      m_cold += count;
+    } else {
+      add_bin(bin_of(distance), count);
+    }
+  }
+
+  /**
+   * Count accesses in a bin.
+   *
+   * @param bin The index of the bin.
+   * @param count The number of accesses.
+   */
+  void add_bin(std::size_t bin, std::uint64_t count)
+  {
+    if(bin >= m_counts.size()) {
+      m_counts.resize(bin + 1, 0);
+    }
+
+    m_counts[bin] += count;
+  }
+
+  /**
+   * Count first accesses.
+   *
+   * @param count The number of accesses with an infinite reuse distance.
+   */
+  void add_cold(std::uint64_t count);
+
+  /**
+   * @return The number of accesses with an infinite reuse distance.
+   */
+  std::uint64_t cold() const;
+
+  /**
+   * @return The number of accesses counted, including first accesses.
+   */
+  std::uint64_t total() const;
+
+  /**
+   * @return true if no access has been counted, false otherwise.
+   */
+  bool empty() const;
+
+  /**
+   * @return The number of accesses in each bin, up to the highest bin counted.
+   */
+  std::vector<std::uint64_t> const &counts() const;
+
+  /**
+   * Find the bin of a finite reuse distance.
+   *
+   * @param distance The reuse distance.
+   *
+   * @return The index of the bin.
+   */
+  std::size_t bin_of(double distance) const
+  {
+    auto const value = static_cast<std::uint64_t>(std::llround(distance));
+    if(value < m_exact) {
+      return static_cast<std::size_t>(value);
+    }
+
+    // Keep the top p bits of the distance, the leading one selecting the power of two.
+    auto const shift = most_significant_bit(value) - m_precision + 1;
+    auto const top = value >> shift;
+
+    return static_cast<std::size_t>(m_exact + (shift - 1) * (m_exact / 2) + (top - m_exact / 2));
+  }
+
+  /**
+   * @param bin The index of a bin.
+   *
+   * @return The distance that represents the bin, which is the middle of the distances it holds.
+   */
+  double distance_of(std::size_t bin) const;
+
+  /**
+   * Visit every bin that is not empty, in ascending order of distance, followed by the first accesses (if any).
+   *
+   * @param visitor A callable that accepts the distance of a bin (infinity for first accesses) and its count.
+   */
+  template <typename Visitor>
+  void for_each(Visitor &&visitor) const
+  {
+    for(std::size_t bin = 0; bin < m_counts.size(); ++bin) {
+      if(m_counts[bin] != 0) {
+        visitor(distance_of(bin), m_counts[bin]);
+      }
+    }
+
+    if(m_cold != 0) {
+      visitor(std::numeric_limits<double>::infinity(), m_cold);
+    }
+  }
+
+  /**
+   * Remove every access counted.
+   */
+  void clear();
+
+private:
+  unsigned m_precision;
+  // The first distance that does not have a bin of its own.
+  std::uint64_t m_exact;
+
+  std::vector<std::uint64_t> m_counts;
+  std::uint64_t m_cold = 0;
+
+  static unsigned most_significant_bit(std::uint64_t value)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63u - static_cast<unsigned>(__builtin_clzll(value));
+#else
+    unsigned bit = 0;
+    while(value >>= 1u) {
+      bit++;
+    }
+
+    return bit;
+#endif
+  }
+};
+
+} // namespace hrd
+
+#endif //HRD_CLONING_REUSE_HISTOGRAM_HPP
@@ -56,14 +56,25 @@ profile read(ioproto::istream &stream, std::uint64_t *request_count)
     }
 
     auto const num_layers = static_cast<std::size_t>(proto_reuse.layer_size());
-    profile.reuse_model.resize(num_layers);
+    auto const precision =
+        proto_reuse.has_precision() ? proto_reuse.precision() : reuse_histogram::DEFAULT_PRECISION;
+    profile.reuse_model.assign(num_layers, reuse_histogram(precision));
 
     for(std::size_t layer = 0; layer < num_layers; layer++) {
       const hrd::ReuseModel_Histogram &histogram = proto_reuse.layer(static_cast<int>(layer));
+      auto &model = profile.reuse_model[layer];
 
       // Assume the distance and count arrays in the histogram are the same size.
       for(int i = 0; i < histogram.distance_size(); i++) {
-        profile.reuse_model[layer][histogram.distance(i)] = histogram.count(i);
+        model.add(histogram.distance(i), histogram.count(i));
+      }
+
+      model.add_cold(histogram.cold());
+
+      std::size_t bin = 0;
+      for(int i = 0; i < histogram.bin_gap_size(); i++) {
+        bin += static_cast<std::size_t>(histogram.bin_gap(i));
+        model.add_bin(bin, histogram.bin_count(i));
       }
     }
   }
@@ -71,7 +82,8 @@ profile read(ioproto::istream &stream, std::uint64_t *request_count)
   return profile;
 }
 
-void append(ioproto::ofstream &stream, const profile &p)
+template <typename Tree>
+void append(ioproto::ofstream &stream, basic_profile<Tree> const &p)
 {
   {
     Configuration config;
@@ -112,14 +124,31 @@ void append(ioproto::ofstream &stream, const profile &p)
 
     for(auto const &l : p.reuse_model) {
       auto histogram = layers.add_layer();
+      histogram->set_cold(l.cold());
 
-      for(auto const &hist : l) {
-        histogram->add_distance(hist.first);
-        histogram->add_count(hist.second);
+      auto const &counts = l.counts();
+
+      std::size_t previous = 0;
+      for(std::size_t bin = 0; bin < counts.size(); ++bin) {
+        if(counts[bin] != 0) {
+          histogram->add_bin_gap(bin - previous);
+          histogram->add_bin_count(counts[bin]);
+          previous = bin;
+        }
       }
+
+      layers.set_precision(l.precision());
     }
 
     stream.write(layers);
   }
 }
+template void append(ioproto::ofstream &stream, basic_profile<reuse_distance::olken_tree> const &p);
+template void append(ioproto::ofstream &stream, basic_profile<reuse_distance::compact_tree> const &p);
+template void append(ioproto::ofstream &stream, basic_profile<reuse_distance::approximate_tree> const &p);
+template void append(ioproto::ofstream &stream, basic_profile<reuse_distance::fenwick_tree> const &p);
+template void append(ioproto::ofstream &stream, basic_profile<reuse_distance::bplus_tree> const &p);
+template void append(ioproto::ofstream &stream, basic_profile<reuse_distance::multi_granularity<reuse_distance::bplus_tree>> const &p);
+template void append(ioproto::ofstream &stream, basic_profile<reuse_distance::reuse_time_tracker> const &p);
+
 } // namespace hrd
\ No newline at end of file
@@ -1,11 +1,28 @@
 #include "hrd/profile.hpp"
 
+#include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <functional>
 #include <limits>
+#include <map>
+#include <stdexcept>
+#include <unordered_set>
 #include <hrd/profile.hpp>
 
+#include <reuse-distance/parallel.hpp>
+#include <reuse-distance/snapshot.hpp>
+#include <reuse-distance/statstack.hpp>
+
 namespace hrd {
 
+// The number of requests buffered before they are modelled in parallel.
+constexpr std::size_t BATCH_SIZE = std::size_t{1} << 20u;
+
+// Identifies a checkpoint of an HRD profile, and the version of its format.
+constexpr char CHECKPOINT_MAGIC[] = {'H', 'R', 'D', 'C'};
+constexpr std::uint64_t CHECKPOINT_VERSION = 3;
+
 inline std::uint64_t calculate_block(std::uint64_t address, std::uint64_t block_size)
 {
   auto const block = std::floor(address / block_size);
@@ -13,12 +30,315 @@ inline std::uint64_t calculate_block(std::uint64_t address, std::uint64_t block_
   return static_cast<std::uint64_t>(block);
 }
 
-profile::profile(std::vector<std::uint64_t> levels)
+/**
+ * Backends that measure reuse distances (exactly or approximately) need no conversion.
+ */
+template <typename Tree>
+inline void convert_to_distances(std::vector<Tree> const &, std::vector<reuse_histogram> &, std::uint64_t)
+{
+}
+
+/**
+ * Convert the reuse times of each level into reuse distances, based on the distribution of all reuse times measured on
+ * that level (and not only those recorded in the model, which skips accesses reused on a lower level).
+ */
+inline void convert_to_distances(std::vector<reuse_distance::reuse_time_tracker> const &levels,
+    std::vector<reuse_histogram> &model,
+    std::uint64_t scale)
+{
+  for(std::size_t layer = 0; layer < levels.size(); ++layer) {
+    // The recorded reuse times were scaled up by the sampling rate, so scale the distribution to match.
+    std::map<double, std::uint64_t> all_reuse_times;
+    for(auto const &bin : levels[layer].histogram()) {
+      all_reuse_times[bin.first * static_cast<double>(scale)] = bin.second;
+    }
+
+    reuse_distance::statstack const estimate(all_reuse_times);
+
+    reuse_histogram distances(model[layer].precision());
+    model[layer].for_each([&estimate, &distances](double reuse_time, std::uint64_t count) {
+      distances.add(estimate.distance(reuse_time), count);
+    });
+
+    model[layer] = std::move(distances);
+  }
+}
+
+/**
+ * Write the bins of a histogram that are not empty, each as the gap from the previous one and its count.
+ */
+inline void write_histogram(std::ostream &stream, reuse_histogram const &histogram)
+{
+  using reuse_distance::write_varint;
+
+  auto const &counts = histogram.counts();
+  auto const bins = static_cast<std::uint64_t>(std::count_if(
+      counts.begin(), counts.end(), [](std::uint64_t count) { return count != 0; }));
+
+  write_varint(stream, histogram.precision());
+  write_varint(stream, histogram.cold());
+  write_varint(stream, bins);
+
+  std::size_t previous = 0;
+  for(std::size_t bin = 0; bin < counts.size(); ++bin) {
+    if(counts[bin] != 0) {
+      write_varint(stream, bin - previous);
+      write_varint(stream, counts[bin]);
+      previous = bin;
+    }
+  }
+}
+
+inline reuse_histogram read_histogram(std::istream &stream)
+{
+  using reuse_distance::read_varint;
+
+  auto const precision = read_varint(stream);
+  if(precision > std::numeric_limits<unsigned>::max()) {
+    throw std::runtime_error("The checkpoint holds an invalid reuse histogram.");
+  }
+
+  reuse_histogram histogram(static_cast<unsigned>(precision));
+  histogram.add_cold(read_varint(stream));
+
+  auto const bins = read_varint(stream);
+
+  std::size_t bin = 0;
+  for(std::uint64_t i = 0; i < bins; i++) {
+    bin += static_cast<std::size_t>(read_varint(stream));
+    histogram.add_bin(bin, read_varint(stream));
+  }
+
+  return histogram;
+}
+
+/**
+ * Write the tree of one level as a snapshot.
+ */
+template <typename Tree>
+inline void save_level(std::ostream &stream, Tree const &tree, std::uint64_t clock)
+{
+  reuse_distance::write_snapshot(stream, reuse_distance::save(tree, clock));
+}
+
+/**
+ * Reuse times depend on the absolute time of every last access, which a snapshot does not keep.
+ */
+inline void save_level(std::ostream &, reuse_distance::reuse_time_tracker const &, std::uint64_t)
+{
+  throw std::runtime_error("The reuse-time backend does not support checkpoints.");
+}
+
+/**
+ * Read the snapshot of one level, whose accesses must all precede the first buffered request.
+ *
+ * @throw std::runtime_error if the snapshot holds an access at or after the time of the first buffered request.
+ */
+inline reuse_distance::snapshot read_level(std::istream &stream, std::uint64_t first_pending)
+{
+  auto s = reuse_distance::read_snapshot(stream);
+  if(!s.entries.empty() && s.entries.front().time >= first_pending) {
+    throw std::runtime_error("The checkpoint holds an access that is not earlier than its buffered requests.");
+  }
+
+  return s;
+}
+
+/**
+ * Rebuild the (empty) tree of one level from a snapshot.
+ */
+template <typename Tree>
+inline void restore_level(std::istream &stream, Tree &tree, std::uint64_t first_pending)
+{
+  reuse_distance::restore(tree, read_level(stream, first_pending));
+}
+
+inline void restore_level(std::istream &, reuse_distance::reuse_time_tracker &, std::uint64_t)
+{
+  throw std::runtime_error("The reuse-time backend does not support checkpoints.");
+}
+
+/**
+ * Set up an empty tree per level.
+ */
+template <typename Tree>
+inline void reset_levels(std::vector<Tree> &trees, std::vector<std::uint64_t> const &layers)
+{
+  trees = std::vector<Tree>(layers.size());
+}
+
+/**
+ * A multi_granularity tracks every level, so it is the only tree.
+ */
+template <typename Tree>
+inline void reset_levels(std::vector<reuse_distance::multi_granularity<Tree>> &trees,
+    std::vector<std::uint64_t> const &layers)
+{
+  trees.clear();
+  trees.emplace_back(layers);
+}
+
+/**
+ * Calculate the reuse distance of an access on every level, and make it the most recent access.
+ */
+template <typename Tree>
+inline void access_levels(std::vector<Tree> &trees,
+    std::vector<std::uint64_t> const &layers,
+    std::uint64_t address,
+    std::uint64_t time,
+    std::vector<double> &distances)
+{
+  for(std::size_t layer = 0; layer < layers.size(); ++layer) {
+    // Calculate the block for this address.
+    auto const block = calculate_block(address, layers[layer]);
+
+    distances[layer] = reuse_distance::access(trees[layer], block, time);
+  }
+}
+
+template <typename Tree>
+inline void access_levels(std::vector<reuse_distance::multi_granularity<Tree>> &trees,
+    std::vector<std::uint64_t> const &,
+    std::uint64_t address,
+    std::uint64_t time,
+    std::vector<double> &distances)
+{
+  reuse_distance::access(trees.front(), address, time, distances.data());
+}
+
+/**
+ * Calculate the reuse distances of a batch of accesses on every level, a level at a time on several threads.
+ */
+template <typename Tree>
+inline void access_levels(std::vector<Tree> &trees,
+    std::vector<std::uint64_t> const &layers,
+    std::uint64_t const *addresses,
+    std::size_t count,
+    std::uint64_t time,
+    std::vector<std::vector<double>> &distances,
+    std::size_t threads)
+{
+  std::vector<std::uint64_t> blocks(count);
+  for(std::size_t layer = 0; layer < layers.size(); ++layer) {
+    for(std::size_t i = 0; i < blocks.size(); i++) {
+      blocks[i] = calculate_block(addresses[i], layers[layer]);
+    }
+
+    reuse_distance::parallel_access(trees[layer], blocks, time, distances[layer], threads);
+  }
+}
+
+template <typename Tree>
+inline void access_levels(std::vector<reuse_distance::multi_granularity<Tree>> &trees,
+    std::vector<std::uint64_t> const &layers,
+    std::uint64_t const *addresses,
+    std::size_t count,
+    std::uint64_t,
+    std::vector<std::vector<double>> &distances,
+    std::size_t threads)
+{
+  std::vector<double> rows(count * layers.size());
+  trees.front().touch(addresses, count, rows.data(), threads);
+
+  for(std::size_t layer = 0; layer < layers.size(); ++layer) {
+    distances[layer].resize(count);
+
+    for(std::size_t i = 0; i < count; i++) {
+      distances[layer][i] = rows[i * layers.size() + layer];
+    }
+  }
+}
+
+/**
+ * Stop tracking the blocks of one level that match a predicate.
+ */
+template <typename Tree>
+inline void erase_level(std::vector<Tree> &trees,
+    std::size_t layer,
+    std::function<bool(std::uint64_t)> const &predicate)
+{
+  reuse_distance::erase_if(trees[layer], predicate);
+}
+
+template <typename Tree>
+inline void erase_level(std::vector<reuse_distance::multi_granularity<Tree>> &trees,
+    std::size_t layer,
+    std::function<bool(std::uint64_t)> const &predicate)
+{
+  reuse_distance::erase_if(trees.front(), layer, predicate);
+}
+
+/**
+ * Write the trees of every level as a snapshot per level.
+ */
+template <typename Tree>
+inline void save_levels(std::ostream &stream, std::vector<Tree> const &trees, std::uint64_t clock)
+{
+  for(auto const &tree : trees) {
+    save_level(stream, tree, clock);
+  }
+}
+
+/**
+ * The levels of a multi_granularity each have their own clock, which is never ahead of the profile's.
+ */
+template <typename Tree>
+inline void save_levels(std::ostream &stream,
+    std::vector<reuse_distance::multi_granularity<Tree>> const &trees,
+    std::uint64_t)
+{
+  auto const &tree = trees.front();
+
+  for(std::size_t layer = 0; layer < tree.levels(); ++layer) {
+    reuse_distance::write_snapshot(stream, reuse_distance::save(tree, layer));
+  }
+}
+
+/**
+ * Rebuild the trees of every level from a snapshot per level.
+ */
+template <typename Tree>
+inline void restore_levels(std::istream &stream,
+    std::vector<Tree> &trees,
+    std::vector<std::uint64_t> const &layers,
+    std::uint64_t first_pending)
+{
+  reset_levels(trees, layers);
+
+  for(auto &tree : trees) {
+    restore_level(stream, tree, first_pending);
+  }
+}
+
+template <typename Tree>
+inline void restore_levels(std::istream &stream,
+    std::vector<reuse_distance::multi_granularity<Tree>> &trees,
+    std::vector<std::uint64_t> const &layers,
+    std::uint64_t first_pending)
+{
+  std::vector<reuse_distance::snapshot> snapshots;
+  for(std::size_t layer = 0; layer < layers.size(); ++layer) {
+    snapshots.push_back(read_level(stream, first_pending));
+  }
+
+  reset_levels(trees, layers);
+  reuse_distance::restore(trees.front(), snapshots);
+}
+
+template <typename Tree>
+basic_profile<Tree>::basic_profile(std::vector<std::uint64_t> levels,
+    reuse_distance::shards sampler,
+    std::size_t threads)
     : layers(std::move(levels))
     , reuse_model(layers.size())
     , min_address(std::numeric_limits<std::uint64_t>::max())
-    , m_info(layers.size())
+    , m_sampler(sampler)
+    , m_threads(threads)
+    , m_distances(layers.size())
+    , m_batch_distances(layers.size())
 {
+  reset_levels(m_info, layers);
+
   for(std::size_t i = 0; i < MEMORY_STATE_COUNT; i++) {
     for(std::size_t j = 0; j < OPERATION_COUNT; j++) {
       ops_model[i][j] = 0;
@@ -26,50 +346,283 @@ profile::profile(std::vector<std::uint64_t> levels)
   }
 }
 
-void profile::update(std::uint64_t address, operation op)
+template <typename Tree>
+void basic_profile<Tree>::update(std::uint64_t address, operation op)
 {
   min_address = std::min(address, min_address);
   max_address = std::max(address, max_address);
 
-  model_reuse(address);
-  model_operation(address, op);
+  // Sample on the largest block, so all the smaller blocks inside it are either profiled or skipped together.
+  if(!layers.empty() && !m_sampler.sample(calculate_block(address, layers.back()))) {
+    m_time++;
+  } else if(m_threads > 1) {
+    m_pending_addresses.push_back(address);
+    m_pending_ops.push_back(op);
+    m_time++;
+
+    if(m_pending_addresses.size() == BATCH_SIZE) {
+      flush();
+    }
+  } else {
+    model_reuse(address);
+    model_operation(address, op);
+  }
 }
 
-void profile::model_reuse(std::uint64_t address)
+template <typename Tree>
+void basic_profile<Tree>::flush()
 {
-  constexpr double INF = std::numeric_limits<double>::infinity();
+  // The buffered requests were given the latest times, unsampled requests only leave gaps before them.
+  auto time = m_time - m_pending_addresses.size();
 
-  double distance = INF;
-  std::size_t layer = 0;
+  std::size_t start = 0;
+  while(start < m_pending_addresses.size()) {
+    // The distances of a batch are measured over the blocks tracked before it, so a batch ends at a request that lowers
+    // the sampling rate, and the rest are only measured once the blocks that are no longer sampled have been evicted.
+    auto const end = batch_end(start);
+    auto const count = end - start;
 
-  while(distance == INF && layer < layers.size()) {
-    // Calculate the block for this address.
-    auto const block = calculate_block(address, layers[layer]);
+    access_levels(m_info, layers, m_pending_addresses.data() + start, count, time, m_batch_distances, m_threads);
+    time += count;
 
-    distance = reuse_distance::compute_distance(m_info[layer], block);
+    auto const scale = m_sampler.scale();
+    for(std::size_t i = start; i < end; i++) {
+      for(std::size_t layer = 0; layer < layers.size(); ++layer) {
+        m_distances[layer] = m_batch_distances[layer][i - start];
+      }
 
-    // Update the histogram for the given layer.
-    reuse_model[layer][distance]++;
+      record_reuse(m_pending_addresses[i], m_distances);
+      model_operation(m_pending_addresses[i], m_pending_ops[i]);
+    }
 
-    ++layer;
+    start = end;
+    if(m_sampler.scale() != scale) {
+      drop_unsampled(start);
+    }
   }
 
-  // Update the remaining layers, ignoring the computed reuse distance.
-  for(layer = 0; layer < layers.size(); ++layer) {
-    auto const block = calculate_block(address, layers[layer]);
-    reuse_distance::update(m_info[layer], block, m_time);
+  m_pending_addresses.clear();
+  m_pending_ops.clear();
+}
+
+template <typename Tree>
+std::size_t basic_profile<Tree>::batch_end(std::size_t start) const
+{
+  auto const size = m_pending_addresses.size();
+  if(layers.empty() || m_sampler.max_samples() == 0) {
+    return size;
+  }
+
+  // The rate is lowered by the request that tracks one block more than the sampler has room for.
+  auto const room = m_sampler.max_samples() - std::min(m_sampler.tracked(), m_sampler.max_samples());
+
+  std::unordered_set<std::uint64_t> added;
+  for(std::size_t i = start; i < size; i++) {
+    auto const block = calculate_block(m_pending_addresses[i], layers.back());
+    if(!m_sampler.tracking(block) && added.insert(block).second && added.size() > room) {
+      return i + 1;
+    }
+  }
+
+  return size;
+}
+
+template <typename Tree>
+void basic_profile<Tree>::drop_unsampled(std::size_t start)
+{
+  auto kept = start;
+  for(std::size_t i = start; i < m_pending_addresses.size(); i++) {
+    if(m_sampler.sample(calculate_block(m_pending_addresses[i], layers.back()))) {
+      m_pending_addresses[kept] = m_pending_addresses[i];
+      m_pending_ops[kept] = m_pending_ops[i];
+      kept++;
+    }
+  }
+
+  m_pending_addresses.resize(kept);
+  m_pending_ops.resize(kept);
+}
+
+template <typename Tree>
+void basic_profile<Tree>::finish()
+{
+  flush();
+
+  convert_to_distances(m_info, reuse_model, m_sampler.scale());
+}
+
+template <typename Tree>
+void basic_profile<Tree>::checkpoint(std::ostream &stream) const
+{
+  using reuse_distance::write_varint;
+
+  if(!stream.write(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC))) {
+    throw std::runtime_error("Failed to write the checkpoint.");
+  }
+  write_varint(stream, CHECKPOINT_VERSION);
+
+  write_varint(stream, layers.size());
+  for(auto const block_size : layers) {
+    write_varint(stream, block_size);
+  }
+
+  write_varint(stream, m_time);
+  write_varint(stream, min_address);
+  write_varint(stream, max_address);
+
+  for(auto const &histogram : ops_model) {
+    for(auto const count : histogram) {
+      write_varint(stream, count);
+    }
+  }
+
+  for(auto const &histogram : reuse_model) {
+    write_histogram(stream, histogram);
+  }
+
+  write_varint(stream, m_states.size());
+  for(auto const &state : m_states) {
+    write_varint(stream, state.first);
+    write_varint(stream, static_cast<std::uint64_t>(state.second));
+  }
+
+  m_sampler.save(stream);
+
+  // The buffered requests were given the latest times, and are not in the trees yet.
+  write_varint(stream, m_pending_addresses.size());
+  for(std::size_t i = 0; i < m_pending_addresses.size(); i++) {
+    write_varint(stream, m_pending_addresses[i]);
+    write_varint(stream, static_cast<std::uint64_t>(m_pending_ops[i]));
+  }
+
+  save_levels(stream, m_info, m_time);
+}
+
+template <typename Tree>
+void basic_profile<Tree>::resume(std::istream &stream)
+{
+  using reuse_distance::read_varint;
+
+  char magic[sizeof(CHECKPOINT_MAGIC)];
+  if(!stream.read(magic, sizeof(magic)) || std::memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) != 0) {
+    throw std::runtime_error("The stream does not hold an HRD checkpoint.");
+  }
+
+  if(read_varint(stream) != CHECKPOINT_VERSION) {
+    throw std::runtime_error("The version of the HRD checkpoint is not supported.");
+  }
+
+  std::vector<std::uint64_t> checkpoint_layers(static_cast<std::size_t>(read_varint(stream)));
+  for(auto &block_size : checkpoint_layers) {
+    block_size = read_varint(stream);
+  }
+
+  if(checkpoint_layers != layers) {
+    throw std::runtime_error("The checkpoint was written by a profile with different layers.");
+  }
+
+  m_time = read_varint(stream);
+  min_address = read_varint(stream);
+  max_address = read_varint(stream);
+
+  for(auto &histogram : ops_model) {
+    for(auto &count : histogram) {
+      count = read_varint(stream);
+    }
+  }
+
+  for(auto &histogram : reuse_model) {
+    histogram = read_histogram(stream);
+  }
+
+  m_states.clear();
+  auto const states = read_varint(stream);
+  m_states.reserve(static_cast<std::size_t>(states));
+  for(std::uint64_t i = 0; i < states; i++) {
+    auto const address = read_varint(stream);
+    auto const state = read_varint(stream);
+    if(state >= MEMORY_STATE_COUNT) {
+      throw std::runtime_error("The checkpoint holds an invalid memory state.");
+    }
+
+    m_states[address] = static_cast<memory_state>(state);
   }
 
+  m_sampler.restore(stream);
+
+  m_pending_addresses.clear();
+  m_pending_ops.clear();
+  auto const pending = read_varint(stream);
+  for(std::uint64_t i = 0; i < pending; i++) {
+    m_pending_addresses.push_back(read_varint(stream));
+
+    auto const op = read_varint(stream);
+    if(op >= OPERATION_COUNT) {
+      throw std::runtime_error("The checkpoint holds an invalid operation.");
+    }
+
+    m_pending_ops.push_back(static_cast<operation>(op));
+  }
+
+  if(m_pending_addresses.size() > m_time) {
+    throw std::runtime_error("The checkpoint buffers more requests than it has seen.");
+  }
+
+  restore_levels(stream, m_info, layers, m_time - m_pending_addresses.size());
+
+  // Without threads, requests are modelled as they arrive, so a buffer from a parallel profile must be modelled now.
+  if(m_threads <= 1) {
+    flush();
+  }
+}
+
+template <typename Tree>
+void basic_profile<Tree>::model_reuse(std::uint64_t address)
+{
+  access_levels(m_info, layers, address, m_time, m_distances);
+
   m_time++;
+
+  record_reuse(address, m_distances);
+}
+
+template <typename Tree>
+void basic_profile<Tree>::record_reuse(std::uint64_t address, std::vector<double> const &distances)
+{
+  constexpr double INF = std::numeric_limits<double>::infinity();
+
+  // Each sampled access stands for scale() accesses, and each sampled block for scale() blocks.
+  auto const scale = m_sampler.scale();
+
+  double distance = INF;
+
+  for(std::size_t layer = 0; layer < layers.size(); ++layer) {
+    auto layer_distance = distances[layer];
+    if(layer_distance != INF) {
+      layer_distance *= static_cast<double>(scale);
+    }
+
+    // Only update the histogram of the first layer to reuse a block.
+    if(distance == INF) {
+      reuse_model[layer].add(layer_distance, scale);
+      distance = layer_distance;
+    }
+  }
+
+  // A block of the largest level is seen for the first time, which may lower the sampling rate.
+  if(distance == INF && !layers.empty() && m_sampler.track(calculate_block(address, layers.back()))) {
+    evict_unsampled();
+  }
 }
 
-void profile::model_operation(std::uint64_t address, operation op)
+template <typename Tree>
+void basic_profile<Tree>::model_operation(std::uint64_t address, operation op)
 {
   auto &current_state = m_states[address];
 
   auto const state_index = static_cast<std::size_t>(current_state);
   auto const op_index = static_cast<std::size_t>(op);
-  ops_model[state_index][op_index]++;
+  ops_model[state_index][op_index] += m_sampler.scale();
 
   // Transition to appropriate state based on current state and the operation.
   if(current_state == memory_state::invalid && op == operation::read) {
@@ -79,15 +632,59 @@ void profile::model_operation(std::uint64_t address, operation op)
   }
 }
 
-std::size_t profile::unique_addresses() const
+template <typename Tree>
+void basic_profile<Tree>::evict_unsampled()
 {
-  return m_states.size();
+  auto const largest = layers.back();
+
+  for(std::size_t layer = 0; layer < layers.size(); ++layer) {
+    auto const block_size = layers[layer];
+
+    erase_level(m_info, layer, [this, block_size, largest](std::uint64_t block) {
+      return !m_sampler.sample(block * block_size / largest);
+    });
+  }
+
+  for(auto it = m_states.begin(); it != m_states.end();) {
+    if(m_sampler.sample(calculate_block(it->first, largest))) {
+      ++it;
+    } else {
+      it = m_states.erase(it);
+    }
+  }
 }
 
-std::uint64_t profile::count() const
+template <typename Tree>
+std::size_t basic_profile<Tree>::unique_addresses() const
+{
+  return m_states.size() * m_sampler.scale();
+}
+
+template <typename Tree>
+std::uint64_t basic_profile<Tree>::count() const
 {
   // The total number of requests modelled is equivalent to the logical time.
   return m_time;
 }
 
+template <typename Tree>
+reuse_distance::shards const &basic_profile<Tree>::sampler() const
+{
+  return m_sampler;
+}
+
+template <typename Tree>
+std::vector<Tree> const &basic_profile<Tree>::trees() const
+{
+  return m_info;
+}
+
+template class basic_profile<reuse_distance::olken_tree>;
+template class basic_profile<reuse_distance::compact_tree>;
+template class basic_profile<reuse_distance::approximate_tree>;
+template class basic_profile<reuse_distance::fenwick_tree>;
+template class basic_profile<reuse_distance::bplus_tree>;
+template class basic_profile<reuse_distance::multi_granularity<reuse_distance::bplus_tree>>;
+template class basic_profile<reuse_distance::reuse_time_tracker>;
+
 } // namespace hrd
\ No newline at end of file
@@ -0,0 +1,72 @@
+#include "hrd/reuse-histogram.hpp"
+
+#include <stdexcept>
+
+namespace hrd {
+
+constexpr unsigned reuse_histogram::DEFAULT_PRECISION;
+
+reuse_histogram::reuse_histogram(unsigned precision)
+    : m_precision(precision), m_exact(std::uint64_t{1} << precision)
+{
+  if(precision < 1 || precision > 24) {
+    throw std::invalid_argument("The precision of a reuse histogram must be in the range [1, 24].");
+  }
+}
+
+unsigned reuse_histogram::precision() const
+{
+  return m_precision;
+}
+
+void reuse_histogram::add_cold(std::uint64_t count)
+{
+  m_cold += count;
+}
+
+std::uint64_t reuse_histogram::cold() const
+{
+  return m_cold;
+}
+
+std::uint64_t reuse_histogram::total() const
+{
+  auto total = m_cold;
+  for(auto const count : m_counts) {
+    total += count;
+  }
+
+  return total;
+}
+
+bool reuse_histogram::empty() const
+{
+  return total() == 0;
+}
+
+std::vector<std::uint64_t> const &reuse_histogram::counts() const
+{
+  return m_counts;
+}
+
+double reuse_histogram::distance_of(std::size_t bin) const
+{
+  if(bin < m_exact) {
+    return static_cast<double>(bin);
+  }
+
+  // Invert bin_of(): each power of two above the exact bins holds m_exact / 2 bins.
+  auto const half = m_exact / 2;
+  auto const offset = static_cast<std::uint64_t>(bin) - m_exact;
+  auto const shift = offset / half + 1;
+  auto const lower = (offset % half + half) << shift;
+
+  return static_cast<double>(lower + (std::uint64_t{1} << shift) / 2);
+}
+
+void reuse_histogram::clear()
+{
+  m_counts.clear();
+  m_cold = 0;
+}
+} // namespace hrd
@@ -58,11 +58,7 @@ std::uint64_t read_history(synthesiser::info_t const &info, double distance)
   auto const offset = static_cast<std::size_t>(distance);
 
   if(offset < info.tree.size()) {
-    auto node = info.tree.most_recently_used();
-    for(std::size_t i = 0; i < offset; i++) {
-      node = info.tree.predecessor(node);
-    }
-    return node->address;
+    return info.tree.select_by_distance(offset)->address;
   }
 
   // The requested distance exceeded the stack size, return the least recently used block.
@@ -215,14 +211,20 @@ synthesiser::synthesiser(profile const &p)
   for(std::size_t i = 0; i < p.layers.size(); ++i) {
     m_layers[i].block_size = p.layers[i];
     m_layers[i].hist.distances.push_back(INF);
-    m_layers[i].hist.counts.push_back(p.reuse_model[i].at(INF));
-
-    for(auto const &pair : p.reuse_model[i]) {
-      if(pair.first != INF) {
-        m_layers[i].hist.distances.push_back(pair.first);
-        m_layers[i].hist.counts.push_back(pair.second);
+    m_layers[i].hist.counts.push_back(p.reuse_model[i].cold());
+
+    auto &hist = m_layers[i].hist;
+    double largest = 0.0;
+    p.reuse_model[i].for_each([&hist, &largest](double distance, std::uint64_t count) {
+      if(distance != INF) {
+        hist.distances.push_back(distance);
+        hist.counts.push_back(count);
+        largest = std::max(largest, distance);
       }
-    }
+    });
+
+    // No reuse reaches beyond the largest distance of the model, so older blocks never need to be tracked.
+    m_layers[i].info.tree = reuse_distance::olken_tree(static_cast<std::size_t>(largest) + 1, 0);
   }
 }
 
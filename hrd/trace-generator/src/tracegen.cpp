@@ -1,7 +1,5 @@
 #include "tracegen.hpp"
 
-#include <fstream>
-
 #include <ioproto/ofstream.hpp>
 #include <iogem5/packet-trace.hpp>
 #include <spdlog/spdlog.h>
@@ -14,14 +12,14 @@ static constexpr std::uint32_t GEM5_MAGIC_NUMBER = 0x356d6567;
 void generate_trace(std::string const &input_filename, std::string const &output_filename)
 {
   spdlog::get("log")->info("Loading statistical profile from: {}.", input_filename);
-  std::ifstream file_stream(input_filename);
-  ioproto::istream input(file_stream, GEM5_MAGIC_NUMBER);
+  ioproto::istream input(input_filename, GEM5_MAGIC_NUMBER);
 
   std::uint64_t request_count;
   auto profile = hrd::read(input, &request_count);
   spdlog::get("log")->info("Successfully loaded statistical profile ({} requests).", request_count);
 
-  iogem5::packet_trace_writer trace(output_filename);
+  // Compress the trace on another thread, while this one synthesises the requests.
+  iogem5::packet_trace_writer trace(output_filename, ioproto::write_mode::async);
   spdlog::get("log")->info("Synthetic trace will be written to {}.", output_filename);
 
   hrd::synthesiser synthesiser(profile);
@@ -55,6 +53,7 @@ void generate_trace(std::string const &input_filename, std::string const &output
     }
   }
 
+  trace.close();
   spdlog::get("log")->info("Successfully generated {} requests.", request_count);
 
 #ifdef HRD_VALIDATE_TRACE
@@ -67,10 +66,9 @@ void generate_trace(std::string const &input_filename, std::string const &output
   spdlog::get("log")->info("Profile Reuse Histograms");
   std::size_t layer = 0;
   for(auto const &hist : profile.reuse_model) {
-    for(auto const &pair : hist) {
-      spdlog::get("log")->info(
-          "Layer: {}, Distance: {}, Count: {}", layer, pair.first, pair.second);
-    }
+    hist.for_each([layer](double distance, std::uint64_t count) {
+      spdlog::get("log")->info("Layer: {}, Distance: {}, Count: {}", layer, distance, count);
+    });
 
     layer++;
   }
@@ -78,10 +76,9 @@ void generate_trace(std::string const &input_filename, std::string const &output
   spdlog::get("log")->info("Validator Reuse Histograms");
   layer = 0;
   for(auto const &hist : validator.reuse_model) {
-    for(auto const &pair : hist) {
-      spdlog::get("log")->info(
-          "Layer: {}, Distance: {}, Count: {}", layer, pair.first, pair.second);
-    }
+    hist.for_each([layer](double distance, std::uint64_t count) {
+      spdlog::get("log")->info("Layer: {}, Distance: {}, Count: {}", layer, distance, count);
+    });
 
     layer++;
   }
@@ -0,0 +1,184 @@
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+
+#include "argagg.hpp"
+
+#include <iogem5/packet-trace.hpp>
+
+argagg::parser create_command_line_interface()
+{
+  return {{{"help", {"-h", "--help"}, "Display help information.", 0},
+      {"input", {"-i", "--input"}, "gem5 packet trace to read.", 1},
+      {"generate", {"--generate"}, "Write a synthetic trace of this many packets to the input path before reading it.", 1},
+      {"write-mode", {"--write-mode"}, "How to write a synthetic trace: sync or async (default: sync).", 1},
+      {"method", {"--method"}, "How to read the trace: stream, mapped, async, or all (default: all).", 1},
+      {"seed", {"--seed"}, "Seed for the random number generator of a synthetic trace (default: 1).", 1}}};
+}
+
+void print_usage(std::ostream &stream, argagg::parser const &arguments)
+{
+  argagg::fmt_ostream help(stream);
+
+  help << "Measure the throughput of reading gem5 packet traces.\n\n";
+  help << "iogem5-bench [options] ARG [ARG...]\n\n";
+  help << arguments;
+}
+
+/**
+ * Measures the wall-clock time of a region of code.
+ */
+class stopwatch {
+public:
+  stopwatch() : m_start(std::chrono::steady_clock::now())
+  {
+  }
+
+  /**
+   * @return The seconds elapsed since construction.
+   */
+  double seconds() const
+  {
+    auto const elapsed = std::chrono::steady_clock::now() - m_start;
+
+    return std::chrono::duration<double>(elapsed).count();
+  }
+
+private:
+  std::chrono::steady_clock::time_point m_start;
+};
+
+/**
+ * Write a trace of reads and writes that mostly stay near the previous address, as a cache-filtered trace would.
+ * The trace is compressed if the filename ends in ".gz", ".zst" or ".lz4".
+ *
+ * @param mode How to write the trace: "sync" on this thread, or "async" on a background thread.
+ */
+void generate_trace(std::string const &filename, std::uint64_t packets, std::uint64_t seed, std::string const &mode)
+{
+  if(mode != "sync" && mode != "async") {
+    throw std::runtime_error("Unknown write mode: " + mode);
+  }
+
+  std::mt19937_64 rng(seed);
+  std::uniform_int_distribution<std::uint64_t> tick_step(1, 1000);
+  std::uniform_int_distribution<std::uint64_t> any_block(0, (std::uint64_t{1} << 30u) - 1);
+  std::uniform_int_distribution<std::int64_t> nearby(-64, 64);
+  std::bernoulli_distribution jump(0.1);
+  std::bernoulli_distribution write(0.3);
+
+  stopwatch timer;
+  iogem5::packet_trace_writer writer(
+      filename, mode == "async" ? ioproto::write_mode::async : ioproto::write_mode::sync);
+
+  std::uint64_t tick = 0;
+  std::uint64_t block = 0;
+  for(std::uint64_t i = 0; i < packets; i++) {
+    tick += tick_step(rng);
+    block = jump(rng) ? any_block(rng) : static_cast<std::uint64_t>(static_cast<std::int64_t>(block) + nearby(rng));
+
+    writer.write(tick, write(rng) ? 4 : 1, block * 64, 64);
+  }
+
+  writer.close();
+
+  auto const seconds = timer.seconds();
+
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << std::setw(8) << mode << ": wrote " << packets << " packets to " << filename << " in " << seconds << " s, "
+            << static_cast<double>(packets) / seconds / 1e6 << " M packets/s" << std::endl;
+}
+
+/**
+ * Read every packet of a trace, and report the packets read per second.
+ *
+ * @param filename The trace to read.
+ * @param method How to read the trace: "stream" through a std::ifstream, "mapped" by memory mapping the file, or "async"
+ * by memory mapping the file and decompressing it on a background thread.
+ */
+void read_trace(std::string const &filename, std::string const &method)
+{
+  std::ifstream input_file;
+  std::unique_ptr<iogem5::packet_trace_reader> reader;
+
+  stopwatch timer;
+  if(method == "stream") {
+    input_file.open(filename, std::ios::binary);
+    if(!input_file.good()) {
+      throw std::runtime_error("The file " + filename + " does not exist.");
+    }
+
+    reader = std::make_unique<iogem5::packet_trace_reader>(input_file);
+  } else if(method == "mapped") {
+    reader = std::make_unique<iogem5::packet_trace_reader>(filename);
+  } else if(method == "async") {
+    reader = std::make_unique<iogem5::packet_trace_reader>(filename, ioproto::read_mode::async);
+  } else {
+    throw std::runtime_error("Unknown method: " + method);
+  }
+
+  // Sum a field, so the packets cannot be optimised away.
+  std::uint64_t packets = 0;
+  std::uint64_t checksum = 0;
+
+  iogem5::packet packet{};
+  while(reader->read(&packet)) {
+    packets++;
+    checksum += packet.address;
+  }
+
+  auto const seconds = timer.seconds();
+
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << std::setw(8) << method << ": read " << packets << " packets in " << seconds << " s, "
+            << static_cast<double>(packets) / seconds / 1e6 << " M packets/s (checksum " << checksum << ")"
+            << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+  try {
+    // Parse the command line.
+    auto interface = create_command_line_interface();
+    auto const arguments = interface.parse(argc, argv);
+
+    // Check if help was requested.
+    if(arguments["help"]) {
+      print_usage(std::cout, interface);
+
+      return EXIT_SUCCESS;
+    }
+
+    if(arguments["input"].count() == 0) {
+      throw std::runtime_error("Missing path to gem5 packet trace.");
+    }
+
+    auto const filename = arguments["input"].as<std::string>();
+    if(arguments["generate"]) {
+      generate_trace(filename,
+          arguments["generate"].as<std::uint64_t>(),
+          arguments["seed"].as<std::uint64_t>(1),
+          arguments["write-mode"].as<std::string>("sync"));
+    }
+
+    auto const method = arguments["method"].as<std::string>("all");
+    if(method == "all") {
+      read_trace(filename, "stream");
+      read_trace(filename, "mapped");
+      read_trace(filename, "async");
+    } else {
+      read_trace(filename, method);
+    }
+  } catch(std::exception const &e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
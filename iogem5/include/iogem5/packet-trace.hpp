@@ -30,8 +30,21 @@ class packet_trace_reader {
 public:
   /**
    * Constructor.
+   *
+   * @param stream The stream to read the trace from.
+   * @param mode How to read the stream, see ioproto::read_mode.
    */
-  explicit packet_trace_reader(std::istream &stream);
+  explicit packet_trace_reader(std::istream &stream, ioproto::read_mode mode = ioproto::read_mode::sync);
+
+  /**
+   * Constructor, which memory maps the trace where supported.
+   *
+   * @param filename A path to the trace.
+   * @param mode How to read the trace, see ioproto::read_mode.
+   *
+   * @throw std::runtime_error if the trace cannot be opened.
+   */
+  explicit packet_trace_reader(std::string const &filename, ioproto::read_mode mode = ioproto::read_mode::sync);
 
   /**
    * Read a packet from the trace and populate p with the data.
@@ -57,6 +70,8 @@ private:
 
   std::uint64_t tick_frequency;
   std::string object_id;
+
+  void read_header();
 };
 
 /**
@@ -68,15 +83,21 @@ public:
    * Constructor.
    *
    * Opens a file for writing a gem5 packet trace.
+   *
+   * @param mode How to write the file, see ioproto::write_mode.
    */
-  packet_trace_writer(std::string const &file_name, std::uint64_t tick_freq);
+  packet_trace_writer(std::string const &file_name,
+      std::uint64_t tick_freq,
+      ioproto::write_mode mode = ioproto::write_mode::sync);
 
   /**
    * Constructor.
    *
    * Opens a file for writing a gem5 packet trace, using the default gem5 tick frequency.
+   *
+   * @param mode How to write the file, see ioproto::write_mode.
    */
-  explicit packet_trace_writer(std::string const &file_name);
+  explicit packet_trace_writer(std::string const &file_name, ioproto::write_mode mode = ioproto::write_mode::sync);
 
   /**
    * Write all the fields of a packet to the file.
@@ -97,6 +118,20 @@ public:
       std::uint32_t size,
       std::uint64_t pc);
 
+  /**
+   * Write every packet written so far to the file.
+   *
+   * @throw std::runtime_error if writing to the file failed.
+   */
+  void flush();
+
+  /**
+   * Finish writing the trace, and close the file.
+   *
+   * @throw std::runtime_error if writing to the file failed.
+   */
+  void close();
+
 private:
   ioproto::ofstream output_stream;
 };
@@ -10,8 +10,19 @@ namespace iogem5 {
 static constexpr std::uint32_t GEM5_MAGIC_NUMBER = 0x356d6567;
 static constexpr std::uint64_t GEM5_DEFAULT_TICK_FREQ = 1000000000000;
 
-packet_trace_reader::packet_trace_reader(std::istream &stream)
-    : input_stream(stream, GEM5_MAGIC_NUMBER)
+packet_trace_reader::packet_trace_reader(std::istream &stream, ioproto::read_mode mode)
+    : input_stream(stream, GEM5_MAGIC_NUMBER, mode)
+{
+  read_header();
+}
+
+packet_trace_reader::packet_trace_reader(std::string const &filename, ioproto::read_mode mode)
+    : input_stream(filename, GEM5_MAGIC_NUMBER, mode)
+{
+  read_header();
+}
+
+void packet_trace_reader::read_header()
 {
   ProtoMessage::PacketHeader header;
   if(!input_stream.read(&header)) {
@@ -62,8 +73,10 @@ std::string packet_trace_reader::get_object_id() const
   return object_id;
 }
 
-packet_trace_writer::packet_trace_writer(std::string const &file_name, std::uint64_t tick_freq)
-    : output_stream(file_name, GEM5_MAGIC_NUMBER)
+packet_trace_writer::packet_trace_writer(std::string const &file_name,
+    std::uint64_t tick_freq,
+    ioproto::write_mode mode)
+    : output_stream(file_name, GEM5_MAGIC_NUMBER, mode)
 {
   ProtoMessage::PacketHeader header;
   header.set_obj_id("iogem5");
@@ -72,8 +85,8 @@ packet_trace_writer::packet_trace_writer(std::string const &file_name, std::uint
   output_stream.write(header);
 }
 
-packet_trace_writer::packet_trace_writer(std::string const &file_name)
-    : packet_trace_writer(file_name, GEM5_DEFAULT_TICK_FREQ)
+packet_trace_writer::packet_trace_writer(std::string const &file_name, ioproto::write_mode mode)
+    : packet_trace_writer(file_name, GEM5_DEFAULT_TICK_FREQ, mode)
 {
 }
 
@@ -125,4 +138,14 @@ void packet_trace_writer::write(std::uint64_t tick,
   output_stream.write(proto_packet);
 }
 
+void packet_trace_writer::flush()
+{
+  output_stream.flush();
+}
+
+void packet_trace_writer::close()
+{
+  output_stream.close();
+}
+
 } // namespace iogem5
\ No newline at end of file
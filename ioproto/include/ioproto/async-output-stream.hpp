@@ -0,0 +1,111 @@
+#ifndef IOPROTO_ASYNC_OUTPUT_STREAM_HPP
+#define IOPROTO_ASYNC_OUTPUT_STREAM_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <google/protobuf/io/zero_copy_stream.h>
+
+namespace ioproto {
+
+/**
+ * A zero-copy output stream that writes to another stream on a background thread.
+ *
+ * The writer fills a ring of large buffers, which the thread drains into the sink stream. If the sink does real work,
+ * e.g. it compresses into a file, that work overlaps with whatever the writer does to produce the bytes, such as
+ * generating and serializing messages.
+ *
+ * The sink stream must not be used by anyone else, except after flush() has returned and before the next write.
+ */
+class async_output_stream : public google::protobuf::io::ZeroCopyOutputStream {
+public:
+  /** The default size of each buffer in bytes. */
+  static constexpr std::size_t DEFAULT_BUFFER_SIZE = std::size_t{1} << 20u;
+
+  /** The default number of buffers in the ring. */
+  static constexpr std::size_t DEFAULT_BUFFER_COUNT = 4;
+
+  /**
+   * Constructor, which starts the background thread.
+   *
+   * @param sink The stream to write to, which must outlive this stream.
+   * @param buffer_size The size of each buffer in bytes.
+   * @param buffer_count The number of buffers, which bounds how far the writer may run ahead of the thread.
+   *
+   * @throw std::invalid_argument if there are fewer than two buffers, or they are empty.
+   */
+  explicit async_output_stream(google::protobuf::io::ZeroCopyOutputStream *sink,
+      std::size_t buffer_size = DEFAULT_BUFFER_SIZE,
+      std::size_t buffer_count = DEFAULT_BUFFER_COUNT);
+
+  /**
+   * Destructor, which writes the remaining buffers to the sink, and stops the background thread.
+   */
+  ~async_output_stream() override;
+
+  async_output_stream(async_output_stream const &) = delete;
+  async_output_stream &operator=(async_output_stream const &) = delete;
+
+  /**
+   * Wait until every byte written so far has been written to the sink.
+   *
+   * @return false if the sink failed.
+   *
+   * @throw Any exception thrown by the sink stream on the background thread.
+   */
+  bool flush();
+
+  /**
+   * @return false if the sink failed.
+   *
+   * @throw Any exception thrown by the sink stream on the background thread.
+   */
+  bool Next(void **data, int *size) override;
+
+  void BackUp(int count) override;
+
+  std::int64_t ByteCount() const override;
+
+private:
+  struct buffer {
+    std::vector<char> data;
+    // The number of bytes of data that were written by the writer.
+    std::size_t size = 0;
+  };
+
+  google::protobuf::io::ZeroCopyOutputStream *m_sink;
+
+  std::vector<buffer> m_buffers;
+
+  // Guards the fields below, which are shared with the background thread.
+  std::mutex m_mutex;
+  // Signalled when a buffer has been filled, or the stream is being destroyed.
+  std::condition_variable m_filled;
+  // Signalled when a buffer has been drained into the sink.
+  std::condition_variable m_drained;
+  // The number of buffers that have been filled, and drained.
+  std::uint64_t m_fill_count = 0;
+  std::uint64_t m_drain_count = 0;
+  bool m_failed = false;
+  bool m_stopping = false;
+  std::exception_ptr m_error;
+
+  // The buffer being written, i.e. the last one returned by Next(), if any.
+  buffer *m_current = nullptr;
+  std::int64_t m_byte_count = 0;
+
+  // Declared last so everything it uses is initialised before it starts.
+  std::thread m_thread;
+
+  void drain();
+  bool write(buffer const &source);
+  void submit_current();
+};
+} // namespace ioproto
+
+#endif //IOPROTO_ASYNC_OUTPUT_STREAM_HPP
@@ -0,0 +1,103 @@
+#ifndef IOPROTO_COMPRESSION_HPP
+#define IOPROTO_COMPRESSION_HPP
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include <google/protobuf/io/zero_copy_stream.h>
+
+namespace ioproto {
+
+/**
+ * The compression formats of protobuf files.
+ *
+ * gzip is always available. zstd and lz4 (frame format) are available if their libraries were found when the project
+ * was configured, see is_available().
+ */
+enum class compression { none, gzip, zstd, lz4 };
+
+/**
+ * The number of leading bytes detect_compression() needs to recognise every format.
+ */
+constexpr std::size_t COMPRESSION_MAGIC_SIZE = 4;
+
+/**
+ * Recognise a compression format by the magic number at the start of a file.
+ *
+ * @param header The first bytes of the file.
+ * @param size The number of bytes in header, which may be fewer than COMPRESSION_MAGIC_SIZE for a short file.
+ *
+ * @return The compression format, or compression::none if the file is not compressed.
+ */
+compression detect_compression(unsigned char const *header, std::size_t size);
+
+/**
+ * Choose the compression format of a file by its extension: ".gz", ".zst" or ".lz4".
+ *
+ * @param filename A path to the file.
+ *
+ * @return The compression format, or compression::none for any other extension.
+ */
+compression compression_for(std::string const &filename);
+
+/**
+ * @param format A compression format.
+ *
+ * @return true if files of the format can be read and written.
+ */
+bool is_available(compression format);
+
+/**
+ * Decompress a stream.
+ *
+ * @param format The compression format of the stream, which must not be compression::none.
+ * @param input The compressed stream, which must outlive the returned stream.
+ *
+ * @return The decompressed stream.
+ *
+ * @throw std::runtime_error if the format is not available.
+ */
+std::unique_ptr<google::protobuf::io::ZeroCopyInputStream> decompress(compression format,
+    google::protobuf::io::ZeroCopyInputStream *input);
+
+/**
+ * A stream that compresses the bytes written to it into another stream.
+ *
+ * The compressed stream is finished by close(), or when this stream is destroyed.
+ */
+class compressed_output_stream : public google::protobuf::io::ZeroCopyOutputStream {
+public:
+  /**
+   * Compress and write every byte written so far, ending the current block of the compressed stream.
+   *
+   * @return false if the output stream failed.
+   */
+  virtual bool flush() = 0;
+
+  /**
+   * Finish the compressed stream. Nothing may be written afterwards.
+   *
+   * @return false if the output stream failed.
+   */
+  virtual bool close() = 0;
+};
+
+/**
+ * Compress into a stream.
+ *
+ * zstd compresses at level 3 on as many threads as the hardware supports, and lz4 at its default level.
+ *
+ * @param format The compression format of the stream, which must not be compression::none.
+ * @param output The stream to write the compressed bytes to, which must outlive the returned stream.
+ *
+ * @return The stream to write uncompressed bytes to.
+ *
+ * @throw std::runtime_error if the format is not available.
+ */
+std::unique_ptr<compressed_output_stream> compress(compression format,
+    google::protobuf::io::ZeroCopyOutputStream *output);
+
+} // namespace ioproto
+
+#endif //IOPROTO_COMPRESSION_HPP
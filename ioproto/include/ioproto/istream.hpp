@@ -4,15 +4,39 @@
 #include <cstdint>
 #include <iosfwd>
 #include <memory>
+#include <string>
 
 #include <google/protobuf/message.h>
-#include <google/protobuf/io/gzip_stream.h>
+#include <google/protobuf/io/coded_stream.h>
 #include <google/protobuf/io/zero_copy_stream.h>
 
+#include <ioproto/compression.hpp>
+
 namespace ioproto {
 
 /**
- * Read size-delimited protobuf messages from an input stream.
+ * How an istream reads its input.
+ */
+enum class read_mode {
+  /** Decompress on the thread that reads the messages. */
+  sync,
+  /**
+   * Decompress ahead on a background thread (see prefetch_input_stream), so decompression overlaps with whatever the
+   * caller does between reads. Only compressed input is read ahead, as copying an uncompressed (e.g., memory mapped)
+   * file would cost more than it saves.
+   */
+  async
+};
+
+/**
+ * Read size-delimited protobuf messages from an input stream or a file, either of which may be compressed with gzip,
+ * zstd or lz4 (see compression), which is detected by its magic number.
+ *
+ * A file is memory mapped where supported (see mapped_input_stream), so an uncompressed file is parsed straight from
+ * the page cache rather than copied through an iostream buffer.
+ *
+ * A single coded stream is kept across reads, as constructing one costs more than parsing a small message. Protobuf
+ * limits the total number of bytes a coded stream may read, so it is replaced after every RESET_BYTES bytes.
  */
 class istream {
 public:
@@ -20,18 +44,41 @@ public:
    * Constructor.
    *
    * @param stream The input stream to read from.
+   * @param mode How to read the input stream.
    */
-  explicit istream(std::istream &stream);
+  explicit istream(std::istream &stream, read_mode mode = read_mode::sync);
 
   /**
    * Constructor.
    *
    * @param stream The input stream to read from.
    * @param magic_number The expected magic number.
+   * @param mode How to read the input stream.
    *
    * @throw std::runtime_error if the expected magic number was not found.
    */
-  istream(std::istream &stream, std::uint32_t magic_number);
+  istream(std::istream &stream, std::uint32_t magic_number, read_mode mode = read_mode::sync);
+
+  /**
+   * Constructor.
+   *
+   * @param filename A path to the file to read from.
+   * @param mode How to read the file.
+   *
+   * @throw std::runtime_error if the file cannot be opened.
+   */
+  explicit istream(std::string const &filename, read_mode mode = read_mode::sync);
+
+  /**
+   * Constructor.
+   *
+   * @param filename A path to the file to read from.
+   * @param magic_number The expected magic number.
+   * @param mode How to read the file.
+   *
+   * @throw std::runtime_error if the file cannot be opened, or the expected magic number was not found.
+   */
+  istream(std::string const &filename, std::uint32_t magic_number, read_mode mode = read_mode::sync);
 
   /**
    * Read a message from the input stream.
@@ -44,11 +91,24 @@ public:
    */
   bool read(google::protobuf::Message *message);
 
+  /** The number of bytes read through one coded stream before it is replaced. */
+  static constexpr int RESET_BYTES = 1 << 24;
+
 private:
+  // The file being read, if it is not memory mapped.
+  std::unique_ptr<std::istream> file_stream;
+
   std::unique_ptr<google::protobuf::io::ZeroCopyInputStream> parent_stream;
-  std::unique_ptr<google::protobuf::io::GzipInputStream> gzip_stream;
+  std::unique_ptr<google::protobuf::io::ZeroCopyInputStream> decompressed_stream;
+  std::unique_ptr<google::protobuf::io::ZeroCopyInputStream> prefetch_stream;
 
   google::protobuf::io::ZeroCopyInputStream *input_stream;
+
+  // Declared last so it is destroyed first, returning the bytes it has buffered but not read to the input stream.
+  std::unique_ptr<google::protobuf::io::CodedInputStream> coded_stream;
+
+  void open(compression format, read_mode mode);
+  void check_magic_number(std::uint32_t magic_number);
 };
 
 } // namespace ioproto
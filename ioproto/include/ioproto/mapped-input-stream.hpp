@@ -0,0 +1,65 @@
+#ifndef IOPROTO_MAPPED_INPUT_STREAM_HPP
+#define IOPROTO_MAPPED_INPUT_STREAM_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <google/protobuf/io/zero_copy_stream.h>
+
+namespace ioproto {
+
+/**
+ * A zero-copy input stream over a memory-mapped file.
+ *
+ * The file is mapped read-only and the kernel is advised that it will be read sequentially (and, where supported, that
+ * it may be backed by huge pages), so pages are read ahead and parsing reads the page cache directly instead of copying
+ * it through an iostream buffer. Only available on POSIX systems, see is_supported().
+ */
+class mapped_input_stream : public google::protobuf::io::ZeroCopyInputStream {
+public:
+  /**
+   * Constructor.
+   *
+   * @param filename A path to the file to map.
+   *
+   * @throw std::runtime_error if the file cannot be opened or mapped.
+   */
+  explicit mapped_input_stream(std::string const &filename);
+
+  ~mapped_input_stream() override;
+
+  mapped_input_stream(mapped_input_stream const &) = delete;
+  mapped_input_stream &operator=(mapped_input_stream const &) = delete;
+
+  /**
+   * @return true if files can be memory mapped on this platform.
+   */
+  static bool is_supported();
+
+  /**
+   * @return The mapped bytes of the file.
+   */
+  std::uint8_t const *data() const;
+
+  /**
+   * @return The size of the file in bytes.
+   */
+  std::size_t size() const;
+
+  bool Next(void const **data, int *size) override;
+
+  void BackUp(int count) override;
+
+  bool Skip(int count) override;
+
+  std::int64_t ByteCount() const override;
+
+private:
+  std::uint8_t const *m_data = nullptr;
+  std::size_t m_size = 0;
+  std::size_t m_position = 0;
+};
+} // namespace ioproto
+
+#endif //IOPROTO_MAPPED_INPUT_STREAM_HPP
@@ -1,18 +1,40 @@
 #ifndef IOPROTO_OSTREAM_HPP
 #define IOPROTO_OSTREAM_HPP
 
+#include <cstdint>
 #include <fstream>
 #include <memory>
+#include <string>
 
 #include <google/protobuf/message.h>
-#include <google/protobuf/io/gzip_stream.h>
 #include <google/protobuf/io/zero_copy_stream.h>
 #include <google/protobuf/io/zero_copy_stream_impl.h>
 
+#include <ioproto/async-output-stream.hpp>
+#include <ioproto/compression.hpp>
+
 namespace ioproto {
 
+/**
+ * How an ofstream writes its output.
+ */
+enum class write_mode {
+  /** Compress and write on the thread that writes the messages. */
+  sync,
+  /**
+   * Compress and write on a background thread (see async_output_stream), so compression overlaps with whatever the
+   * caller does between writes. Errors are reported by a later write(), flush() or close().
+   */
+  async
+};
+
 /**
  * Write size-delimited protobuf messages to a file.
+ *
+ * The file is compressed if its extension is ".gz" (gzip), ".zst" (zstd) or ".lz4" (lz4), see compression.
+ *
+ * The file is closed on destruction, which cannot report errors, so call close() to find out whether every message
+ * was written.
  */
 class ofstream {
 public:
@@ -20,8 +42,11 @@ public:
    * Constructor.
    *
    * @param file_name A path to the output file.
+   * @param mode How to write the file.
+   *
+   * @throw std::runtime_error if the file cannot be opened.
    */
-  explicit ofstream(std::string const &file_name);
+  explicit ofstream(std::string const &file_name, write_mode mode = write_mode::sync);
 
   /**
    * Recommended constructor.
@@ -30,22 +55,53 @@ public:
    *
    * @param file_name A path to the output file.
    * @param magic_number The number to write.
+   * @param mode How to write the file.
+   *
+   * @throw std::runtime_error if the file cannot be opened.
    */
-  ofstream(std::string const &file_name, std::uint32_t magic_number);
+  ofstream(std::string const &file_name, std::uint32_t magic_number, write_mode mode = write_mode::sync);
+
+  /**
+   * Destructor, which closes the file if close() was not called, ignoring any errors.
+   */
+  ~ofstream();
+
+  ofstream(ofstream const &) = delete;
+  ofstream &operator=(ofstream const &) = delete;
 
   /**
    * Write a protobuf message to the file.
    *
    * @param message The message to serialize.
+   *
+   * @throw std::runtime_error if the file is closed, or writing to it failed.
    */
   void write(google::protobuf::Message const &message);
 
+  /**
+   * Write every message written so far to the file, ending the current block of a compressed file.
+   *
+   * @throw std::runtime_error if the file is closed, or writing to it failed.
+   */
+  void flush();
+
+  /**
+   * Finish writing the file, and close it. Nothing may be written afterwards.
+   *
+   * @throw std::runtime_error if the file is already closed, or writing to it failed.
+   */
+  void close();
+
 private:
+  std::string filename;
   std::ofstream standard_stream;
 
-  std::unique_ptr<google::protobuf::io::OstreamOutputStream> wrapped_fstream = nullptr;
-  std::unique_ptr<google::protobuf::io::GzipOutputStream> gzip_stream = nullptr;
+  std::unique_ptr<google::protobuf::io::CopyingOutputStreamAdaptor> wrapped_fstream = nullptr;
+  std::unique_ptr<compressed_output_stream> compressed_stream = nullptr;
+  std::unique_ptr<async_output_stream> async_stream = nullptr;
   google::protobuf::io::ZeroCopyOutputStream *output_stream = nullptr;
+
+  void check_open() const;
 };
 } // namespace ioproto
 
@@ -0,0 +1,102 @@
+#ifndef IOPROTO_PREFETCH_INPUT_STREAM_HPP
+#define IOPROTO_PREFETCH_INPUT_STREAM_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <google/protobuf/io/zero_copy_stream.h>
+
+namespace ioproto {
+
+/**
+ * A zero-copy input stream that reads another stream ahead on a background thread.
+ *
+ * The thread copies the source stream into a ring of large buffers, which the reader drains. If the source does real
+ * work, e.g. it decompresses a file, that work overlaps with whatever the reader does with the bytes, such as parsing
+ * the messages and updating a model with them.
+ *
+ * The source stream must not be used by anyone else until this stream is destroyed.
+ */
+class prefetch_input_stream : public google::protobuf::io::ZeroCopyInputStream {
+public:
+  /** The default size of each buffer in bytes. */
+  static constexpr std::size_t DEFAULT_BUFFER_SIZE = std::size_t{1} << 20u;
+
+  /** The default number of buffers in the ring. */
+  static constexpr std::size_t DEFAULT_BUFFER_COUNT = 4;
+
+  /**
+   * Constructor, which starts the background thread.
+   *
+   * @param source The stream to read ahead, which must outlive this stream.
+   * @param buffer_size The size of each buffer in bytes.
+   * @param buffer_count The number of buffers, which bounds how far the thread reads ahead.
+   *
+   * @throw std::invalid_argument if there are fewer than two buffers, or they are empty.
+   */
+  explicit prefetch_input_stream(google::protobuf::io::ZeroCopyInputStream *source,
+      std::size_t buffer_size = DEFAULT_BUFFER_SIZE,
+      std::size_t buffer_count = DEFAULT_BUFFER_COUNT);
+
+  /**
+   * Destructor, which stops the background thread, even if the source was not read to the end.
+   */
+  ~prefetch_input_stream() override;
+
+  prefetch_input_stream(prefetch_input_stream const &) = delete;
+  prefetch_input_stream &operator=(prefetch_input_stream const &) = delete;
+
+  /**
+   * @throw Any exception thrown by the source stream on the background thread.
+   */
+  bool Next(void const **data, int *size) override;
+
+  void BackUp(int count) override;
+
+  bool Skip(int count) override;
+
+  std::int64_t ByteCount() const override;
+
+private:
+  struct buffer {
+    std::vector<char> data;
+    // The number of bytes of data that were read from the source.
+    std::size_t size = 0;
+  };
+
+  google::protobuf::io::ZeroCopyInputStream *m_source;
+
+  std::vector<buffer> m_buffers;
+
+  // Guards the fields below, which are shared with the background thread.
+  std::mutex m_mutex;
+  // Signalled when a buffer has been filled, or the source has ended.
+  std::condition_variable m_filled;
+  // Signalled when a buffer has been drained, or the stream is being destroyed.
+  std::condition_variable m_drained;
+  // The number of buffers that have been filled, and drained.
+  std::uint64_t m_fill_count = 0;
+  std::uint64_t m_drain_count = 0;
+  bool m_source_ended = false;
+  bool m_stopping = false;
+  std::exception_ptr m_error;
+
+  // The buffer being read, i.e. the last one returned by Next(), if any.
+  buffer *m_current = nullptr;
+  std::size_t m_position = 0;
+  std::int64_t m_byte_count = 0;
+
+  // Declared last so everything it uses is initialised before it starts.
+  std::thread m_thread;
+
+  void prefetch();
+  void release_current();
+};
+} // namespace ioproto
+
+#endif //IOPROTO_PREFETCH_INPUT_STREAM_HPP
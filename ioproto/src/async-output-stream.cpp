@@ -0,0 +1,195 @@
+#include "ioproto/async-output-stream.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace ioproto {
+
+constexpr std::size_t async_output_stream::DEFAULT_BUFFER_SIZE;
+constexpr std::size_t async_output_stream::DEFAULT_BUFFER_COUNT;
+
+async_output_stream::async_output_stream(google::protobuf::io::ZeroCopyOutputStream *sink,
+    std::size_t buffer_size,
+    std::size_t buffer_count)
+    : m_sink(sink)
+{
+  if(buffer_count < 2) {
+    throw std::invalid_argument("An asynchronous stream needs at least two buffers.");
+  }
+
+  // Next() reports the size of a buffer as an int.
+  if(buffer_size == 0 || buffer_size > static_cast<std::size_t>(std::numeric_limits<int>::max())) {
+    throw std::invalid_argument("The buffers of an asynchronous stream must hold between 1 byte and 2 GiB.");
+  }
+
+  m_buffers.resize(buffer_count);
+  for(auto &buffer : m_buffers) {
+    buffer.data.resize(buffer_size);
+  }
+
+  m_thread = std::thread(&async_output_stream::drain, this);
+}
+
+async_output_stream::~async_output_stream()
+{
+  submit_current();
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopping = true;
+  }
+
+  // The thread drains the filled buffers before it stops.
+  m_filled.notify_all();
+  m_thread.join();
+}
+
+void async_output_stream::drain()
+{
+  for(;;) {
+    buffer const *source;
+    bool written;
+    {
+      // Wait for a filled buffer.
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_filled.wait(lock, [this]() { return m_fill_count > m_drain_count || m_stopping; });
+      if(m_fill_count == m_drain_count) {
+        return;
+      }
+
+      source = &m_buffers[m_drain_count % m_buffers.size()];
+
+      // Once the sink has failed, the remaining buffers are dropped.
+      written = !m_failed;
+    }
+
+    // Write the buffer without holding the lock, so the writer can fill the others meanwhile.
+    if(written) {
+      try {
+        written = write(*source);
+      } catch(...) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_error = std::current_exception();
+        written = false;
+      }
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_failed = m_failed || !written;
+      m_drain_count++;
+    }
+
+    m_drained.notify_all();
+  }
+}
+
+bool async_output_stream::write(buffer const &source)
+{
+  std::size_t position = 0;
+  while(position < source.size) {
+    void *data = nullptr;
+    int available = 0;
+    if(!m_sink->Next(&data, &available)) {
+      return false;
+    }
+
+    auto const chunk = static_cast<std::size_t>(available);
+    auto const copied = std::min(chunk, source.size - position);
+    std::copy_n(source.data.data() + position, copied, static_cast<char *>(data));
+    position += copied;
+
+    if(copied < chunk) {
+      m_sink->BackUp(static_cast<int>(chunk - copied));
+    }
+  }
+
+  return true;
+}
+
+void async_output_stream::submit_current()
+{
+  if(m_current == nullptr) {
+    return;
+  }
+
+  // An empty buffer is not submitted, so it is handed out again by the next call to Next().
+  auto const filled = m_current->size > 0;
+  m_current = nullptr;
+
+  if(filled) {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_fill_count++;
+    }
+
+    m_filled.notify_one();
+  }
+}
+
+bool async_output_stream::flush()
+{
+  submit_current();
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_drained.wait(lock, [this]() { return m_drain_count == m_fill_count; });
+  if(m_error) {
+    std::rethrow_exception(m_error);
+  }
+
+  return !m_failed;
+}
+
+bool async_output_stream::Next(void **data, int *size)
+{
+  // Hand out the rest of the current buffer first, as writers (e.g., a coded stream per message) often back up most of
+  // what they were given.
+  if(m_current != nullptr && m_current->size < m_current->data.size()) {
+    auto const available = m_current->data.size() - m_current->size;
+
+    *data = m_current->data.data() + m_current->size;
+    *size = static_cast<int>(available);
+    m_current->size = m_current->data.size();
+    m_byte_count += static_cast<std::int64_t>(available);
+
+    return true;
+  }
+
+  submit_current();
+
+  {
+    // Wait for a drained buffer.
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_drained.wait(lock, [this]() { return m_fill_count - m_drain_count < m_buffers.size(); });
+    if(m_error) {
+      std::rethrow_exception(m_error);
+    }
+
+    if(m_failed) {
+      return false;
+    }
+
+    m_current = &m_buffers[m_fill_count % m_buffers.size()];
+  }
+
+  m_current->size = m_current->data.size();
+
+  *data = m_current->data.data();
+  *size = static_cast<int>(m_current->size);
+  m_byte_count += static_cast<std::int64_t>(m_current->size);
+
+  return true;
+}
+
+void async_output_stream::BackUp(int count)
+{
+  m_current->size -= static_cast<std::size_t>(count);
+  m_byte_count -= count;
+}
+
+std::int64_t async_output_stream::ByteCount() const
+{
+  return m_byte_count;
+}
+} // namespace ioproto
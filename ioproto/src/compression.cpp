@@ -0,0 +1,652 @@
+#include "ioproto/compression.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <google/protobuf/io/gzip_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+
+#ifdef IOPROTO_HAS_ZSTD
+#include <zstd.h>
+#endif
+
+#ifdef IOPROTO_HAS_LZ4
+#include <lz4frame.h>
+#endif
+
+namespace ioproto {
+
+using google::protobuf::io::CopyingInputStream;
+using google::protobuf::io::CopyingInputStreamAdaptor;
+using google::protobuf::io::CopyingOutputStream;
+using google::protobuf::io::CopyingOutputStreamAdaptor;
+using google::protobuf::io::GzipInputStream;
+using google::protobuf::io::GzipOutputStream;
+using google::protobuf::io::ZeroCopyInputStream;
+using google::protobuf::io::ZeroCopyOutputStream;
+
+// The size of the buffers of uncompressed bytes, which matches the default block size of lz4.
+constexpr int BUFFER_SIZE = 1 << 16;
+
+// The compression level of zstd, which is its default.
+constexpr int ZSTD_LEVEL = 3;
+
+compression detect_compression(unsigned char const *header, std::size_t size)
+{
+  auto const starts_with = [header, size](std::initializer_list<unsigned char> magic) {
+    return size >= magic.size() && std::equal(magic.begin(), magic.end(), header);
+  };
+
+  if(starts_with({0x1f, 0x8b})) {
+    return compression::gzip;
+  }
+
+  if(starts_with({0x28, 0xb5, 0x2f, 0xfd})) {
+    return compression::zstd;
+  }
+
+  if(starts_with({0x04, 0x22, 0x4d, 0x18})) {
+    return compression::lz4;
+  }
+
+  return compression::none;
+}
+
+compression compression_for(std::string const &filename)
+{
+  auto const extension = filename.find_last_of('.');
+  if(extension == std::string::npos) {
+    return compression::none;
+  }
+
+  auto const suffix = filename.substr(extension + 1);
+  if(suffix == "gz") {
+    return compression::gzip;
+  }
+
+  if(suffix == "zst") {
+    return compression::zstd;
+  }
+
+  if(suffix == "lz4") {
+    return compression::lz4;
+  }
+
+  return compression::none;
+}
+
+bool is_available(compression format)
+{
+  switch(format) {
+  case compression::none:
+  case compression::gzip:
+    return true;
+  case compression::zstd:
+#ifdef IOPROTO_HAS_ZSTD
+    return true;
+#else
+    return false;
+#endif
+  case compression::lz4:
+#ifdef IOPROTO_HAS_LZ4
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  return false;
+}
+
+/**
+ * Reads compressed bytes from a zero-copy stream without copying them, for the decompressors below.
+ */
+class compressed_input {
+public:
+  explicit compressed_input(ZeroCopyInputStream *input) : m_input(input)
+  {
+  }
+
+  ~compressed_input()
+  {
+    // Return the bytes that were not decompressed, so the stream is left after the compressed data.
+    if(m_position < m_size) {
+      m_input->BackUp(static_cast<int>(m_size - m_position));
+    }
+  }
+
+  compressed_input(compressed_input const &) = delete;
+  compressed_input &operator=(compressed_input const &) = delete;
+
+  /**
+   * @return true if there are compressed bytes left, after reading more from the stream if needed.
+   */
+  bool fill()
+  {
+    while(m_position == m_size) {
+      void const *data = nullptr;
+      int size = 0;
+      if(!m_input->Next(&data, &size)) {
+        return false;
+      }
+
+      m_data = static_cast<std::uint8_t const *>(data);
+      m_size = static_cast<std::size_t>(size);
+      m_position = 0;
+    }
+
+    return true;
+  }
+
+  bool empty() const
+  {
+    return m_position == m_size;
+  }
+
+  std::uint8_t const *m_data = nullptr;
+  std::size_t m_size = 0;
+  std::size_t m_position = 0;
+
+private:
+  ZeroCopyInputStream *m_input;
+};
+
+/**
+ * Writes compressed bytes straight into the buffers of a zero-copy stream, for the compressors below.
+ */
+class compressed_output {
+public:
+  explicit compressed_output(ZeroCopyOutputStream *output) : m_output(output)
+  {
+  }
+
+  /**
+   * Get a buffer to compress into, which must be returned by commit().
+   *
+   * @return false if the stream failed.
+   */
+  bool next(void **data, std::size_t *size)
+  {
+    int available = 0;
+    if(!m_output->Next(data, &available)) {
+      return false;
+    }
+
+    *size = static_cast<std::size_t>(available);
+    m_available = available;
+
+    return true;
+  }
+
+  /**
+   * Return the buffer of the last call to next().
+   *
+   * @param used The number of bytes that were written to the buffer.
+   */
+  void commit(std::size_t used)
+  {
+    m_output->BackUp(m_available - static_cast<int>(used));
+  }
+
+  /**
+   * Copy bytes into the stream.
+   *
+   * @return false if the stream failed.
+   */
+  bool write(char const *data, std::size_t size)
+  {
+    while(size > 0) {
+      void *buffer = nullptr;
+      std::size_t available = 0;
+      if(!next(&buffer, &available)) {
+        return false;
+      }
+
+      auto const copied = std::min(size, available);
+      std::copy(data, data + copied, static_cast<char *>(buffer));
+      commit(copied);
+
+      data += copied;
+      size -= copied;
+    }
+
+    return true;
+  }
+
+private:
+  ZeroCopyOutputStream *m_output;
+  int m_available = 0;
+};
+
+#ifdef IOPROTO_HAS_ZSTD
+/**
+ * Decompresses a stream of (possibly concatenated) zstd frames.
+ */
+class zstd_input_stream : public CopyingInputStream {
+public:
+  explicit zstd_input_stream(ZeroCopyInputStream *input) : m_input(input), m_context(ZSTD_createDCtx())
+  {
+    if(m_context == nullptr) {
+      throw std::runtime_error("Could not create a zstd decompression context.");
+    }
+  }
+
+  ~zstd_input_stream() override
+  {
+    ZSTD_freeDCtx(m_context);
+  }
+
+  int Read(void *buffer, int size) override
+  {
+    ZSTD_outBuffer output{buffer, static_cast<std::size_t>(size), 0};
+
+    while(output.pos == 0) {
+      if(m_input.empty() && !m_pending && !m_input.fill()) {
+        return m_remaining == 0 ? 0 : -1; // EOF, or a truncated frame.
+      }
+
+      ZSTD_inBuffer input{m_input.m_data, m_input.m_size, m_input.m_position};
+      m_remaining = ZSTD_decompressStream(m_context, &output, &input);
+      m_input.m_position = input.pos;
+
+      if(ZSTD_isError(m_remaining) != 0) {
+        return -1;
+      }
+
+      m_pending = output.pos == output.size && m_remaining != 0;
+    }
+
+    return static_cast<int>(output.pos);
+  }
+
+private:
+  compressed_input m_input;
+  ZSTD_DCtx *m_context;
+
+  // The hint of zstd for the bytes left in the current frame, which is zero between frames.
+  std::size_t m_remaining = 0;
+  // Whether decompressed bytes may be left in the context, because they did not fit into the last buffer.
+  bool m_pending = false;
+};
+
+/**
+ * Compresses into a single zstd frame, which is finished by finish() or on destruction.
+ */
+class zstd_output_stream : public CopyingOutputStream {
+public:
+  explicit zstd_output_stream(ZeroCopyOutputStream *output) : m_output(output), m_context(ZSTD_createCCtx())
+  {
+    if(m_context == nullptr) {
+      throw std::runtime_error("Could not create a zstd compression context.");
+    }
+
+    ZSTD_CCtx_setParameter(m_context, ZSTD_c_compressionLevel, ZSTD_LEVEL);
+
+    // Compress on worker threads, which fails harmlessly (compressing on this thread instead) if the library was built
+    // without support for them.
+    ZSTD_CCtx_setParameter(m_context, ZSTD_c_nbWorkers, static_cast<int>(std::thread::hardware_concurrency()));
+  }
+
+  ~zstd_output_stream() override
+  {
+    if(!m_finished) {
+      finish();
+    }
+
+    ZSTD_freeCCtx(m_context);
+  }
+
+  bool Write(void const *buffer, int size) override
+  {
+    ZSTD_inBuffer input{buffer, static_cast<std::size_t>(size), 0};
+    while(input.pos < input.size) {
+      if(ZSTD_isError(compress(&input, ZSTD_e_continue)) != 0) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  /**
+   * Write all the bytes compressed so far, ending the current block.
+   */
+  bool flush()
+  {
+    return drain(ZSTD_e_flush);
+  }
+
+  /**
+   * End the frame.
+   */
+  bool finish()
+  {
+    m_finished = true;
+
+    return drain(ZSTD_e_end);
+  }
+
+private:
+  compressed_output m_output;
+  ZSTD_CCtx *m_context;
+  bool m_finished = false;
+
+  /**
+   * Compress what is left in the context, until zstd reports that it has all been written.
+   */
+  bool drain(ZSTD_EndDirective directive)
+  {
+    ZSTD_inBuffer input{nullptr, 0, 0};
+    std::size_t remaining;
+    do {
+      remaining = compress(&input, directive);
+    } while(remaining != 0 && ZSTD_isError(remaining) == 0);
+
+    return remaining == 0;
+  }
+
+  /**
+   * Compress some of the input into the next buffer of the output.
+   *
+   * @return The result of ZSTD_compressStream2(), or an error if the output failed.
+   */
+  std::size_t compress(ZSTD_inBuffer *input, ZSTD_EndDirective directive)
+  {
+    void *data = nullptr;
+    std::size_t size = 0;
+    if(!m_output.next(&data, &size)) {
+      return static_cast<std::size_t>(-1); // Any value that ZSTD_isError() reports as an error.
+    }
+
+    ZSTD_outBuffer output{data, size, 0};
+    auto const result = ZSTD_compressStream2(m_context, &output, input, directive);
+    m_output.commit(output.pos);
+
+    return result;
+  }
+};
+#endif
+
+#ifdef IOPROTO_HAS_LZ4
+/**
+ * Decompresses a stream of (possibly concatenated) lz4 frames.
+ */
+class lz4_input_stream : public CopyingInputStream {
+public:
+  explicit lz4_input_stream(ZeroCopyInputStream *input) : m_input(input)
+  {
+    if(LZ4F_isError(LZ4F_createDecompressionContext(&m_context, LZ4F_VERSION)) != 0) {
+      throw std::runtime_error("Could not create an lz4 decompression context.");
+    }
+  }
+
+  ~lz4_input_stream() override
+  {
+    LZ4F_freeDecompressionContext(m_context);
+  }
+
+  int Read(void *buffer, int size) override
+  {
+    for(;;) {
+      if(m_input.empty() && !m_pending && !m_input.fill()) {
+        return m_remaining == 0 ? 0 : -1; // EOF, or a truncated frame.
+      }
+
+      auto produced = static_cast<std::size_t>(size);
+      auto consumed = m_input.m_size - m_input.m_position;
+      m_remaining =
+          LZ4F_decompress(m_context, buffer, &produced, m_input.m_data + m_input.m_position, &consumed, nullptr);
+      m_input.m_position += consumed;
+
+      if(LZ4F_isError(m_remaining) != 0) {
+        return -1;
+      }
+
+      m_pending = produced == static_cast<std::size_t>(size) && m_remaining != 0;
+
+      if(produced > 0) {
+        return static_cast<int>(produced);
+      }
+    }
+  }
+
+private:
+  compressed_input m_input;
+  LZ4F_dctx *m_context = nullptr;
+
+  // The hint of lz4 for the bytes left in the current frame, which is zero between frames.
+  std::size_t m_remaining = 0;
+  // Whether decompressed bytes may be left in the context, because they did not fit into the last buffer.
+  bool m_pending = false;
+};
+
+/**
+ * Compresses into a single lz4 frame, which is finished by finish() or on destruction.
+ */
+class lz4_output_stream : public CopyingOutputStream {
+public:
+  explicit lz4_output_stream(ZeroCopyOutputStream *output) : m_output(output)
+  {
+    if(LZ4F_isError(LZ4F_createCompressionContext(&m_context, LZ4F_VERSION)) != 0) {
+      throw std::runtime_error("Could not create an lz4 compression context.");
+    }
+
+    m_buffer.resize(LZ4F_compressBound(BUFFER_SIZE, nullptr));
+
+    auto const size = LZ4F_compressBegin(m_context, m_buffer.data(), m_buffer.size(), nullptr);
+    if(LZ4F_isError(size) != 0 || !m_output.write(m_buffer.data(), size)) {
+      LZ4F_freeCompressionContext(m_context);
+      throw std::runtime_error("Could not start an lz4 frame.");
+    }
+  }
+
+  ~lz4_output_stream() override
+  {
+    if(!m_finished) {
+      finish();
+    }
+
+    LZ4F_freeCompressionContext(m_context);
+  }
+
+  bool Write(void const *buffer, int size) override
+  {
+    auto const bound = LZ4F_compressBound(static_cast<std::size_t>(size), nullptr);
+    if(m_buffer.size() < bound) {
+      m_buffer.resize(bound);
+    }
+
+    auto const compressed = LZ4F_compressUpdate(
+        m_context, m_buffer.data(), m_buffer.size(), buffer, static_cast<std::size_t>(size), nullptr);
+
+    return LZ4F_isError(compressed) == 0 && m_output.write(m_buffer.data(), compressed);
+  }
+
+  /**
+   * Write all the bytes compressed so far, ending the current block.
+   */
+  bool flush()
+  {
+    // The buffer always has room for a whole block, which is all that lz4 may hold back.
+    auto const size = LZ4F_flush(m_context, m_buffer.data(), m_buffer.size(), nullptr);
+
+    return LZ4F_isError(size) == 0 && m_output.write(m_buffer.data(), size);
+  }
+
+  /**
+   * End the frame.
+   */
+  bool finish()
+  {
+    m_finished = true;
+
+    auto const size = LZ4F_compressEnd(m_context, m_buffer.data(), m_buffer.size(), nullptr);
+
+    return LZ4F_isError(size) == 0 && m_output.write(m_buffer.data(), size);
+  }
+
+private:
+  compressed_output m_output;
+  LZ4F_cctx *m_context = nullptr;
+  bool m_finished = false;
+
+  // The compressed bytes, since lz4 needs room for a whole block to compress into.
+  std::vector<char> m_buffer;
+};
+#endif
+
+/**
+ * Compresses with gzip.
+ */
+class gzip_output_stream : public compressed_output_stream {
+public:
+  explicit gzip_output_stream(ZeroCopyOutputStream *output) : m_stream(output)
+  {
+  }
+
+  bool Next(void **data, int *size) override
+  {
+    return m_stream.Next(data, size);
+  }
+
+  void BackUp(int count) override
+  {
+    m_stream.BackUp(count);
+  }
+
+  std::int64_t ByteCount() const override
+  {
+    return m_stream.ByteCount();
+  }
+
+  bool flush() override
+  {
+    return m_stream.Flush();
+  }
+
+  bool close() override
+  {
+    return m_stream.Close();
+  }
+
+private:
+  GzipOutputStream m_stream;
+};
+
+/**
+ * Buffers the bytes written to it for a compressor (zstd_output_stream or lz4_output_stream).
+ */
+template <typename Compressor>
+class buffered_output_stream : public compressed_output_stream {
+public:
+  explicit buffered_output_stream(ZeroCopyOutputStream *output)
+      : m_compressor(output), m_adaptor(&m_compressor, BUFFER_SIZE)
+  {
+  }
+
+  bool Next(void **data, int *size) override
+  {
+    return m_adaptor.Next(data, size);
+  }
+
+  void BackUp(int count) override
+  {
+    m_adaptor.BackUp(count);
+  }
+
+  std::int64_t ByteCount() const override
+  {
+    return m_adaptor.ByteCount();
+  }
+
+  bool flush() override
+  {
+    return m_adaptor.Flush() && m_compressor.flush();
+  }
+
+  bool close() override
+  {
+    return m_adaptor.Flush() && m_compressor.finish();
+  }
+
+private:
+  // Declared before the adaptor, which writes its buffer to the compressor when it is destroyed.
+  Compressor m_compressor;
+  CopyingOutputStreamAdaptor m_adaptor;
+};
+
+std::string name(compression format)
+{
+  switch(format) {
+  case compression::none:
+    return "none";
+  case compression::gzip:
+    return "gzip";
+  case compression::zstd:
+    return "zstd";
+  case compression::lz4:
+    return "lz4";
+  }
+
+  return "unknown";
+}
+
+void check_available(compression format)
+{
+  if(format == compression::none) {
+    throw std::invalid_argument("A stream without compression cannot be compressed or decompressed.");
+  }
+
+  if(!is_available(format)) {
+    throw std::runtime_error("Support for " + name(format) + " compression was not built into ioproto.");
+  }
+}
+
+std::unique_ptr<ZeroCopyInputStream> decompress(compression format, ZeroCopyInputStream *input)
+{
+  check_available(format);
+
+  std::unique_ptr<CopyingInputStream> stream;
+  switch(format) {
+#ifdef IOPROTO_HAS_ZSTD
+  case compression::zstd:
+    stream = std::make_unique<zstd_input_stream>(input);
+    break;
+#endif
+#ifdef IOPROTO_HAS_LZ4
+  case compression::lz4:
+    stream = std::make_unique<lz4_input_stream>(input);
+    break;
+#endif
+  default:
+    return std::make_unique<GzipInputStream>(input);
+  }
+
+  auto adaptor = std::make_unique<CopyingInputStreamAdaptor>(stream.release(), BUFFER_SIZE);
+  adaptor->SetOwnsCopyingStream(true);
+
+  return adaptor;
+}
+
+std::unique_ptr<compressed_output_stream> compress(compression format, ZeroCopyOutputStream *output)
+{
+  check_available(format);
+
+  switch(format) {
+#ifdef IOPROTO_HAS_ZSTD
+  case compression::zstd:
+    return std::make_unique<buffered_output_stream<zstd_output_stream>>(output);
+#endif
+#ifdef IOPROTO_HAS_LZ4
+  case compression::lz4:
+    return std::make_unique<buffered_output_stream<lz4_output_stream>>(output);
+#endif
+  default:
+    return std::make_unique<gzip_output_stream>(output);
+  }
+}
+} // namespace ioproto
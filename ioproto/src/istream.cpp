@@ -1,54 +1,98 @@
 #include "ioproto/istream.hpp"
 
+#include <fstream>
 #include <istream>
 
 #include <google/protobuf/message.h>
 #include <google/protobuf/io/coded_stream.h>
 #include <google/protobuf/io/zero_copy_stream_impl.h>
 
+#include <ioproto/compression.hpp>
+#include <ioproto/mapped-input-stream.hpp>
+#include <ioproto/prefetch-input-stream.hpp>
+
 namespace ioproto {
 
 using google::protobuf::Message;
 using google::protobuf::io::CodedInputStream;
-using google::protobuf::io::GzipInputStream;
 using google::protobuf::io::IstreamInputStream;
 using google::protobuf::io::ZeroCopyInputStream;
 
-bool is_gzipped(std::istream &stream)
+compression detect_compression(std::istream &stream)
 {
-  bool use_gzip = false;
-
-  unsigned char magic_number[2];
-  if(stream >> magic_number[0]) {
-    if(stream >> magic_number[1]) {
-      use_gzip = magic_number[0] == 0x1f && magic_number[1] == 0x8b;
-    }
-  }
+  unsigned char header[COMPRESSION_MAGIC_SIZE];
+  stream.read(reinterpret_cast<char *>(header), COMPRESSION_MAGIC_SIZE);
+  auto const format = detect_compression(header, static_cast<std::size_t>(stream.gcount()));
 
   // Reset the stream to its initial state.
   stream.clear();
   stream.seekg(0, std::istream::beg);
 
-  return use_gzip;
+  return format;
 }
 
-istream::istream(std::istream &stream)
+compression detect_compression(mapped_input_stream const &stream)
+{
+  return detect_compression(stream.data(), stream.size());
+}
+
+istream::istream(std::istream &stream, read_mode mode)
 {
   parent_stream = std::make_unique<IstreamInputStream>(&stream);
-  input_stream = parent_stream.get();
+  open(detect_compression(stream), mode);
+}
+
+istream::istream(std::istream &stream, std::uint32_t magic_number, read_mode mode) : istream(stream, mode)
+{
+  check_magic_number(magic_number);
+}
 
-  if(is_gzipped(stream)) {
-    gzip_stream = std::make_unique<GzipInputStream>(parent_stream.get());
-    input_stream = gzip_stream.get();
+istream::istream(std::string const &filename, read_mode mode)
+{
+  if(mapped_input_stream::is_supported()) {
+    auto mapped_stream = std::make_unique<mapped_input_stream>(filename);
+    auto const format = detect_compression(*mapped_stream);
+
+    parent_stream = std::move(mapped_stream);
+    open(format, mode);
+  } else {
+    file_stream = std::make_unique<std::ifstream>(filename, std::ios::binary);
+    if(!file_stream->good()) {
+      throw std::runtime_error("The file " + filename + " could not be opened.");
+    }
+
+    parent_stream = std::make_unique<IstreamInputStream>(file_stream.get());
+    open(detect_compression(*file_stream), mode);
   }
 }
 
-istream::istream(std::istream &stream, std::uint32_t magic_number) : istream(stream)
+istream::istream(std::string const &filename, std::uint32_t magic_number, read_mode mode)
+    : istream(filename, mode)
 {
-  CodedInputStream coded_stream(input_stream);
+  check_magic_number(magic_number);
+}
 
+void istream::open(compression format, read_mode mode)
+{
+  input_stream = parent_stream.get();
+
+  if(format != compression::none) {
+    decompressed_stream = decompress(format, parent_stream.get());
+    input_stream = decompressed_stream.get();
+
+    if(mode == read_mode::async) {
+      prefetch_stream = std::make_unique<prefetch_input_stream>(decompressed_stream.get());
+      input_stream = prefetch_stream.get();
+    }
+  }
+
+  coded_stream = std::make_unique<CodedInputStream>(input_stream);
+}
+
+void istream::check_magic_number(std::uint32_t magic_number)
+{
   std::uint32_t number;
-  if(!coded_stream.ReadLittleEndian32(&number)) {
+  if(!coded_stream->ReadLittleEndian32(&number)) {
     throw std::runtime_error("Could not read magic number.");
   }
 
@@ -57,17 +101,35 @@ istream::istream(std::istream &stream, std::uint32_t magic_number) : istream(str
   }
 }
 
+constexpr int istream::RESET_BYTES;
+
 bool istream::read(google::protobuf::Message *message)
 {
-  CodedInputStream coded_stream(input_stream);
+  if(coded_stream->CurrentPosition() >= RESET_BYTES) {
+    // The old stream must be destroyed before the new one is created, so it backs up to the next unread byte.
+    coded_stream.reset();
+    coded_stream = std::make_unique<CodedInputStream>(input_stream);
+  }
+
   uint32_t size;
 
-  if(coded_stream.ReadVarint32(&size)) {
-    auto const limit = coded_stream.PushLimit(static_cast<int>(size));
+  if(coded_stream->ReadVarint32(&size)) {
+    auto const length = static_cast<int>(size);
 
-    if(message->ParseFromCodedStream(&coded_stream)) {
-      coded_stream.PopLimit(limit);
+    // Parse the message in place if it is contiguous in the buffer (e.g., always for a mapped file), which avoids the
+    // setup of parsing from a coded stream.
+    void const *data = nullptr;
+    int available = 0;
+    bool parsed;
+    if(coded_stream->GetDirectBufferPointer(&data, &available) && available >= length) {
+      parsed = message->ParseFromArray(data, length) && coded_stream->Skip(length);
+    } else {
+      auto const limit = coded_stream->PushLimit(length);
+      parsed = message->ParseFromCodedStream(coded_stream.get());
+      coded_stream->PopLimit(limit);
+    }
 
+    if(parsed) {
       return true; // there are more messages.
     } else {
       throw std::runtime_error("Unable to read message from protobuf file.");
@@ -0,0 +1,124 @@
+#include "ioproto/mapped-input-stream.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define IOPROTO_HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ioproto {
+
+// The most bytes handed out by one call to Next(), which reports the size as an int.
+constexpr std::size_t MAX_CHUNK_SIZE = std::size_t{1} << 30u;
+
+mapped_input_stream::mapped_input_stream(std::string const &filename)
+{
+#ifdef IOPROTO_HAS_MMAP
+  auto const descriptor = ::open(filename.c_str(), O_RDONLY);
+  if(descriptor < 0) {
+    throw std::runtime_error("The file " + filename + " could not be opened.");
+  }
+
+  struct stat status {};
+  if(::fstat(descriptor, &status) != 0) {
+    ::close(descriptor);
+    throw std::runtime_error("The size of the file " + filename + " could not be read.");
+  }
+
+  m_size = static_cast<std::size_t>(status.st_size);
+
+  // An empty file cannot be mapped, and there is nothing to read anyway.
+  if(m_size > 0) {
+    auto const mapping = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    if(mapping == MAP_FAILED) {
+      ::close(descriptor);
+      throw std::runtime_error("The file " + filename + " could not be mapped.");
+    }
+
+    // The hints only affect performance, so failures are ignored.
+    ::madvise(mapping, m_size, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+    ::madvise(mapping, m_size, MADV_HUGEPAGE);
+#endif
+
+    m_data = static_cast<std::uint8_t const *>(mapping);
+  }
+
+  // The mapping stays valid after the descriptor is closed.
+  ::close(descriptor);
+#else
+  throw std::runtime_error("The file " + filename + " cannot be mapped on this platform.");
+#endif
+}
+
+mapped_input_stream::~mapped_input_stream()
+{
+#ifdef IOPROTO_HAS_MMAP
+  if(m_data != nullptr) {
+    ::munmap(const_cast<std::uint8_t *>(m_data), m_size);
+  }
+#endif
+}
+
+bool mapped_input_stream::is_supported()
+{
+#ifdef IOPROTO_HAS_MMAP
+  return true;
+#else
+  return false;
+#endif
+}
+
+std::uint8_t const *mapped_input_stream::data() const
+{
+  return m_data;
+}
+
+std::size_t mapped_input_stream::size() const
+{
+  return m_size;
+}
+
+bool mapped_input_stream::Next(void const **data, int *size)
+{
+  if(m_position == m_size) {
+    return false;
+  }
+
+  auto const chunk = std::min(m_size - m_position, MAX_CHUNK_SIZE);
+
+  *data = m_data + m_position;
+  *size = static_cast<int>(chunk);
+  m_position += chunk;
+
+  return true;
+}
+
+void mapped_input_stream::BackUp(int count)
+{
+  m_position -= static_cast<std::size_t>(count);
+}
+
+bool mapped_input_stream::Skip(int count)
+{
+  auto const remaining = m_size - m_position;
+  if(static_cast<std::size_t>(count) > remaining) {
+    m_position = m_size;
+    return false;
+  }
+
+  m_position += static_cast<std::size_t>(count);
+
+  return true;
+}
+
+std::int64_t mapped_input_stream::ByteCount() const
+{
+  return static_cast<std::int64_t>(m_position);
+}
+} // namespace ioproto
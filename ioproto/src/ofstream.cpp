@@ -1,46 +1,92 @@
 #include "ioproto/ofstream.hpp"
 
+#include <ostream>
+#include <stdexcept>
+
 #include <google/protobuf/io/coded_stream.h>
 
 namespace ioproto {
 
 using google::protobuf::Message;
 using google::protobuf::io::CodedOutputStream;
-using google::protobuf::io::GzipOutputStream;
-using google::protobuf::io::OstreamOutputStream;
+using google::protobuf::io::CopyingOutputStream;
+using google::protobuf::io::CopyingOutputStreamAdaptor;
 using google::protobuf::io::ZeroCopyOutputStream;
 
-bool is_gzipped(std::string const &filename)
-{
-  auto const extension = filename.find_last_of('.');
-  if(extension == std::string::npos) {
-    return false;
+/**
+ * Writes to a standard output stream, like protobuf's OstreamOutputStream, but through an adaptor that can be flushed.
+ */
+class ostream_writer : public CopyingOutputStream {
+public:
+  explicit ostream_writer(std::ostream &stream) : m_stream(stream)
+  {
   }
 
-  return filename.substr(extension + 1) == "gz";
-}
+  bool Write(void const *buffer, int size) override
+  {
+    m_stream.write(static_cast<char const *>(buffer), size);
+
+    return m_stream.good();
+  }
 
-ofstream::ofstream(std::string const &file_name)
-    : standard_stream(file_name, std::ios::out | std::ios::binary | std::ios::trunc)
+private:
+  std::ostream &m_stream;
+};
+
+ofstream::ofstream(std::string const &file_name, write_mode mode)
+    : filename(file_name), standard_stream(file_name, std::ios::out | std::ios::binary | std::ios::trunc)
 {
-  wrapped_fstream = std::make_unique<OstreamOutputStream>(&standard_stream);
+  if(!standard_stream.good()) {
+    throw std::runtime_error("The file " + file_name + " could not be opened.");
+  }
+
+  auto writer = std::make_unique<ostream_writer>(standard_stream);
+  wrapped_fstream = std::make_unique<CopyingOutputStreamAdaptor>(writer.release());
+  wrapped_fstream->SetOwnsCopyingStream(true);
   output_stream = wrapped_fstream.get();
 
-  // Use gzip if it is present in the filename.
-  if(is_gzipped(file_name)) {
-    gzip_stream = std::make_unique<GzipOutputStream>(wrapped_fstream.get());
-    output_stream = gzip_stream.get();
+  // Compress if the extension of the filename asks for it.
+  auto const format = compression_for(file_name);
+  if(format != compression::none) {
+    compressed_stream = compress(format, wrapped_fstream.get());
+    output_stream = compressed_stream.get();
+  }
+
+  if(mode == write_mode::async) {
+    async_stream = std::make_unique<async_output_stream>(output_stream);
+    output_stream = async_stream.get();
   }
 }
 
-ofstream::ofstream(std::string const &file_name, std::uint32_t magic_number) : ofstream(file_name)
+ofstream::ofstream(std::string const &file_name, std::uint32_t magic_number, write_mode mode)
+    : ofstream(file_name, mode)
 {
   CodedOutputStream coded_stream(output_stream);
   coded_stream.WriteLittleEndian32(magic_number);
 }
 
+ofstream::~ofstream()
+{
+  if(output_stream != nullptr) {
+    try {
+      close();
+    } catch(std::exception const &) {
+      // A destructor cannot report the error, which is why close() should be called explicitly.
+    }
+  }
+}
+
+void ofstream::check_open() const
+{
+  if(output_stream == nullptr) {
+    throw std::runtime_error("The file " + filename + " is closed.");
+  }
+}
+
 void ofstream::write(google::protobuf::Message const &message)
 {
+  check_open();
+
   // Determine the size of the message in bytes.
   auto const size = static_cast<std::uint32_t>(message.ByteSize());
 
@@ -50,6 +96,49 @@ void ofstream::write(google::protobuf::Message const &message)
   coded_stream.WriteVarint32(size);
   // Write the message itself.
   message.SerializeWithCachedSizes(&coded_stream);
+
+  if(coded_stream.HadError()) {
+    throw std::runtime_error("Could not write a message to " + filename + ".");
+  }
+}
+
+void ofstream::flush()
+{
+  check_open();
+
+  // Push the bytes through each stream in turn, from the messages to the file.
+  auto written = async_stream == nullptr || async_stream->flush();
+  written = written && (compressed_stream == nullptr || compressed_stream->flush());
+  written = written && wrapped_fstream->Flush();
+  standard_stream.flush();
+
+  if(!written || !standard_stream.good()) {
+    throw std::runtime_error("Could not write to " + filename + ".");
+  }
+}
+
+void ofstream::close()
+{
+  check_open();
+  output_stream = nullptr;
+
+  // Finish each stream in turn, from the messages to the file, even if an earlier one failed.
+  auto written = true;
+  if(async_stream != nullptr) {
+    written = async_stream->flush();
+    async_stream.reset();
+  }
+
+  if(compressed_stream != nullptr) {
+    written = compressed_stream->close() && written;
+  }
+
+  written = wrapped_fstream->Flush() && written;
+  standard_stream.close();
+
+  if(!written || standard_stream.fail()) {
+    throw std::runtime_error("Could not write to " + filename + ".");
+  }
 }
 
 } // namespace ioproto
\ No newline at end of file
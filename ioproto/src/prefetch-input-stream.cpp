@@ -0,0 +1,181 @@
+#include "ioproto/prefetch-input-stream.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace ioproto {
+
+constexpr std::size_t prefetch_input_stream::DEFAULT_BUFFER_SIZE;
+constexpr std::size_t prefetch_input_stream::DEFAULT_BUFFER_COUNT;
+
+prefetch_input_stream::prefetch_input_stream(google::protobuf::io::ZeroCopyInputStream *source,
+    std::size_t buffer_size,
+    std::size_t buffer_count)
+    : m_source(source)
+{
+  if(buffer_count < 2) {
+    throw std::invalid_argument("A prefetching stream needs at least two buffers.");
+  }
+
+  // Next() reports the size of a buffer as an int.
+  if(buffer_size == 0 || buffer_size > static_cast<std::size_t>(std::numeric_limits<int>::max())) {
+    throw std::invalid_argument("The buffers of a prefetching stream must hold between 1 byte and 2 GiB.");
+  }
+
+  m_buffers.resize(buffer_count);
+  for(auto &buffer : m_buffers) {
+    buffer.data.resize(buffer_size);
+  }
+
+  m_thread = std::thread(&prefetch_input_stream::prefetch, this);
+}
+
+prefetch_input_stream::~prefetch_input_stream()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopping = true;
+  }
+
+  m_drained.notify_all();
+  m_thread.join();
+}
+
+void prefetch_input_stream::prefetch()
+{
+  for(;;) {
+    buffer *target;
+    {
+      // Wait for a drained buffer.
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_drained.wait(lock, [this]() { return m_stopping || m_fill_count - m_drain_count < m_buffers.size(); });
+      if(m_stopping) {
+        return;
+      }
+
+      target = &m_buffers[m_fill_count % m_buffers.size()];
+    }
+
+    // Fill the buffer without holding the lock, so the reader can drain the others meanwhile.
+    std::size_t size = 0;
+    bool ended = false;
+    try {
+      while(size < target->data.size()) {
+        void const *data = nullptr;
+        int available = 0;
+        if(!m_source->Next(&data, &available)) {
+          ended = true;
+          break;
+        }
+
+        auto const chunk = static_cast<std::size_t>(available);
+        auto const copied = std::min(chunk, target->data.size() - size);
+        std::copy_n(static_cast<char const *>(data), copied, target->data.data() + size);
+        size += copied;
+
+        if(copied < chunk) {
+          m_source->BackUp(static_cast<int>(chunk - copied));
+        }
+      }
+    } catch(...) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_error = std::current_exception();
+      ended = true;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if(size > 0) {
+        target->size = size;
+        m_fill_count++;
+      }
+
+      m_source_ended = ended;
+    }
+
+    m_filled.notify_one();
+
+    if(ended) {
+      return;
+    }
+  }
+}
+
+void prefetch_input_stream::release_current()
+{
+  if(m_current == nullptr) {
+    return;
+  }
+
+  m_current = nullptr;
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_drain_count++;
+  }
+
+  m_drained.notify_one();
+}
+
+bool prefetch_input_stream::Next(void const **data, int *size)
+{
+  // Return what was backed up of the current buffer first.
+  if(m_current == nullptr || m_position == m_current->size) {
+    release_current();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_filled.wait(lock, [this]() { return m_fill_count > m_drain_count || m_source_ended; });
+    if(m_fill_count == m_drain_count) {
+      if(m_error) {
+        std::rethrow_exception(m_error);
+      }
+
+      return false;
+    }
+
+    m_current = &m_buffers[m_drain_count % m_buffers.size()];
+    m_position = 0;
+  }
+
+  auto const available = m_current->size - m_position;
+
+  *data = m_current->data.data() + m_position;
+  *size = static_cast<int>(available);
+  m_position = m_current->size;
+  m_byte_count += static_cast<std::int64_t>(available);
+
+  return true;
+}
+
+void prefetch_input_stream::BackUp(int count)
+{
+  m_position -= static_cast<std::size_t>(count);
+  m_byte_count -= count;
+}
+
+bool prefetch_input_stream::Skip(int count)
+{
+  while(count > 0) {
+    void const *data = nullptr;
+    int size = 0;
+    if(!Next(&data, &size)) {
+      return false;
+    }
+
+    if(size > count) {
+      BackUp(size - count);
+      return true;
+    }
+
+    count -= size;
+  }
+
+  return true;
+}
+
+std::int64_t prefetch_input_stream::ByteCount() const
+{
+  return m_byte_count;
+}
+} // namespace ioproto
@@ -40,8 +40,7 @@ void validate(argagg::parser_results const &options)
 void dump_to_csv(std::string const &input_filename, std::string const &output_filename)
 {
   spdlog::get("log")->info("Loading statistical profile from: {}.", input_filename);
-  std::ifstream file_stream(input_filename);
-  ioproto::istream input(file_stream, GEM5_MAGIC_NUMBER);
+  ioproto::istream input(input_filename, GEM5_MAGIC_NUMBER);
 
   auto profile = mocktails::read(input);
   if(profile->type != mocktails::model_type::mocktails) {
@@ -1,6 +1,5 @@
 #include "modelgen.hpp"
 
-#include <fstream>
 #include <vector>
 
 #include <iogem5/packet-trace.hpp>
@@ -79,8 +78,8 @@ void generate_model(std::string const &input_filename,
   auto const config = parse_configuration(config_filename);
   auto const model_type = parse_model_type(type);
 
-  std::ifstream input_file(input_filename);
-  iogem5::packet_trace_reader trace(input_file);
+  // Decompress the trace on another thread, while this one updates the model.
+  iogem5::packet_trace_reader trace(input_filename, ioproto::read_mode::async);
   spdlog::get("log")->info("Opened trace file: {}", input_filename);
 
   ioproto::ofstream output(output_filename, GEM5_MAGIC_NUMBER);
@@ -3,6 +3,8 @@
 
 #include "mocktails/hierarchy.hpp"
 
+#include <stdexcept>
+
 namespace mocktails {
 
 hierarchy::hierarchy(configuration config, partition root_partition) : m_config(std::move(config))
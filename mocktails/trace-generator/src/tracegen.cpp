@@ -1,6 +1,5 @@
 #include "tracegen.hpp"
 
-#include <fstream>
 
 #include <spdlog/spdlog.h>
 
@@ -15,13 +14,13 @@ void generate_trace(std::string const &input_filename, std::string const &output
 {
   spdlog::get("log")->info("Loading statistical profile from: {}.", input_filename);
 
-  std::ifstream stream(input_filename);
-  ioproto::istream input(stream, GEM5_MAGIC_NUMBER);
+  ioproto::istream input(input_filename, GEM5_MAGIC_NUMBER);
 
   std::uint64_t total_count = 0;
   auto profile = mocktails::read(input);
 
-  iogem5::packet_trace_writer trace(output_filename);
+  // Compress the trace on another thread, while this one synthesises the requests.
+  iogem5::packet_trace_writer trace(output_filename, ioproto::write_mode::async);
   spdlog::get("log")->info("Synthetic trace will be written to {}.", output_filename);
 
   while(profile != nullptr) {
@@ -51,5 +50,6 @@ void generate_trace(std::string const &input_filename, std::string const &output
     spdlog::get("log")->info("{} requests have been synthesized so far.", total_count);
   }
 
+  trace.close();
   spdlog::get("log")->info("Generated {} requests.", total_count);
 }
@@ -0,0 +1,1054 @@
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+#include "argagg.hpp"
+
+#include <reuse-distance/address-index.hpp>
+#include <reuse-distance/approximate.hpp>
+#include <reuse-distance/bplus.hpp>
+#include <reuse-distance/compact.hpp>
+#include <reuse-distance/counter-stacks.hpp>
+#include <reuse-distance/fenwick.hpp>
+#include <reuse-distance/hash.hpp>
+#include <reuse-distance/multi-granularity.hpp>
+#include <reuse-distance/olken.hpp>
+#include <reuse-distance/reuse-time.hpp>
+#include <reuse-distance/statstack.hpp>
+
+argagg::parser create_command_line_interface()
+{
+  return {{{"help", {"-h", "--help"}, "Display help information.", 0},
+      {"benchmark", {"-b", "--benchmark"}, "The benchmark to run: index, select, approximate, batch, compact, bplus, multi, window, reuse-time, patterns, counter-stacks (default: index).", 1},
+      {"pattern", {"--pattern"}, "The access pattern of the patterns, multi and window benchmarks: sequential, uniform, zipfian, strided, pointer-chase, loop, or all (default: all).", 1},
+      {"min", {"--min-footprint"}, "Smallest number of unique blocks (default: 10000).", 1},
+      {"max", {"--max-footprint"}, "Largest number of unique blocks (default: 100000000).", 1},
+      {"accesses", {"--accesses"}, "Number of timed accesses per footprint (default: 10000000).", 1},
+      {"queries", {"--queries"}, "Number of stack positions to select (default: 1000).", 1},
+      {"error", {"--error"}, "Relative error of the approximate tree (default: 0.01).", 1},
+      {"window", {"--window"}, "Maximum distance tracked by the windowed tree of the window benchmark (default: 65536).", 1},
+      {"seed", {"--seed"}, "Seed for the random number generator (default: 1).", 1}}};
+}
+
+void print_usage(std::ostream &stream, argagg::parser const &arguments)
+{
+  argagg::fmt_ostream help(stream);
+
+  help << "Measure the throughput of the reuse-distance library.\n\n";
+  help << "reuse-distance-bench [options] ARG [ARG...]\n\n";
+  help << arguments;
+}
+
+/**
+ * The settings shared by all benchmarks.
+ */
+struct settings {
+  std::uint64_t min_footprint = 10000;
+  std::uint64_t max_footprint = 100000000;
+  std::uint64_t accesses = 10000000;
+  std::uint64_t queries = 1000;
+  double error = 0.01;
+  std::uint64_t window = 65536;
+  std::uint64_t seed = 1;
+  std::string pattern = "all";
+};
+
+/**
+ * Measures the wall-clock time of a region of code.
+ */
+class stopwatch {
+public:
+  stopwatch() : m_start(std::chrono::steady_clock::now())
+  {
+  }
+
+  /**
+   * @return The nanoseconds elapsed since construction, divided by the number of operations.
+   */
+  double ns_per(std::uint64_t operations) const
+  {
+    auto const elapsed = std::chrono::steady_clock::now() - m_start;
+    auto const ns = std::chrono::duration<double, std::nano>(elapsed).count();
+
+    return ns / static_cast<double>(std::max<std::uint64_t>(operations, 1));
+  }
+
+private:
+  std::chrono::steady_clock::time_point m_start;
+};
+
+/**
+ * @return A list of footprints that increase by a factor of 10.
+ */
+std::vector<std::uint64_t> footprints(settings const &s)
+{
+  std::vector<std::uint64_t> result;
+  for(auto f = s.min_footprint; f <= s.max_footprint; f *= 10) {
+    result.push_back(f);
+  }
+
+  return result;
+}
+
+/**
+ * @return Unique block addresses in a random order, and a random sequence of accesses to those blocks.
+ */
+std::pair<std::vector<std::uint64_t>, std::vector<std::uint64_t>> generate_blocks(
+    std::uint64_t footprint, std::uint64_t accesses, std::mt19937_64 &rng)
+{
+  std::vector<std::uint64_t> blocks(footprint);
+  for(std::uint64_t i = 0; i < footprint; i++) {
+    blocks[i] = i * 64;
+  }
+  std::shuffle(blocks.begin(), blocks.end(), rng);
+
+  std::uniform_int_distribution<std::size_t> pick(0, blocks.size() - 1);
+  std::vector<std::uint64_t> sequence(accesses);
+  for(auto &a : sequence) {
+    a = blocks[pick(rng)];
+  }
+
+  return {std::move(blocks), std::move(sequence)};
+}
+
+/**
+ * Time the operations the reuse-distance tree performs on its index: insert, find, and erase then re-insert.
+ */
+template <typename Index, typename Find, typename Insert, typename Erase>
+void time_index(std::string const &name,
+    std::vector<std::uint64_t> const &blocks,
+    std::vector<std::uint64_t> const &sequence,
+    Find find,
+    Insert insert,
+    Erase erase)
+{
+  Index index;
+  std::uintptr_t checksum = 0;
+
+  stopwatch insert_timer;
+  for(auto const b : blocks) {
+    insert(index, b, b);
+  }
+  auto const insert_ns = insert_timer.ns_per(blocks.size());
+
+  stopwatch find_timer;
+  for(auto const a : sequence) {
+    checksum += find(index, a);
+  }
+  auto const find_ns = find_timer.ns_per(sequence.size());
+
+  stopwatch update_timer;
+  for(auto const a : sequence) {
+    auto const value = find(index, a);
+    erase(index, a);
+    insert(index, a, value + 1);
+  }
+  auto const update_ns = update_timer.ns_per(sequence.size());
+
+  std::cout << std::setw(14) << name << std::setw(14) << blocks.size() << std::setw(14) << insert_ns
+            << std::setw(14) << find_ns << std::setw(14) << update_ns << std::setw(22) << checksum
+            << std::endl;
+}
+
+/**
+ * Compare the open-addressing address_index to std::unordered_map.
+ */
+void benchmark_index(settings const &s)
+{
+  using std_map = std::unordered_map<std::uint64_t, std::uintptr_t>;
+  using flat_map = reuse_distance::address_index<std::uintptr_t>;
+
+  std::cout << std::fixed << std::setprecision(1);
+  std::cout << std::setw(14) << "index" << std::setw(14) << "footprint" << std::setw(14) << "insert ns"
+            << std::setw(14) << "find ns" << std::setw(14) << "update ns" << std::setw(22) << "checksum"
+            << std::endl;
+
+  std::mt19937_64 rng(s.seed);
+  for(auto const f : footprints(s)) {
+    auto const input = generate_blocks(f, s.accesses, rng);
+
+    time_index<std_map>(
+        "unordered_map", input.first, input.second,
+        [](std_map &m, std::uint64_t a) { return m.find(a)->second; },
+        [](std_map &m, std::uint64_t a, std::uintptr_t v) { m[a] = v; },
+        [](std_map &m, std::uint64_t a) { m.erase(a); });
+
+    time_index<flat_map>(
+        "address_index", input.first, input.second,
+        [](flat_map &m, std::uint64_t a) { return *m.find(a); },
+        [](flat_map &m, std::uint64_t a, std::uintptr_t v) { m.assign(a, v); },
+        [](flat_map &m, std::uint64_t a) { m.erase(a); });
+  }
+}
+
+/**
+ * Compare olken_tree::select_by_distance to walking predecessors from the most recently used node.
+ *
+ * @throw std::runtime_error if the two methods find different nodes.
+ */
+void benchmark_select(settings const &s)
+{
+  std::cout << std::fixed << std::setprecision(1);
+  std::cout << std::setw(14) << "footprint" << std::setw(14) << "queries" << std::setw(14) << "select ns"
+            << std::setw(14) << "walk ns" << std::endl;
+
+  std::mt19937_64 rng(s.seed);
+  for(auto const f : footprints(s)) {
+    auto const input = generate_blocks(f, s.accesses, rng);
+
+    reuse_distance::olken_tree tree;
+    std::uint64_t time = 0;
+    for(auto const b : input.first) {
+      reuse_distance::update(tree, b, time++);
+    }
+    for(auto const a : input.second) {
+      reuse_distance::update(tree, a, time++);
+    }
+
+    std::uniform_int_distribution<std::size_t> pick(0, tree.size() - 1);
+    std::vector<std::size_t> positions(s.queries);
+    for(auto &p : positions) {
+      p = pick(rng);
+    }
+
+    std::vector<reuse_distance::olken_tree::node const *> selected;
+    selected.reserve(positions.size());
+
+    stopwatch select_timer;
+    for(auto const p : positions) {
+      selected.push_back(tree.select_by_distance(p));
+    }
+    auto const select_ns = select_timer.ns_per(positions.size());
+
+    std::vector<reuse_distance::olken_tree::node const *> walked;
+    walked.reserve(positions.size());
+
+    stopwatch walk_timer;
+    for(auto const p : positions) {
+      auto node = tree.most_recently_used();
+      for(std::size_t i = 0; i < p; i++) {
+        node = tree.predecessor(node);
+      }
+      walked.push_back(node);
+    }
+    auto const walk_ns = walk_timer.ns_per(positions.size());
+
+    if(selected != walked) {
+      throw std::runtime_error("select_by_distance disagrees with the linear walk.");
+    }
+
+    std::cout << std::setw(14) << f << std::setw(14) << positions.size() << std::setw(14) << select_ns
+              << std::setw(14) << walk_ns << std::endl;
+  }
+}
+
+/**
+ * Compare the approximate_tree to the exact olken_tree on the same accesses.
+ *
+ * @throw std::runtime_error if a distance is outside the relative error of the approximate tree.
+ */
+void benchmark_approximate(settings const &s)
+{
+  std::cout << std::fixed << std::setprecision(1);
+  std::cout << std::setw(14) << "footprint" << std::setw(14) << "exact ns" << std::setw(14) << "approx ns"
+            << std::setw(14) << "buckets" << std::setw(14) << "max error %" << std::endl;
+
+  std::mt19937_64 rng(s.seed);
+  for(auto const f : footprints(s)) {
+    auto const input = generate_blocks(f, s.accesses, rng);
+
+    std::vector<double> exact;
+    exact.reserve(input.second.size());
+
+    reuse_distance::olken_tree exact_tree;
+    std::uint64_t time = 0;
+    for(auto const b : input.first) {
+      reuse_distance::access(exact_tree, b, time++);
+    }
+
+    stopwatch exact_timer;
+    for(auto const a : input.second) {
+      exact.push_back(reuse_distance::access(exact_tree, a, time++));
+    }
+    auto const exact_ns = exact_timer.ns_per(input.second.size());
+
+    std::vector<double> approximate;
+    approximate.reserve(input.second.size());
+
+    reuse_distance::approximate_tree approximate_tree(s.error);
+    for(auto const b : input.first) {
+      reuse_distance::access(approximate_tree, b, time++);
+    }
+
+    stopwatch approximate_timer;
+    for(auto const a : input.second) {
+      approximate.push_back(reuse_distance::access(approximate_tree, a, time++));
+    }
+    auto const approximate_ns = approximate_timer.ns_per(input.second.size());
+
+    double max_error = 0.0;
+    for(std::size_t i = 0; i < exact.size(); i++) {
+      auto const difference = std::abs(approximate[i] - exact[i]);
+
+      if(difference > s.error * exact[i]) {
+        throw std::runtime_error("The approximate distance " + std::to_string(approximate[i]) +
+                                 " is too far from the exact distance " + std::to_string(exact[i]) + ".");
+      }
+
+      if(exact[i] > 0) {
+        max_error = std::max(max_error, difference / exact[i]);
+      }
+    }
+
+    std::cout << std::setw(14) << f << std::setw(14) << exact_ns << std::setw(14) << approximate_ns
+              << std::setw(14) << approximate_tree.buckets() << std::setw(14) << 100 * max_error << std::endl;
+  }
+}
+
+/**
+ * Time one access per call against the batched access with prefetching, on the same accesses.
+ *
+ * @throw std::runtime_error if the two paths compute different distances.
+ */
+template <typename Tree>
+void time_batch(std::string const &name, std::vector<std::uint64_t> const &blocks, std::vector<std::uint64_t> const &sequence)
+{
+  std::vector<double> single(sequence.size());
+  std::vector<double> batched(sequence.size());
+
+  Tree single_tree;
+  std::uint64_t time = 0;
+  for(auto const b : blocks) {
+    reuse_distance::access(single_tree, b, time++);
+  }
+
+  stopwatch single_timer;
+  for(std::size_t i = 0; i < sequence.size(); i++) {
+    single[i] = reuse_distance::access(single_tree, sequence[i], time + i);
+  }
+  auto const single_ns = single_timer.ns_per(sequence.size());
+
+  Tree batch_tree;
+  std::vector<double> first_accesses(blocks.size());
+  reuse_distance::access(batch_tree, blocks.data(), blocks.size(), 0, first_accesses.data());
+
+  stopwatch batch_timer;
+  reuse_distance::access(batch_tree, sequence.data(), sequence.size(), time, batched.data());
+  auto const batch_ns = batch_timer.ns_per(sequence.size());
+
+  if(single != batched) {
+    throw std::runtime_error("The batched distances of the " + name + " differ from the single accesses.");
+  }
+
+  std::cout << std::setw(14) << name << std::setw(14) << blocks.size() << std::setw(14) << single_ns
+            << std::setw(14) << batch_ns << std::endl;
+}
+
+/**
+ * Compare the batched access functions to calling access() for one address at a time.
+ */
+void benchmark_batch(settings const &s)
+{
+  std::cout << std::fixed << std::setprecision(1);
+  std::cout << std::setw(14) << "tree" << std::setw(14) << "footprint" << std::setw(14) << "single ns"
+            << std::setw(14) << "batch ns" << std::endl;
+
+  std::mt19937_64 rng(s.seed);
+  for(auto const f : footprints(s)) {
+    auto const input = generate_blocks(f, s.accesses, rng);
+
+    time_batch<reuse_distance::olken_tree>("olken_tree", input.first, input.second);
+    time_batch<reuse_distance::fenwick_tree>("fenwick_tree", input.first, input.second);
+  }
+}
+
+/**
+ * Time a tree on a sequence of accesses, and measure its memory per tracked address.
+ *
+ * @return The distance of each access.
+ */
+template <typename Tree>
+std::vector<double> time_tree(std::string const &name,
+    std::vector<std::uint64_t> const &blocks,
+    std::vector<std::uint64_t> const &sequence)
+{
+  std::vector<double> distances(sequence.size());
+
+  Tree tree;
+  std::uint64_t time = 0;
+  for(auto const b : blocks) {
+    reuse_distance::access(tree, b, time++);
+  }
+
+  stopwatch timer;
+  reuse_distance::access(tree, sequence.data(), sequence.size(), time, distances.data());
+  auto const ns = timer.ns_per(sequence.size());
+
+  auto const bytes = static_cast<double>(tree.memory_usage()) / static_cast<double>(tree.size());
+
+  std::cout << std::setw(14) << name << std::setw(14) << blocks.size() << std::setw(14) << ns << std::setw(14)
+            << bytes << std::endl;
+
+  return distances;
+}
+
+/**
+ * Compare the compact_tree to the olken_tree it is a variant of.
+ *
+ * @throw std::runtime_error if the two trees compute different distances.
+ */
+void benchmark_compact(settings const &s)
+{
+  std::cout << std::fixed << std::setprecision(1);
+  std::cout << std::setw(14) << "tree" << std::setw(14) << "footprint" << std::setw(14) << "access ns"
+            << std::setw(14) << "bytes/block" << std::endl;
+
+  std::mt19937_64 rng(s.seed);
+  for(auto const f : footprints(s)) {
+    auto const input = generate_blocks(f, s.accesses, rng);
+
+    auto const expected = time_tree<reuse_distance::olken_tree>("olken_tree", input.first, input.second);
+    auto const actual = time_tree<reuse_distance::compact_tree>("compact_tree", input.first, input.second);
+
+    if(expected != actual) {
+      throw std::runtime_error("The compact_tree disagrees with the olken_tree.");
+    }
+  }
+}
+
+/**
+ * Compare the bplus_tree to the binary search trees, whose height grows much faster with the footprint.
+ *
+ * @throw std::runtime_error if the trees compute different distances.
+ */
+void benchmark_bplus(settings const &s)
+{
+  std::cout << std::fixed << std::setprecision(1);
+  std::cout << std::setw(14) << "tree" << std::setw(14) << "footprint" << std::setw(14) << "access ns"
+            << std::setw(14) << "bytes/block" << std::endl;
+
+  std::mt19937_64 rng(s.seed);
+  for(auto const f : footprints(s)) {
+    auto const input = generate_blocks(f, s.accesses, rng);
+
+    auto const expected = time_tree<reuse_distance::olken_tree>("olken_tree", input.first, input.second);
+    auto const compact = time_tree<reuse_distance::compact_tree>("compact_tree", input.first, input.second);
+    auto const actual = time_tree<reuse_distance::bplus_tree>("bplus_tree", input.first, input.second);
+
+    if(expected != compact || expected != actual) {
+      throw std::runtime_error("The bplus_tree disagrees with the olken_tree.");
+    }
+  }
+}
+
+/**
+ * @return The mean of the finite values in a histogram.
+ */
+double finite_mean(std::map<double, std::uint64_t> const &histogram)
+{
+  double sum = 0.0;
+  std::uint64_t count = 0;
+  for(auto const &bin : histogram) {
+    if(std::isfinite(bin.first)) {
+      sum += bin.first * static_cast<double>(bin.second);
+      count += bin.second;
+    }
+  }
+
+  return count > 0 ? sum / static_cast<double>(count) : 0.0;
+}
+
+/**
+ * Compare measuring reuse times and converting them with StatStack to measuring exact distances with an olken_tree.
+ */
+void benchmark_reuse_time(settings const &s)
+{
+  std::cout << std::fixed << std::setprecision(1);
+  std::cout << std::setw(14) << "footprint" << std::setw(14) << "olken ns" << std::setw(14) << "reuse ns"
+            << std::setw(14) << "exact mean" << std::setw(14) << "estimate mean" << std::endl;
+
+  std::mt19937_64 rng(s.seed);
+  for(auto const f : footprints(s)) {
+    auto const input = generate_blocks(f, s.accesses, rng);
+    auto const &blocks = input.first;
+    auto const &sequence = input.second;
+    std::vector<double> values(std::max(blocks.size(), sequence.size()));
+
+    reuse_distance::olken_tree tree;
+    reuse_distance::access(tree, blocks.data(), blocks.size(), 0, values.data());
+
+    stopwatch olken_timer;
+    reuse_distance::access(tree, sequence.data(), sequence.size(), blocks.size(), values.data());
+    auto const olken_ns = olken_timer.ns_per(sequence.size());
+
+    std::map<double, std::uint64_t> distances;
+    for(std::size_t i = 0; i < sequence.size(); i++) {
+      distances[values[i]]++;
+    }
+
+    reuse_distance::reuse_time_tracker tracker;
+    reuse_distance::access(tracker, blocks.data(), blocks.size(), 0, values.data());
+
+    stopwatch reuse_timer;
+    reuse_distance::access(tracker, sequence.data(), sequence.size(), blocks.size(), values.data());
+    auto const reuse_ns = reuse_timer.ns_per(sequence.size());
+
+    std::map<double, std::uint64_t> reuse_times;
+    for(std::size_t i = 0; i < sequence.size(); i++) {
+      reuse_times[values[i]]++;
+    }
+    auto const estimates = reuse_distance::statstack(tracker.histogram()).convert(reuse_times);
+
+    std::cout << std::setw(14) << f << std::setw(14) << olken_ns << std::setw(14) << reuse_ns << std::setw(14)
+              << finite_mean(distances) << std::setw(14) << finite_mean(estimates) << std::endl;
+  }
+}
+
+/** The exponent of the Zipfian distribution, as used by YCSB. */
+constexpr double ZIPF_THETA = 0.99;
+
+/** The distance in blocks between consecutive accesses of the strided pattern (a 4 KiB page of 64-byte blocks). */
+constexpr std::uint64_t STRIDE = 64;
+
+/** The number of working sets the loop pattern splits the footprint into, and how often each one is looped over. */
+constexpr std::uint64_t LOOP_WORKING_SETS = 16;
+constexpr std::uint64_t LOOP_ITERATIONS = 8;
+
+/**
+ * Generate a synthetic sequence of accesses to 64-byte blocks.
+ *
+ * - sequential: scans the footprint in address order, over and over.
+ * - uniform: picks a block at random.
+ * - zipfian: picks block i with a probability proportional to 1 / i^0.99, with the blocks scattered over memory.
+ * - strided: walks down the columns of a row-major matrix whose rows are STRIDE blocks long.
+ * - pointer-chase: follows a random cycle through the footprint, as when traversing a shuffled linked list.
+ * - loop: loops over one part of the footprint several times before moving on to the next.
+ *
+ * @throw std::runtime_error if the pattern is unknown.
+ */
+std::vector<std::uint64_t> generate_pattern(std::string const &pattern,
+    std::uint64_t footprint,
+    std::uint64_t accesses,
+    std::mt19937_64 &rng)
+{
+  std::vector<std::uint64_t> blocks(accesses);
+
+  if(pattern == "sequential") {
+    for(std::uint64_t i = 0; i < accesses; i++) {
+      blocks[i] = i % footprint;
+    }
+  } else if(pattern == "uniform") {
+    std::uniform_int_distribution<std::uint64_t> pick(0, footprint - 1);
+    for(auto &b : blocks) {
+      b = pick(rng);
+    }
+  } else if(pattern == "zipfian") {
+    // Gray et al., "Quickly Generating Billion-Record Synthetic Databases."
+    auto const n = static_cast<double>(footprint);
+    double zeta_n = 0.0;
+    for(std::uint64_t i = 1; i <= footprint; i++) {
+      zeta_n += 1.0 / std::pow(static_cast<double>(i), ZIPF_THETA);
+    }
+    auto const zeta_2 = 1.0 + std::pow(0.5, ZIPF_THETA);
+    auto const alpha = 1.0 / (1.0 - ZIPF_THETA);
+    auto const eta = (1.0 - std::pow(2.0 / n, 1.0 - ZIPF_THETA)) / (1.0 - zeta_2 / zeta_n);
+
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    for(auto &b : blocks) {
+      auto const u = uniform(rng);
+      auto const uz = u * zeta_n;
+
+      std::uint64_t rank = 0;
+      if(uz >= 1.0 + std::pow(0.5, ZIPF_THETA)) {
+        rank = static_cast<std::uint64_t>(n * std::pow(eta * u - eta + 1.0, alpha));
+      } else if(uz >= 1.0) {
+        rank = 1;
+      }
+
+      // The hash is a bijection, so each rank is a distinct block.
+      b = reuse_distance::hash(std::min(rank, footprint - 1));
+    }
+  } else if(pattern == "strided") {
+    // The footprint is rounded down to a whole number of rows.
+    auto const columns = std::min(STRIDE, footprint);
+    auto const rows = footprint / columns;
+    for(std::uint64_t i = 0; i < accesses; i++) {
+      auto const j = i % (rows * columns);
+      blocks[i] = (j % rows) * columns + j / rows;
+    }
+  } else if(pattern == "pointer-chase") {
+    // Sattolo's algorithm shuffles the blocks into a single cycle.
+    std::vector<std::uint64_t> next(footprint);
+    for(std::uint64_t i = 0; i < footprint; i++) {
+      next[i] = i;
+    }
+    for(auto i = footprint; i-- > 1;) {
+      std::uniform_int_distribution<std::uint64_t> pick(0, i - 1);
+      std::swap(next[i], next[pick(rng)]);
+    }
+
+    std::uint64_t current = 0;
+    for(auto &b : blocks) {
+      b = current;
+      current = next[current];
+    }
+  } else if(pattern == "loop") {
+    auto const working_set = std::max<std::uint64_t>(footprint / LOOP_WORKING_SETS, 1);
+    auto const sets = footprint / working_set;
+    for(std::uint64_t i = 0; i < accesses; i++) {
+      auto const set = (i / (working_set * LOOP_ITERATIONS)) % sets;
+      blocks[i] = set * working_set + i % working_set;
+    }
+  } else {
+    throw std::runtime_error("Unknown access pattern: " + pattern);
+  }
+
+  for(auto &b : blocks) {
+    b *= 64;
+  }
+
+  return blocks;
+}
+
+/**
+ * @return The peak resident set size of the process in MiB, or 0 if it cannot be measured.
+ */
+double peak_memory_mib()
+{
+#if defined(__APPLE__)
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+
+  return static_cast<double>(usage.ru_maxrss) / (1024.0 * 1024.0);
+#elif defined(__unix__)
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+
+  return static_cast<double>(usage.ru_maxrss) / 1024.0;
+#else
+  return 0.0;
+#endif
+}
+
+/**
+ * @return The height of a tree, or "-" for backends that are not a search tree.
+ */
+std::string height_of(reuse_distance::olken_tree const &tree)
+{
+  return std::to_string(tree.height());
+}
+
+std::string height_of(reuse_distance::compact_tree const &tree)
+{
+  return std::to_string(tree.height());
+}
+
+std::string height_of(reuse_distance::bplus_tree const &tree)
+{
+  return std::to_string(tree.height());
+}
+
+template <typename Tree>
+std::string height_of(Tree const &)
+{
+  return "-";
+}
+
+/**
+ * Create an empty tree for a benchmark.
+ */
+template <typename Tree>
+Tree make_tree(settings const &)
+{
+  return Tree();
+}
+
+template <>
+reuse_distance::approximate_tree make_tree(settings const &s)
+{
+  return reuse_distance::approximate_tree(s.error);
+}
+
+/**
+ * Time a backend on a sequence of accesses, both through compute_distance() and update() (as the STM and Mocktails
+ * profiles do) and through the batched access() (as the HRD profile does).
+ */
+template <typename Tree>
+void time_pattern(std::string const &pattern,
+    std::string const &name,
+    std::uint64_t footprint,
+    std::vector<std::uint64_t> const &sequence,
+    settings const &s)
+{
+  std::uint64_t cold = 0;
+
+  auto tree = make_tree<Tree>(s);
+  stopwatch pair_timer;
+  for(std::size_t i = 0; i < sequence.size(); i++) {
+    if(std::isinf(reuse_distance::compute_distance(tree, sequence[i]))) {
+      cold++;
+    }
+    reuse_distance::update(tree, sequence[i], i);
+  }
+  auto const pair_ns = pair_timer.ns_per(sequence.size());
+
+  std::vector<double> distances(sequence.size());
+  auto batch_tree = make_tree<Tree>(s);
+  stopwatch batch_timer;
+  reuse_distance::access(batch_tree, sequence.data(), sequence.size(), 0, distances.data());
+  auto const batch_ns = batch_timer.ns_per(sequence.size());
+
+  auto const tree_mib = static_cast<double>(batch_tree.memory_usage()) / (1024.0 * 1024.0);
+  auto const cold_percent = 100.0 * static_cast<double>(cold) / static_cast<double>(sequence.size());
+
+  std::cout << std::setw(14) << pattern << std::setw(14) << name << std::setw(14) << footprint << std::setw(14)
+            << pair_ns << std::setw(14) << batch_ns << std::setw(14) << 1000.0 / batch_ns << std::setw(14)
+            << height_of(batch_tree) << std::setw(14) << tree_mib << std::setw(14) << peak_memory_mib()
+            << std::setw(14) << cold_percent << std::endl;
+}
+
+/**
+ * Run every backend on synthetic access patterns over a sweep of footprints.
+ */
+void benchmark_patterns(settings const &s)
+{
+  std::vector<std::string> patterns = {"sequential", "uniform", "zipfian", "strided", "pointer-chase", "loop"};
+  if(s.pattern != "all") {
+    patterns = {s.pattern};
+  }
+
+  std::cout << std::fixed << std::setprecision(1);
+  std::cout << std::setw(14) << "pattern" << std::setw(14) << "tree" << std::setw(14) << "footprint"
+            << std::setw(14) << "pair ns" << std::setw(14) << "batch ns" << std::setw(14) << "M access/s"
+            << std::setw(14) << "height" << std::setw(14) << "tree MiB" << std::setw(14) << "peak MiB"
+            << std::setw(14) << "cold %" << std::endl;
+
+  std::mt19937_64 rng(s.seed);
+  for(auto const &pattern : patterns) {
+    for(auto const f : footprints(s)) {
+      auto const sequence = generate_pattern(pattern, f, s.accesses, rng);
+
+      time_pattern<reuse_distance::olken_tree>(pattern, "olken_tree", f, sequence, s);
+      time_pattern<reuse_distance::compact_tree>(pattern, "compact_tree", f, sequence, s);
+      time_pattern<reuse_distance::fenwick_tree>(pattern, "fenwick_tree", f, sequence, s);
+      time_pattern<reuse_distance::bplus_tree>(pattern, "bplus_tree", f, sequence, s);
+      time_pattern<reuse_distance::approximate_tree>(pattern, "approx_tree", f, sequence, s);
+    }
+  }
+}
+
+/**
+ * The block sizes of the multi benchmark, which are the levels of a typical HRD model.
+ */
+std::vector<std::uint64_t> const MULTI_BLOCK_SIZES = {64, 4096, 2097152};
+
+/**
+ * Time a separate tree per block size on a sequence of addresses, accessing the block of every level in turn (as the
+ * HRD profile does without threads).
+ *
+ * @return The distance of each access on every level, one row of distances per access.
+ */
+template <typename Tree>
+std::vector<double> time_levels(std::string const &pattern,
+    std::string const &name,
+    std::uint64_t footprint,
+    std::vector<std::uint64_t> const &sequence)
+{
+  auto const levels = MULTI_BLOCK_SIZES.size();
+  std::vector<double> distances(sequence.size() * levels);
+
+  std::vector<Tree> trees(levels);
+  stopwatch timer;
+  for(std::size_t i = 0; i < sequence.size(); i++) {
+    for(std::size_t level = 0; level < levels; ++level) {
+      distances[i * levels + level] = reuse_distance::access(trees[level], sequence[i] / MULTI_BLOCK_SIZES[level], i);
+    }
+  }
+  auto const ns = timer.ns_per(sequence.size());
+
+  std::size_t bytes = 0;
+  for(auto const &tree : trees) {
+    bytes += tree.memory_usage();
+  }
+
+  std::cout << std::setw(14) << pattern << std::setw(20) << name << std::setw(14) << footprint << std::setw(14) << ns
+            << std::setw(14) << static_cast<double>(bytes) / (1024.0 * 1024.0) << std::endl;
+
+  return distances;
+}
+
+/**
+ * Time a multi_granularity on a sequence of addresses, one access at a time.
+ *
+ * @return The distance of each access on every level, one row of distances per access.
+ */
+template <typename Tree>
+std::vector<double> time_multi(std::string const &pattern,
+    std::string const &name,
+    std::uint64_t footprint,
+    std::vector<std::uint64_t> const &sequence)
+{
+  auto const levels = MULTI_BLOCK_SIZES.size();
+  std::vector<double> distances(sequence.size() * levels);
+
+  reuse_distance::multi_granularity<Tree> tree(MULTI_BLOCK_SIZES);
+  stopwatch timer;
+  for(std::size_t i = 0; i < sequence.size(); i++) {
+    reuse_distance::access(tree, sequence[i], i, &distances[i * levels]);
+  }
+  auto const ns = timer.ns_per(sequence.size());
+
+  std::cout << std::setw(14) << pattern << std::setw(20) << name << std::setw(14) << footprint << std::setw(14) << ns
+            << std::setw(14) << static_cast<double>(tree.memory_usage()) / (1024.0 * 1024.0) << std::endl;
+
+  return distances;
+}
+
+/**
+ * Compare the multi_granularity to a separate tree per block size, on synthetic access patterns over a sweep of
+ * footprints (in 64-byte blocks).
+ *
+ * @throw std::runtime_error if the trees compute different distances.
+ */
+void benchmark_multi(settings const &s)
+{
+  std::vector<std::string> patterns = {"sequential", "uniform", "zipfian", "strided", "pointer-chase", "loop"};
+  if(s.pattern != "all") {
+    patterns = {s.pattern};
+  }
+
+  std::cout << std::fixed << std::setprecision(1);
+  std::cout << std::setw(14) << "pattern" << std::setw(20) << "tree" << std::setw(14) << "footprint"
+            << std::setw(14) << "access ns" << std::setw(14) << "tree MiB" << std::endl;
+
+  std::mt19937_64 rng(s.seed);
+  for(auto const &pattern : patterns) {
+    for(auto const f : footprints(s)) {
+      auto const sequence = generate_pattern(pattern, f, s.accesses, rng);
+
+      auto const expected = time_levels<reuse_distance::olken_tree>(pattern, "3 olken_tree", f, sequence);
+      auto const bplus = time_levels<reuse_distance::bplus_tree>(pattern, "3 bplus_tree", f, sequence);
+      auto const multi_olken = time_multi<reuse_distance::olken_tree>(pattern, "multi olken_tree", f, sequence);
+      auto const multi_bplus = time_multi<reuse_distance::bplus_tree>(pattern, "multi bplus_tree", f, sequence);
+
+      if(expected != bplus || expected != multi_olken || expected != multi_bplus) {
+        throw std::runtime_error("The multi_granularity disagrees with a tree per level.");
+      }
+    }
+  }
+}
+
+/**
+ * Time an olken_tree on a sequence of accesses, and measure the memory it holds at the end.
+ *
+ * @return The distance of each access.
+ */
+std::vector<double> time_window(std::string const &pattern,
+    std::string const &name,
+    std::uint64_t footprint,
+    std::vector<std::uint64_t> const &sequence,
+    reuse_distance::olken_tree tree)
+{
+  std::vector<double> distances(sequence.size());
+
+  stopwatch timer;
+  reuse_distance::access(tree, sequence.data(), sequence.size(), 0, distances.data());
+  auto const ns = timer.ns_per(sequence.size());
+
+  auto const tree_mib = static_cast<double>(tree.memory_usage()) / (1024.0 * 1024.0);
+  std::cout << std::setw(14) << pattern << std::setw(14) << name << std::setw(14) << footprint << std::setw(14) << ns
+            << std::setw(14) << tree.size() << std::setw(14) << tree_mib << std::endl;
+
+  return distances;
+}
+
+/**
+ * Compare an olken_tree that tracks every block to one that only tracks a window of the most recent blocks.
+ *
+ * @throw std::runtime_error if the windowed tree reports a distance within the window that the full tree does not.
+ */
+void benchmark_window(settings const &s)
+{
+  std::vector<std::string> patterns = {"sequential", "uniform", "zipfian", "strided", "pointer-chase", "loop"};
+  if(s.pattern != "all") {
+    patterns = {s.pattern};
+  }
+
+  std::cout << std::fixed << std::setprecision(1);
+  std::cout << std::setw(14) << "pattern" << std::setw(14) << "tree" << std::setw(14) << "footprint"
+            << std::setw(14) << "access ns" << std::setw(14) << "blocks" << std::setw(14) << "tree MiB" << std::endl;
+
+  auto const window = static_cast<double>(s.window);
+
+  std::mt19937_64 rng(s.seed);
+  for(auto const &pattern : patterns) {
+    for(auto const f : footprints(s)) {
+      auto const sequence = generate_pattern(pattern, f, s.accesses, rng);
+
+      auto const expected = time_window(pattern, "olken_tree", f, sequence, reuse_distance::olken_tree());
+      auto const actual =
+          time_window(pattern, "windowed", f, sequence, reuse_distance::olken_tree(s.window, 0));
+
+      for(std::size_t i = 0; i < expected.size(); i++) {
+        auto const far = std::isinf(expected[i]) || expected[i] >= window;
+        if(far ? !std::isinf(actual[i]) : actual[i] != expected[i]) {
+          throw std::runtime_error("The windowed olken_tree disagrees with the olken_tree.");
+        }
+      }
+    }
+  }
+}
+
+/** The largest difference in miss ratio the counter stacks may have from the exact curve. */
+constexpr double COUNTER_STACKS_TOLERANCE = 0.05;
+
+/** The number of accesses between two counters of the counter stacks. */
+constexpr std::uint64_t COUNTER_STACKS_STEP = 1024;
+
+/**
+ * The smallest footprint, in steps, whose curve is checked. The distances of the counter stacks are upper bounds at the
+ * granularity of a step, so on a stream of only a few steps they are off by more than the noise of the sketches.
+ */
+constexpr std::uint64_t COUNTER_STACKS_MIN_STEPS = 8;
+
+/**
+ * Compare the miss-ratio curve estimated by counter_stacks to the exact curve of an olken_tree, on streams where the
+ * noise of the sketches dominates: one without reuse, and one where about a tenth of the accesses are reuses.
+ *
+ * The curves of smaller footprints than COUNTER_STACKS_MIN_STEPS steps are reported, but not checked.
+ *
+ * @throw std::runtime_error if the estimated miss ratio of a cache size is off by more than the tolerance.
+ */
+void benchmark_counter_stacks(settings const &s)
+{
+  std::cout << std::fixed << std::setprecision(4);
+  std::cout << std::setw(14) << "stream" << std::setw(14) << "footprint" << std::setw(14) << "exact miss"
+            << std::setw(14) << "estimate miss" << std::setw(14) << "max error" << std::setw(14) << "checked"
+            << std::endl;
+
+  std::mt19937_64 rng(s.seed);
+  for(auto const f : footprints(s)) {
+    auto const checked = f >= COUNTER_STACKS_MIN_STEPS * COUNTER_STACKS_STEP;
+
+    std::vector<std::pair<std::string, std::vector<std::uint64_t>>> streams;
+    streams.emplace_back("no-reuse", generate_pattern("sequential", f, f, rng));
+    streams.emplace_back("low-reuse", generate_pattern("uniform", 5 * f, f, rng));
+
+    for(auto const &stream : streams) {
+      auto const &sequence = stream.second;
+
+      std::vector<double> distances(sequence.size());
+      reuse_distance::olken_tree tree;
+      reuse_distance::access(tree, sequence.data(), sequence.size(), 0, distances.data());
+      std::sort(distances.begin(), distances.end());
+
+      reuse_distance::counter_stacks stacks(COUNTER_STACKS_STEP);
+      for(auto const address : sequence) {
+        stacks.access(address);
+      }
+      stacks.flush();
+      auto const curve = stacks.miss_ratio_curve();
+
+      // A cache of c blocks misses on the accesses with a distance of at least c.
+      auto const exact_miss = [&distances](double c) {
+        auto const hits = std::lower_bound(distances.begin(), distances.end(), c) - distances.begin();
+        return 1.0 - static_cast<double>(hits) / static_cast<double>(distances.size());
+      };
+      auto const estimate_miss = [&curve](double c) {
+        auto const point = curve.upper_bound(c);
+        return point == curve.begin() ? 1.0 : std::prev(point)->second;
+      };
+
+      double error = 0.0;
+      for(std::uint64_t c = 1; c <= f; c *= 2) {
+        auto const size = static_cast<double>(c);
+        error = std::max(error, std::abs(exact_miss(size) - estimate_miss(size)));
+      }
+
+      auto const largest = static_cast<double>(f);
+      std::cout << std::setw(14) << stream.first << std::setw(14) << f << std::setw(14) << exact_miss(largest)
+                << std::setw(14) << estimate_miss(largest) << std::setw(14) << error << std::setw(14)
+                << (checked ? "yes" : "no") << std::endl;
+
+      if(checked && error > COUNTER_STACKS_TOLERANCE) {
+        throw std::runtime_error("The counter stacks disagree with the olken_tree on the " + stream.first + " stream.");
+      }
+    }
+  }
+}
+
+int main(int argc, char **argv)
+{
+  try {
+    // Parse the command line.
+    auto interface = create_command_line_interface();
+    auto const arguments = interface.parse(argc, argv);
+
+    // Check if help was requested.
+    if(arguments["help"]) {
+      print_usage(std::cout, interface);
+
+      return EXIT_SUCCESS;
+    }
+
+    settings s;
+    s.min_footprint = arguments["min"].as<std::uint64_t>(s.min_footprint);
+    s.max_footprint = arguments["max"].as<std::uint64_t>(s.max_footprint);
+    s.accesses = arguments["accesses"].as<std::uint64_t>(s.accesses);
+    s.queries = arguments["queries"].as<std::uint64_t>(s.queries);
+    s.error = arguments["error"].as<double>(s.error);
+    s.window = arguments["window"].as<std::uint64_t>(s.window);
+    s.seed = arguments["seed"].as<std::uint64_t>(s.seed);
+    s.pattern = arguments["pattern"].as<std::string>(s.pattern);
+
+    if(s.min_footprint == 0) {
+      throw std::runtime_error("The minimum footprint must be greater than zero.");
+    }
+
+    auto const benchmark = arguments["benchmark"].as<std::string>("index");
+    if(benchmark == "index") {
+      benchmark_index(s);
+    } else if(benchmark == "select") {
+      benchmark_select(s);
+    } else if(benchmark == "approximate") {
+      benchmark_approximate(s);
+    } else if(benchmark == "batch") {
+      benchmark_batch(s);
+    } else if(benchmark == "compact") {
+      benchmark_compact(s);
+    } else if(benchmark == "bplus") {
+      benchmark_bplus(s);
+    } else if(benchmark == "multi") {
+      benchmark_multi(s);
+    } else if(benchmark == "window") {
+      benchmark_window(s);
+    } else if(benchmark == "reuse-time") {
+      benchmark_reuse_time(s);
+    } else if(benchmark == "patterns") {
+      benchmark_patterns(s);
+    } else if(benchmark == "counter-stacks") {
+      benchmark_counter_stacks(s);
+    } else {
+      throw std::runtime_error("Unknown benchmark: " + benchmark);
+    }
+  } catch(std::exception const &e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,420 @@
+#ifndef REUSE_DISTANCE_ADDRESS_INDEX_HPP
+#define REUSE_DISTANCE_ADDRESS_INDEX_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include <reuse-distance/prefetch.hpp>
+#include <reuse-distance/stats.hpp>
+
+namespace reuse_distance {
+
+/**
+ * An open-addressing hashmap from memory addresses to small values.
+ *
+ * Slots are probed linearly and erased entries are back-shifted, so there are no tombstones and a lookup stops at the
+ * first empty slot. Keys are stored in blocks of eight, with the values of those eight keys stored directly after
+ * them. A probe sequence therefore scans a contiguous array of keys, and a hit touches the adjacent cache line for the
+ * value.
+ *
+ * @tparam Value A trivially copyable type (e.g., a pointer or an integer).
+ */
+template <typename Value>
+class address_index {
+public:
+  /**
+   * Constructor.
+   *
+   * @param capacity The number of addresses to reserve space for.
+   */
+  explicit address_index(std::size_t capacity = 0)
+  {
+    reserve(capacity);
+  }
+
+  /**
+   * @return true if the index is empty, false otherwise.
+   */
+  bool empty() const
+  {
+    return m_size == 0;
+  }
+
+  /**
+   * @return The number of addresses in the index.
+   */
+  std::size_t size() const
+  {
+    return m_size;
+  }
+
+  /**
+   * @return The number of bytes allocated for slots.
+   */
+  std::size_t memory_usage() const
+  {
+    return (m_mask + 1) / BLOCK_SIZE * sizeof(block);
+  }
+
+  /**
+   * @return The number of lookups by find() and insert(), if statistics are enabled (see STATS_ENABLED).
+   */
+  std::uint64_t lookups() const
+  {
+    return m_lookups;
+  }
+
+  /**
+   * @return The number of slots compared by find() and insert(), if statistics are enabled (see STATS_ENABLED).
+   */
+  std::uint64_t probes() const
+  {
+    return m_probes;
+  }
+
+  /**
+   * Find the value mapped to an address.
+   *
+   * @param address The address to search for.
+   *
+   * @return A pointer to the value, or nullptr if the address is not in the index.
+   */
+  Value *find(std::uint64_t address)
+  {
+    return const_cast<Value *>(static_cast<address_index const *>(this)->find(address));
+  }
+
+  /**
+   * Find the value mapped to an address.
+   *
+   * @param address The address to search for.
+   *
+   * @return A pointer to the value, or nullptr if the address is not in the index.
+   */
+  Value const *find(std::uint64_t address) const
+  {
+    if(address == EMPTY) {
+      return m_has_empty_key ? &m_empty_key_value : nullptr;
+    }
+
+    if(m_blocks == nullptr) {
+      return nullptr;
+    }
+
+    tally(m_lookups);
+    for(std::size_t i = home(address);; i = (i + 1) & m_mask) {
+      auto const key = key_at(i);
+      tally(m_probes);
+
+      if(key == address) {
+        return &value_at(i);
+      }
+
+      if(key == EMPTY) {
+        return nullptr;
+      }
+    }
+  }
+
+  /**
+   * Prefetch the slot an address hashes to, ahead of a lookup.
+   *
+   * @param address The address that will be searched for.
+   */
+  void prefetch(std::uint64_t address) const
+  {
+    if(m_blocks != nullptr && address != EMPTY) {
+      auto const slot = home(address);
+
+      reuse_distance::prefetch(&key_at(slot));
+      reuse_distance::prefetch(&value_at(slot));
+    }
+  }
+
+  /**
+   * Map an address to a value, unless the address is already mapped.
+   *
+   * @param address The address to insert.
+   * @param value The value to map to the address if it is not present.
+   *
+   * @return A pointer to the value mapped to the address, and true if the address was inserted.
+   */
+  std::pair<Value *, bool> insert(std::uint64_t address, Value const &value)
+  {
+    if(address == EMPTY) {
+      auto const inserted = !m_has_empty_key;
+      if(inserted) {
+        m_has_empty_key = true;
+        m_empty_key_value = value;
+        m_size++;
+      }
+
+      return {&m_empty_key_value, inserted};
+    }
+
+    if((m_size + 1) * MAX_LOAD_DENOMINATOR > (m_mask + 1) * MAX_LOAD_NUMERATOR) {
+      rehash(2 * (m_mask + 1));
+    }
+
+    tally(m_lookups);
+    for(std::size_t i = home(address);; i = (i + 1) & m_mask) {
+      auto &key = key_at(i);
+      tally(m_probes);
+
+      if(key == address) {
+        return {&value_at(i), false};
+      }
+
+      if(key == EMPTY) {
+        key = address;
+        value_at(i) = value;
+        m_size++;
+
+        return {&value_at(i), true};
+      }
+    }
+  }
+
+  /**
+   * Map an address to a value, replacing any existing mapping.
+   *
+   * @param address The address to map.
+   * @param value The value to map to.
+   */
+  void assign(std::uint64_t address, Value const &value)
+  {
+    auto const result = insert(address, value);
+
+    if(!result.second) {
+      *result.first = value;
+    }
+  }
+
+  /**
+   * Remove an address from the index.
+   *
+   * @param address The address to remove.
+   *
+   * @return true if the address was removed, false if it was not in the index.
+   */
+  bool erase(std::uint64_t address)
+  {
+    if(address == EMPTY) {
+      auto const erased = m_has_empty_key;
+      if(erased) {
+        m_has_empty_key = false;
+        m_size--;
+      }
+
+      return erased;
+    }
+
+    if(m_blocks == nullptr) {
+      return false;
+    }
+
+    std::size_t hole = home(address);
+    while(key_at(hole) != address) {
+      if(key_at(hole) == EMPTY) {
+        return false;
+      }
+
+      hole = (hole + 1) & m_mask;
+    }
+
+    // Shift later members of the probe sequence back into the hole so that lookups never need tombstones.
+    for(std::size_t i = (hole + 1) & m_mask; key_at(i) != EMPTY; i = (i + 1) & m_mask) {
+      auto const ideal = home(key_at(i));
+
+      // Only move the entry if its ideal slot is not cyclically in (hole, i].
+      auto const distance_to_hole = (hole - ideal) & m_mask;
+      auto const distance_to_slot = (i - ideal) & m_mask;
+      if(distance_to_hole < distance_to_slot) {
+        key_at(hole) = key_at(i);
+        value_at(hole) = value_at(i);
+        hole = i;
+      }
+    }
+
+    key_at(hole) = EMPTY;
+    m_size--;
+
+    return true;
+  }
+
+  /**
+   * Remove all addresses from the index, keeping the allocated slots.
+   */
+  void clear()
+  {
+    for(std::size_t i = 0; m_blocks != nullptr && i <= m_mask; i++) {
+      key_at(i) = EMPTY;
+    }
+
+    m_has_empty_key = false;
+    m_size = 0;
+  }
+
+  /**
+   * Allocate enough slots for a number of addresses.
+   *
+   * @param capacity The number of addresses.
+   */
+  void reserve(std::size_t capacity)
+  {
+    std::size_t slots = BLOCK_SIZE;
+    while(capacity * MAX_LOAD_DENOMINATOR > slots * MAX_LOAD_NUMERATOR) {
+      slots *= 2;
+    }
+
+    if(m_blocks == nullptr || slots > m_mask + 1) {
+      rehash(slots);
+    }
+  }
+
+  /**
+   * Visit every mapping in the index, in an unspecified order.
+   *
+   * The visitor may modify the values, but must not insert or erase addresses.
+   *
+   * @param visitor A callable that accepts an address and a reference to its value.
+   */
+  template <typename Visitor>
+  void for_each(Visitor &&visitor)
+  {
+    if(m_has_empty_key) {
+      visitor(EMPTY, m_empty_key_value);
+    }
+
+    for(std::size_t i = 0; m_blocks != nullptr && i <= m_mask; i++) {
+      if(key_at(i) != EMPTY) {
+        visitor(key_at(i), value_at(i));
+      }
+    }
+  }
+
+  /**
+   * Visit every mapping in the index, in an unspecified order.
+   *
+   * @param visitor A callable that accepts an address and a const reference to its value.
+   */
+  template <typename Visitor>
+  void for_each(Visitor &&visitor) const
+  {
+    if(m_has_empty_key) {
+      visitor(EMPTY, m_empty_key_value);
+    }
+
+    for(std::size_t i = 0; m_blocks != nullptr && i <= m_mask; i++) {
+      if(key_at(i) != EMPTY) {
+        visitor(key_at(i), value_at(i));
+      }
+    }
+  }
+
+private:
+  static_assert(std::is_trivially_copyable<Value>::value, "address_index only stores trivially copyable values.");
+
+  /// Marks a slot as unused; the address itself is stored out-of-line.
+  static constexpr std::uint64_t EMPTY = std::numeric_limits<std::uint64_t>::max();
+  /// The number of slots per block.
+  static constexpr std::size_t BLOCK_SIZE = 8;
+  /// The maximum load factor is 7/10.
+  static constexpr std::size_t MAX_LOAD_NUMERATOR = 7;
+  static constexpr std::size_t MAX_LOAD_DENOMINATOR = 10;
+
+  /**
+   * A group of slots: the keys are searched first, the values are only read on a match.
+   */
+  struct block {
+    std::uint64_t keys[BLOCK_SIZE];
+    Value values[BLOCK_SIZE];
+  };
+
+  std::unique_ptr<block[]> m_blocks;
+  std::size_t m_mask = 0;
+  unsigned m_shift = 64;
+  std::size_t m_size = 0;
+
+  bool m_has_empty_key = false;
+  Value m_empty_key_value{};
+
+  // The statistics of the probe sequences, only counted if statistics are enabled.
+  mutable std::uint64_t m_lookups = 0;
+  mutable std::uint64_t m_probes = 0;
+
+  std::size_t home(std::uint64_t address) const
+  {
+    // Fibonacci hashing: the high bits of the product are well mixed, even for strided addresses.
+    auto const hash = address * 0x9e3779b97f4a7c15ull;
+
+    return static_cast<std::size_t>(hash >> m_shift);
+  }
+
+  std::uint64_t &key_at(std::size_t slot)
+  {
+    return m_blocks[slot / BLOCK_SIZE].keys[slot % BLOCK_SIZE];
+  }
+
+  std::uint64_t const &key_at(std::size_t slot) const
+  {
+    return m_blocks[slot / BLOCK_SIZE].keys[slot % BLOCK_SIZE];
+  }
+
+  Value &value_at(std::size_t slot)
+  {
+    return m_blocks[slot / BLOCK_SIZE].values[slot % BLOCK_SIZE];
+  }
+
+  Value const &value_at(std::size_t slot) const
+  {
+    return m_blocks[slot / BLOCK_SIZE].values[slot % BLOCK_SIZE];
+  }
+
+  void rehash(std::size_t slots)
+  {
+    auto old_blocks = std::move(m_blocks);
+    auto const old_slots = old_blocks == nullptr ? 0 : m_mask + 1;
+
+    m_blocks.reset(new block[slots / BLOCK_SIZE]);
+    m_mask = slots - 1;
+
+    m_shift = 64;
+    for(std::size_t i = slots; i > 1; i /= 2) {
+      m_shift--;
+    }
+
+    for(std::size_t i = 0; i < slots; i++) {
+      key_at(i) = EMPTY;
+    }
+
+    for(std::size_t i = 0; i < old_slots; i++) {
+      auto const &old = old_blocks[i / BLOCK_SIZE];
+      auto const key = old.keys[i % BLOCK_SIZE];
+
+      if(key != EMPTY) {
+        std::size_t j = home(key);
+        while(key_at(j) != EMPTY) {
+          j = (j + 1) & m_mask;
+        }
+
+        key_at(j) = key;
+        value_at(j) = old.values[i % BLOCK_SIZE];
+      }
+    }
+  }
+};
+
+template <typename Value>
+constexpr std::uint64_t address_index<Value>::EMPTY;
+
+template <typename Value>
+constexpr std::size_t address_index<Value>::BLOCK_SIZE;
+
+} // namespace reuse_distance
+
+#endif //REUSE_DISTANCE_ADDRESS_INDEX_HPP
@@ -0,0 +1,84 @@
+#ifndef REUSE_DISTANCE_ALIGNED_ALLOCATOR_HPP
+#define REUSE_DISTANCE_ALIGNED_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+namespace reuse_distance {
+
+/** The size of a cache line on the targeted processors. */
+constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+/**
+ * An allocator that starts every allocation on a cache line, so a container of cache-line-sized elements never splits
+ * an element across two lines.
+ *
+ * The standard allocator only guarantees the alignment of a fundamental type before C++17, so a cache line and a
+ * pointer are allocated on top of each request, and the pointer returned by operator new is kept just before the
+ * aligned block.
+ *
+ * @tparam T The type of element to allocate.
+ */
+template <typename T>
+class cache_aligned_allocator {
+public:
+  using value_type = T;
+
+  cache_aligned_allocator() = default;
+
+  template <typename U>
+  cache_aligned_allocator(cache_aligned_allocator<U> const &)
+  {
+  }
+
+  /**
+   * Allocate memory for elements, starting on a cache line.
+   *
+   * @param count The number of elements.
+   *
+   * @return The aligned memory.
+   */
+  T *allocate(std::size_t count)
+  {
+    auto const bytes = count * sizeof(T) + CACHE_LINE_SIZE + sizeof(void *);
+    auto const raw = static_cast<char *>(::operator new(bytes));
+
+    auto const first = reinterpret_cast<std::uintptr_t>(raw + sizeof(void *));
+    auto const padding = (CACHE_LINE_SIZE - first % CACHE_LINE_SIZE) % CACHE_LINE_SIZE;
+    auto const aligned = raw + sizeof(void *) + padding;
+
+    std::memcpy(aligned - sizeof(void *), &raw, sizeof(void *));
+
+    return reinterpret_cast<T *>(aligned);
+  }
+
+  /**
+   * Release memory returned by allocate().
+   *
+   * @param memory The aligned memory.
+   */
+  void deallocate(T *memory, std::size_t)
+  {
+    void *raw;
+    std::memcpy(&raw, reinterpret_cast<char *>(memory) - sizeof(void *), sizeof(void *));
+
+    ::operator delete(raw);
+  }
+};
+
+template <typename T, typename U>
+bool operator==(cache_aligned_allocator<T> const &, cache_aligned_allocator<U> const &)
+{
+  return true;
+}
+
+template <typename T, typename U>
+bool operator!=(cache_aligned_allocator<T> const &, cache_aligned_allocator<U> const &)
+{
+  return false;
+}
+} // namespace reuse_distance
+
+#endif //REUSE_DISTANCE_ALIGNED_ALLOCATOR_HPP
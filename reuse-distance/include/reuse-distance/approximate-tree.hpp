@@ -0,0 +1,143 @@
+#ifndef REUSE_DISTANCE_APPROXIMATE_TREE_HPP
+#define REUSE_DISTANCE_APPROXIMATE_TREE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <reuse-distance/address-index.hpp>
+#include <reuse-distance/binary-indexed-tree.hpp>
+
+namespace reuse_distance {
+
+/**
+ * Approximate reuse-distance tracking with a bounded relative error.
+ *
+ * The time axis is divided into buckets, and each bucket counts the addresses whose last access falls in its time
+ * range. The stack distance of an address is the number of addresses in newer buckets, plus an estimate of how many
+ * addresses in its own bucket were accessed after it (half of the others). An address_index maps each address to the
+ * time of its last access, and a binary_indexed_tree sums the counts of the newer buckets.
+ *
+ * Every access opens a new bucket, and when the buckets run out they are compacted: walking from the newest to the
+ * oldest, adjacent buckets are merged as long as the merged bucket holds no more than 2e times the addresses in newer
+ * buckets, where e is the relative error. The number of addresses in newer buckets is a lower bound on the distance
+ * of every address in the bucket, so the estimate is within e of the exact distance. The merged buckets grow
+ * geometrically with their age, so only O(log(n) / e) of them survive each compaction.
+ *
+ * The approach follows Ding and Zhong in, "Predicting Whole-Program Locality through Reuse Distance Analysis."
+ */
+class approximate_tree {
+public:
+  /**
+   * Constructor.
+   *
+   * @param error The maximum relative error of a distance, in the range [0, 1).
+   * @param capacity The initial number of buckets.
+   *
+   * @throw std::invalid_argument if the error is out of range.
+   */
+  explicit approximate_tree(double error = 0.01, std::size_t capacity = 1024);
+
+  /**
+   * Check if the tree is empty.
+   *
+   * @return true if the tree is empty, false otherwise.
+   */
+  bool empty() const;
+
+  /**
+   * @return The number of unique addresses being tracked.
+   */
+  std::size_t size() const;
+
+  /**
+   * @return The maximum relative error of a distance.
+   */
+  double error() const;
+
+  /**
+   * @return The number of buckets in use, which is the size of the tree (as opposed to the index).
+   */
+  std::size_t buckets() const;
+
+  /**
+   * @return The number of bytes allocated for the buckets and the index.
+   */
+  std::size_t memory_usage() const;
+
+  /**
+   * Find the time of the last access to an address.
+   *
+   * @param address The memory address to search for.
+   *
+   * @return A pointer to the time, or nullptr if the address has not been accessed.
+   */
+  std::uint64_t const *find_address(std::uint64_t address) const;
+
+  /**
+   * Estimate the stack position of a time.
+   *
+   * @param time The time of the last access to an address.
+   *
+   * @return The estimated number of addresses accessed since the time.
+   */
+  double calculate_position(std::uint64_t time) const;
+
+  /**
+   * Prefetch the index slot of an address, ahead of touch().
+   *
+   * @param address The memory address that will be accessed.
+   */
+  void prefetch_address(std::uint64_t address) const;
+
+  /**
+   * Make an address the most recent access.
+   *
+   * @param address The address of the memory access.
+   *
+   * @return The estimated stack position of the previous access to the address, or infinity if there was none.
+   */
+  double touch(std::uint64_t address);
+
+  /**
+   * Stop tracking an address.
+   *
+   * Erasing addresses from newer buckets lowers the bound on the distances in older buckets, so the error is only
+   * guaranteed for distances measured after the next compaction.
+   *
+   * @param address The address to remove.
+   *
+   * @return true if the address was being tracked.
+   */
+  bool erase(std::uint64_t address);
+
+  /**
+   * Visit every address being tracked, in an unspecified order.
+   *
+   * @param visitor A callable that accepts an address.
+   */
+  template <typename Visitor>
+  void for_each(Visitor &&visitor) const
+  {
+    m_last_access.for_each([&visitor](std::uint64_t address, std::uint64_t) { visitor(address); });
+  }
+
+private:
+  double m_error;
+
+  address_index<std::uint64_t> m_last_access;
+
+  // The first time covered by each bucket (ascending), and the number of addresses last accessed in each bucket.
+  std::vector<std::uint64_t> m_first;
+  std::vector<std::uint32_t> m_count;
+  binary_indexed_tree m_counts;
+
+  // Logical time counter.
+  std::uint64_t m_time = 0;
+
+  std::size_t find_bucket(std::uint64_t time) const;
+  void compact();
+};
+} // namespace reuse_distance
+
+#endif //REUSE_DISTANCE_APPROXIMATE_TREE_HPP
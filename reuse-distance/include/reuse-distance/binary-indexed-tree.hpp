@@ -0,0 +1,80 @@
+#ifndef REUSE_DISTANCE_BINARY_INDEXED_TREE_HPP
+#define REUSE_DISTANCE_BINARY_INDEXED_TREE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace reuse_distance {
+
+/**
+ * A Fenwick tree of counters.
+ *
+ * The counters are stored implicitly in a flat array, such that both updating a counter and summing a prefix of the
+ * counters touch O(log n) elements of the array. There are no pointers and no rebalancing.
+ *
+ * The data structure follows the description by Fenwick in, "A new data structure for cumulative frequency tables."
+ */
+class binary_indexed_tree {
+public:
+  /**
+   * Constructor.
+   *
+   * @param size The number of counters, all initialized to zero.
+   */
+  explicit binary_indexed_tree(std::size_t size = 0);
+
+  /**
+   * @return The number of counters.
+   */
+  std::size_t size() const;
+
+  /**
+   * @return The number of bytes allocated for the counters.
+   */
+  std::size_t memory_usage() const;
+
+  /**
+   * Add to a counter.
+   *
+   * @param index The index of the counter.
+   * @param delta The value to add to the counter.
+   */
+  void add(std::size_t index, std::int32_t delta);
+
+  /**
+   * Sum the counters before an index.
+   *
+   * @param end One past the index of the last counter to include in the sum.
+   *
+   * @return The sum of counters [0, end).
+   */
+  std::uint64_t prefix_sum(std::size_t end) const;
+
+  /**
+   * Replace all counters.
+   *
+   * Complexity: O(n)
+   *
+   * @param size The new number of counters.
+   * @param ones The number of leading counters set to one, all others are set to zero.
+   */
+  void reset(std::size_t size, std::size_t ones);
+
+  /**
+   * Replace all counters.
+   *
+   * Complexity: O(n)
+   *
+   * @param size The new number of counters.
+   * @param counters The values of the leading counters, all others are set to zero.
+   */
+  void reset(std::size_t size, std::vector<std::uint32_t> const &counters);
+
+private:
+  // The implicit tree, where m_tree[i - 1] holds the sum of the counters (i - lowbit(i), i].
+  std::vector<std::uint32_t> m_tree;
+};
+} // namespace reuse_distance
+
+#endif //REUSE_DISTANCE_BINARY_INDEXED_TREE_HPP
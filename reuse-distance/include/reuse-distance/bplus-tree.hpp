@@ -0,0 +1,174 @@
+#ifndef REUSE_DISTANCE_BPLUS_TREE_HPP
+#define REUSE_DISTANCE_BPLUS_TREE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <reuse-distance/address-index.hpp>
+#include <reuse-distance/aligned-allocator.hpp>
+
+namespace reuse_distance {
+
+/**
+ * An order statistics tree with cache-line-sized nodes, for footprints where the olken_tree takes a cache miss on
+ * every one of its many levels.
+ *
+ * The keys are the times of the last access to each address, stored as 32-bit offsets from an epoch (as in the
+ * compact_tree), and an address_index maps each address to its key. A leaf holds 16 keys in one cache line, and an
+ * inner node holds the first key and the number of keys of up to 16 children in two cache lines, so a tree of 10^8
+ * addresses is 7 levels deep instead of 27. A node is searched by comparing the key against all of its keys at once
+ * (with SSE2 where available), which counts the smaller keys without a branch per key.
+ *
+ * Every new key is the latest time, so keys are only ever appended to the last leaf (after dropping any leaves that
+ * were started with later keys that have since been erased). Leaves are therefore kept in an array in key order, and
+ * each level of inner nodes is an array where node i covers the nodes 16i to 16i + 15 of the level below. A reused key
+ * is removed from its leaf and leaves a gap, which is compacted away (and, when the offsets run out, renumbered) once
+ * the leaves are less than half full. A compaction takes O(n) and follows at least n/2 accesses, so it costs O(1) per
+ * access.
+ *
+ * The tree holds at most 2^31 - 2 addresses.
+ */
+class bplus_tree {
+public:
+  /** The number of keys in a leaf, and the number of children of an inner node. */
+  static constexpr std::size_t FANOUT = 16;
+
+  /**
+   * A leaf, whose keys are in ascending order followed by unused keys of SENTINEL.
+   */
+  struct leaf {
+    std::uint32_t keys[FANOUT];
+  };
+
+  /**
+   * An inner node, where the children in use come first.
+   */
+  struct inner {
+    /** The first key ever stored below each child in ascending order, or SENTINEL if the child is unused. */
+    std::uint32_t keys[FANOUT];
+    /** The number of keys below each child. */
+    std::uint32_t counts[FANOUT];
+  };
+
+  /** The value of an unused key, which is greater than every key in use. */
+  static constexpr std::uint32_t SENTINEL = 0x7fffffff;
+
+  /**
+   * Check if the tree is empty.
+   *
+   * @return true if the tree is empty, false otherwise.
+   */
+  bool empty() const;
+
+  /**
+   * @return The number of unique addresses being tracked.
+   */
+  std::size_t size() const;
+
+  /**
+   * @return The number of bytes allocated for the nodes and the index.
+   */
+  std::size_t memory_usage() const;
+
+  /**
+   * @return The number of levels of the tree, including the leaves, or 0 if no key has been inserted.
+   */
+  std::size_t height() const;
+
+  /**
+   * Find the key of an address.
+   *
+   * @param address The memory address to search for.
+   *
+   * @return A pointer to the key, or nullptr if the address has not been accessed.
+   */
+  std::uint32_t const *find_address(std::uint64_t address) const;
+
+  /**
+   * @param key The key of an address.
+   *
+   * @return The time the address was last accessed.
+   */
+  std::uint64_t time_of(std::uint32_t key) const;
+
+  /**
+   * Calculate the position of a key in the stack (i.e., the number of keys that are later).
+   *
+   * Complexity: O(log n)
+   *
+   * @param key The key of an address.
+   *
+   * @return The stack position of the key.
+   */
+  double calculate_position(std::uint32_t key) const;
+
+  /**
+   * Prefetch the index slot of an address, ahead of touch().
+   *
+   * @param address The memory address that will be accessed.
+   */
+  void prefetch_address(std::uint64_t address) const;
+
+  /**
+   * Make an address the most recent access.
+   *
+   * Complexity: O(log n), amortised
+   *
+   * @param address The address of the memory access.
+   * @param time The time of the access, must be greater than the time of every address in the tree.
+   *
+   * @return The stack position of the previous access to the address, or infinity if there was none.
+   *
+   * @throw std::length_error if the tree is full.
+   * @throw std::invalid_argument if the time is not greater than the time of every address in the tree.
+   */
+  double touch(std::uint64_t address, std::uint64_t time);
+
+  /**
+   * Stop tracking an address.
+   *
+   * @param address The address to remove.
+   *
+   * @return true if the address was being tracked.
+   */
+  bool erase(std::uint64_t address);
+
+  /**
+   * Visit every address being tracked, in an unspecified order.
+   *
+   * @param visitor A callable that accepts an address.
+   */
+  template <typename Visitor>
+  void for_each(Visitor &&visitor) const
+  {
+    m_keys.for_each([&visitor](std::uint64_t address, std::uint32_t) { visitor(address); });
+  }
+
+private:
+  // The leaves in key order, and the inner nodes per level from the parents of the leaves up to the root.
+  std::vector<leaf, cache_aligned_allocator<leaf>> m_leaves;
+  std::vector<std::vector<inner, cache_aligned_allocator<inner>>> m_levels;
+
+  // The time that keys are offsets from.
+  std::uint64_t m_epoch = 0;
+
+  // The time of the latest key in the tree, unless the address with that key has been erased since.
+  std::uint64_t m_latest = 0;
+  bool m_latest_known = false;
+
+  address_index<std::uint32_t> m_keys;
+
+  std::uint64_t latest_time();
+  std::uint32_t offset(std::uint64_t time);
+  double remove(std::uint32_t key);
+  void append(std::uint32_t key);
+  void trim(std::uint32_t key);
+
+  std::vector<std::uint32_t> live_keys() const;
+  void renumber(std::uint64_t time);
+  void rebuild(std::vector<std::uint32_t> const &keys);
+};
+} // namespace reuse_distance
+
+#endif //REUSE_DISTANCE_BPLUS_TREE_HPP
@@ -0,0 +1,120 @@
+#ifndef REUSE_DISTANCE_BPLUS_HPP
+#define REUSE_DISTANCE_BPLUS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include <reuse-distance/bplus-tree.hpp>
+#include <reuse-distance/snapshot.hpp>
+
+namespace reuse_distance {
+
+/**
+ * Compute the stack distance for the given address.
+ *
+ * Complexity: O(log n)
+ *
+ * @param tree The tree to search.
+ * @param address The location of the time last accessed.
+ *
+ * @return The number of unique addresses that were referenced between the time last accessed and now.
+ */
+double compute_distance(bplus_tree const &tree, std::uint64_t address);
+
+/**
+ * Update the time last accessed and the mapping of the address.
+ *
+ * Complexity: O(log n) amortized
+ *
+ * @param tree The tree to update.
+ * @param address The address that has become the most recent reference.
+ * @param time The time of the access.
+ */
+void update(bplus_tree &tree, std::uint64_t address, std::uint64_t time);
+
+/**
+ * Compute the stack distance for the given address, then make it the most recent reference.
+ *
+ * Equivalent to compute_distance followed by update, but the index is probed once and the tree is searched once.
+ *
+ * Complexity: O(log n) amortized
+ *
+ * @param tree The tree to search and update.
+ * @param address The address being accessed.
+ * @param time The time of the access.
+ *
+ * @return The number of unique addresses that were referenced between the time last accessed and now.
+ */
+double access(bplus_tree &tree, std::uint64_t address, std::uint64_t time);
+
+/**
+ * Compute the stack distances of a batch of accesses, and make each address the most recent reference in order.
+ *
+ * Equivalent to calling access() for each address, but the index slots of upcoming addresses are prefetched while the
+ * current address is processed.
+ *
+ * @param tree The tree to search and update.
+ * @param addresses The addresses being accessed, in order.
+ * @param count The number of addresses.
+ * @param time The time of the first access, each following access is one time unit later.
+ * @param distances Receives the stack distance of each access, must hold count elements.
+ */
+void access(bplus_tree &tree,
+    std::uint64_t const *addresses,
+    std::size_t count,
+    std::uint64_t time,
+    double *distances);
+
+/**
+ * Stop tracking an address.
+ *
+ * Complexity: O(log n)
+ *
+ * @param tree The tree to erase from.
+ * @param address The address to remove.
+ *
+ * @return true if the address was being tracked.
+ */
+bool erase(bplus_tree &tree, std::uint64_t address);
+
+/**
+ * Stop tracking every address that matches a predicate.
+ *
+ * Complexity: O(n log n)
+ *
+ * @param tree The tree to erase from.
+ * @param predicate Returns true for the addresses to erase.
+ *
+ * @return The number of addresses that were erased.
+ */
+std::size_t erase_if(bplus_tree &tree, std::function<bool(std::uint64_t)> const &predicate);
+
+/**
+ * Capture the tracked addresses in order of recency.
+ *
+ * Complexity: O(n log n)
+ *
+ * @param tree The tree to capture.
+ * @param clock The logical time of the next access.
+ *
+ * @return A snapshot that restore() can rebuild the tree from.
+ */
+snapshot save(bplus_tree const &tree, std::uint64_t clock);
+
+/**
+ * Rebuild an empty tree from a snapshot.
+ *
+ * Complexity: O(n log n), the entries are appended from the least to the most recently used
+ *
+ * @param tree The empty tree to rebuild.
+ * @param s The snapshot to restore, from any backend.
+ *
+ * @throw std::invalid_argument if the tree is not empty, or the entries are not in descending order of time, before the
+ * clock.
+ */
+void restore(bplus_tree &tree, snapshot const &s);
+
+} // namespace reuse_distance
+
+#endif //REUSE_DISTANCE_BPLUS_HPP
@@ -0,0 +1,215 @@
+#ifndef REUSE_DISTANCE_COMPACT_TREE_HPP
+#define REUSE_DISTANCE_COMPACT_TREE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <reuse-distance/address-index.hpp>
+
+namespace reuse_distance {
+
+/**
+ * A memory-compact variant of the olken_tree.
+ *
+ * The tree is the same order statistics tree as the olken_tree, but the nodes live in one contiguous array and link to
+ * each other with 32-bit indices instead of pointers. The colour of a node is packed into the top bit of its subtree
+ * size, and its timestamp is stored as a 32-bit offset from an epoch. The address is only stored as the key of the
+ * hashmap, which maps it to a 32-bit index instead of a pointer. A node takes 20 bytes instead of 48.
+ *
+ * When a timestamp no longer fits in 32 bits after the epoch, the nodes are renumbered 0, 1, 2, ... in order and the
+ * epoch is moved, which keeps the order of the tree intact. The tree holds at most 2^31 - 1 addresses.
+ */
+class compact_tree {
+public:
+  /**
+   * The index of a node in the tree.
+   */
+  using node_index = std::uint32_t;
+
+  /**
+   * The index of the nil sentinel, which is never the index of a tracked address.
+   */
+  static constexpr node_index NIL = 0;
+
+  /**
+   * A node in the tree.
+   */
+  struct node {
+    /**
+     * The time last accessed, as an offset from the epoch of the tree.
+     */
+    std::uint32_t time;
+
+    /**
+     * The left subtree, right subtree, and parent.
+     */
+    node_index left;
+    node_index right;
+    node_index parent;
+
+    /**
+     * The weight of the node's subtree in the low 31 bits, and the top bit set if the node is red.
+     */
+    std::uint32_t size_and_colour;
+  };
+
+  /**
+   * Constructor.
+   *
+   * Sets up the nil sentinel.
+   */
+  compact_tree();
+
+  /**
+   * Check if the tree is empty.
+   *
+   * @return true if the tree is empty, false otherwise.
+   */
+  bool empty() const;
+
+  /**
+   * @return The number of nodes in the tree.
+   */
+  std::size_t size() const;
+
+  /**
+   * @return The number of bytes allocated for the nodes and the hashmap.
+   */
+  std::size_t memory_usage() const;
+
+  /**
+   * Measure the height of the tree, i.e., the number of nodes on the longest path from the root to a leaf.
+   *
+   * Complexity: O(n)
+   *
+   * @return The height of the tree, or 0 if the tree is empty.
+   */
+  std::size_t height() const;
+
+  /**
+   * Find the node with the next timestamp.
+   *
+   * @param x The node with the starting timestamp.
+   *
+   * @return The node with the next timestamp, or NIL if x is the most recently used node.
+   */
+  node_index successor(node_index x) const;
+
+  /**
+   * @return The node with the oldest timestamp, or NIL if the tree is empty.
+   */
+  node_index least_recently_used() const;
+
+  /**
+   * @param n A node in the tree.
+   *
+   * @return The time the node was last accessed.
+   */
+  std::uint64_t time_of(node_index n) const;
+
+  /**
+   * Calculate the position in the stack (i.e., the number of nodes with a later timestamp).
+   *
+   * @param n The node to find the position of.
+   *
+   * @return The stack position of the node.
+   */
+  double calculate_position(node_index n) const;
+
+  /**
+   * Find the node based on the memory address accessed.
+   *
+   * @param address The memory address to search for.
+   *
+   * @return The node that accessed that address, or NIL if the address has not been accessed.
+   */
+  node_index find_address(std::uint64_t address) const;
+
+  /**
+   * Prefetch the hashmap slot of an address, ahead of find_address().
+   *
+   * @param address The memory address that will be searched for.
+   */
+  void prefetch_address(std::uint64_t address) const;
+
+  /**
+   * Prefetch the node of an address, ahead of calculating its position.
+   *
+   * @param address The memory address that will be accessed.
+   */
+  void prefetch_node(std::uint64_t address) const;
+
+  /**
+   * Find the node for an address, inserting a new node if the address has not been seen before.
+   *
+   * @param time The time of the access, used if a new node is inserted.
+   * @param address The address of the memory access.
+   *
+   * @return The node for the address, and true if the node was inserted.
+   */
+  std::pair<node_index, bool> find_or_insert(std::uint64_t time, std::uint64_t address);
+
+  /**
+   * Make a node the most recently used node.
+   *
+   * @param n The node that has been accessed again.
+   * @param time The time of the access, must be greater than the time of every node in the tree.
+   */
+  void move_to_most_recent(node_index n, std::uint64_t time);
+
+  /**
+   * Delete the node of an address from the tree and the hashmap.
+   *
+   * @param address The address to remove.
+   *
+   * @return true if the address was being tracked.
+   */
+  bool erase(std::uint64_t address);
+
+  /**
+   * Visit every address being tracked, in an unspecified order.
+   *
+   * @param visitor A callable that accepts an address.
+   */
+  template <typename Visitor>
+  void for_each(Visitor &&visitor) const
+  {
+    m_hashmap.for_each([&visitor](std::uint64_t address, node_index) { visitor(address); });
+  }
+
+private:
+  // The nodes, where m_nodes[NIL] is the sentinel.
+  std::vector<node> m_nodes;
+  node_index m_root = NIL;
+  // The head of the list of erased nodes, linked through their parent index.
+  node_index m_free = NIL;
+
+  // The time that node timestamps are offsets from.
+  std::uint64_t m_epoch = 0;
+
+  address_index<node_index> m_hashmap;
+
+  node_index allocate();
+  std::uint32_t offset(std::uint64_t time);
+  void renumber(std::uint64_t time);
+
+  std::uint32_t size_of(node_index n) const;
+  void set_size(node_index n, std::uint32_t size);
+  bool is_red(node_index n) const;
+  void set_red(node_index n, bool red);
+
+  void attach(node_index z);
+  void detach(node_index z);
+  void transplant(node_index u, node_index v);
+
+  void fix_insert(node_index z);
+  void fix_delete(node_index x);
+
+  void rotate_left(node_index x);
+  void rotate_right(node_index y);
+};
+} // namespace reuse_distance
+
+#endif //REUSE_DISTANCE_COMPACT_TREE_HPP
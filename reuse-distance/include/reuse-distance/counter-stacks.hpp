@@ -0,0 +1,116 @@
+#ifndef REUSE_DISTANCE_COUNTER_STACKS_HPP
+#define REUSE_DISTANCE_COUNTER_STACKS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <reuse-distance/hyperloglog.hpp>
+
+namespace reuse_distance {
+
+/**
+ * Streaming reuse-distance histograms in sub-linear memory.
+ *
+ * The approach follows Wires et al. in, "Characterizing Storage Workloads with Counter Stacks." The trace is split
+ * into steps of a fixed number of accesses, and a new counter starts at the beginning of each step. A counter is a
+ * HyperLogLog sketch of the unique addresses accessed since it started, and every access is added to every counter.
+ *
+ * At the end of each step, the growth of a counter is the number of accesses in the step whose previous access came
+ * before the counter started (or that had no previous access). The difference in growth between two adjacent counters
+ * is therefore the number of accesses whose previous access fell between their start times, and their reuse distance
+ * is at most the value of the older counter. The growth of the oldest counter counts first accesses.
+ *
+ * A counter is pruned when its value is within a fraction of the next older counter, so the number of counters grows
+ * with the logarithm of the footprint rather than with the length of the trace. The distances are upper bounds at the
+ * granularity of a step and of the pruning. The noise of the sketches can make a difference negative; it is kept, so
+ * that the growth still adds up over the steps, and only the cumulative counts are fitted to be non-decreasing (by
+ * isotonic regression, so the noise does not bias the hit ratios either way).
+ */
+class counter_stacks {
+public:
+  /**
+   * Constructor.
+   *
+   * @param step The number of accesses between two counters.
+   * @param pruning A counter is pruned when it is within this fraction of the next older counter, in the range [0, 1).
+   * @param precision The precision of each HyperLogLog sketch (see reuse_distance::hyperloglog).
+   *
+   * @throw std::invalid_argument if the step is zero or an argument is out of range.
+   */
+  explicit counter_stacks(std::uint64_t step = 1024, double pruning = 0.02, unsigned precision = 12);
+
+  /**
+   * Add an access to the stream.
+   *
+   * Complexity: amortized O(1) per access, plus O(c) at the end of each step, where c is the number of counters
+   *
+   * @param address The address (or block) being accessed.
+   */
+  void access(std::uint64_t address);
+
+  /**
+   * End the current step early, so that every access so far is part of the histogram.
+   */
+  void flush();
+
+  /**
+   * @return The number of accesses so far.
+   */
+  std::uint64_t count() const;
+
+  /**
+   * @return The number of counters currently alive.
+   */
+  std::size_t counters() const;
+
+  /**
+   * @return The number of bytes allocated for the counters.
+   */
+  std::size_t memory_usage() const;
+
+  /**
+   * The reuse distances of the accesses in completed steps, where first accesses have a distance of infinity.
+   *
+   * @return The number of accesses with each reuse distance.
+   */
+  std::map<double, std::uint64_t> histogram() const;
+
+  /**
+   * The LRU miss ratio of every cache size at which it changes.
+   *
+   * @return The fraction of accesses in completed steps that miss in a fully associative LRU cache of each size (in
+   * addresses or blocks).
+   */
+  std::map<double, double> miss_ratio_curve() const;
+
+private:
+  struct counter {
+    hyperloglog sketch;
+    // The estimate at the end of the previous step.
+    double previous;
+  };
+
+  std::uint64_t m_step;
+  double m_pruning;
+  unsigned m_precision;
+
+  // The counters from the oldest to the newest, where the registers of an older counter are never below a newer one.
+  std::vector<counter> m_counters;
+
+  // The (fractional and possibly negative) number of accesses with each reuse distance.
+  std::map<double, double> m_distances;
+
+  std::uint64_t m_count = 0;
+  std::uint64_t m_step_count = 0;
+
+  void end_step();
+
+  // The number of accesses with at most each reuse distance, in ascending order of distance.
+  std::vector<std::pair<double, double>> cumulative() const;
+};
+} // namespace reuse_distance
+
+#endif //REUSE_DISTANCE_COUNTER_STACKS_HPP
@@ -0,0 +1,132 @@
+#ifndef REUSE_DISTANCE_FENWICK_TREE_HPP
+#define REUSE_DISTANCE_FENWICK_TREE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <reuse-distance/address-index.hpp>
+#include <reuse-distance/binary-indexed-tree.hpp>
+
+namespace reuse_distance {
+
+/**
+ * An array-based alternative to the olken_tree for reuse-distance tracking.
+ *
+ * Every access is given a slot on a logical time axis. A binary_indexed_tree holds a one for each slot that is the
+ * last access to some address, and an address_index maps each address to the slot of its last access. The stack
+ * distance of an address is then the number of ones after its slot, which is a single prefix sum.
+ *
+ * When the time axis runs out of slots it is compacted: the slots that are still the last access of an address are
+ * renumbered from zero (preserving their order), and the capacity is doubled if more than half the slots were live.
+ * Slots are therefore only ordered like time, so the time of the access in each slot is kept alongside it.
+ */
+class fenwick_tree {
+public:
+  /**
+   * Constructor.
+   *
+   * @param capacity The initial number of slots on the time axis.
+   */
+  explicit fenwick_tree(std::size_t capacity = 1024);
+
+  /**
+   * Check if the tree is empty.
+   *
+   * @return true if the tree is empty, false otherwise.
+   */
+  bool empty() const;
+
+  /**
+   * @return The number of unique addresses being tracked.
+   */
+  std::size_t size() const;
+
+  /**
+   * @return The number of slots on the time axis.
+   */
+  std::size_t capacity() const;
+
+  /**
+   * @return The number of bytes allocated for the time axis and the hashmap.
+   */
+  std::size_t memory_usage() const;
+
+  /**
+   * Find the slot of the last access to an address.
+   *
+   * @param address The memory address to search for.
+   *
+   * @return A pointer to the slot, or nullptr if the address has not been accessed.
+   */
+  std::uint64_t const *find_address(std::uint64_t address) const;
+
+  /**
+   * @param slot The slot of the last access to an address.
+   *
+   * @return The time the address was last accessed.
+   */
+  std::uint64_t time_of(std::uint64_t slot) const;
+
+  /**
+   * Calculate the stack position of a slot.
+   *
+   * @param slot The slot of the last access to an address.
+   *
+   * @return The number of addresses accessed since the slot, analogous to the stack position.
+   */
+  double calculate_position(std::uint64_t slot) const;
+
+  /**
+   * Prefetch the index slot of an address, ahead of touch().
+   *
+   * @param address The memory address that will be accessed.
+   */
+  void prefetch_address(std::uint64_t address) const;
+
+  /**
+   * Make an address the most recent access.
+   *
+   * @param address The address of the memory access.
+   * @param time The time of the access.
+   *
+   * @return The stack position of the previous access to the address, or infinity if there was none.
+   */
+  double touch(std::uint64_t address, std::uint64_t time);
+
+  /**
+   * Stop tracking an address.
+   *
+   * @param address The address to remove.
+   *
+   * @return true if the address was being tracked.
+   */
+  bool erase(std::uint64_t address);
+
+  /**
+   * Visit every address being tracked, in an unspecified order.
+   *
+   * @param visitor A callable that accepts an address.
+   */
+  template <typename Visitor>
+  void for_each(Visitor &&visitor) const
+  {
+    m_last_access.for_each([&visitor](std::uint64_t address, std::uint64_t) { visitor(address); });
+  }
+
+private:
+  address_index<std::uint64_t> m_last_access;
+  binary_indexed_tree m_live;
+  std::vector<bool> m_is_live;
+  // The time of the access in each slot.
+  std::vector<std::uint64_t> m_times;
+
+  // The next free slot on the time axis.
+  std::uint64_t m_next = 0;
+
+  std::uint64_t allocate_slot();
+  void compact();
+};
+} // namespace reuse_distance
+
+#endif //REUSE_DISTANCE_FENWICK_TREE_HPP
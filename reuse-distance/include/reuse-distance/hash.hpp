@@ -0,0 +1,29 @@
+#ifndef REUSE_DISTANCE_HASH_HPP
+#define REUSE_DISTANCE_HASH_HPP
+
+#include <cstdint>
+
+namespace reuse_distance {
+
+/**
+ * Hash a memory address (or block) so that nearby addresses are spread across the whole 64-bit range.
+ *
+ * This is the finalizer of splitmix64, which is a bijection, so distinct addresses never collide.
+ *
+ * @param address The address to hash.
+ *
+ * @return The hash of the address.
+ */
+inline std::uint64_t hash(std::uint64_t address)
+{
+  address ^= address >> 30u;
+  address *= 0xbf58476d1ce4e5b9ull;
+  address ^= address >> 27u;
+  address *= 0x94d049bb133111ebull;
+  address ^= address >> 31u;
+
+  return address;
+}
+} // namespace reuse_distance
+
+#endif //REUSE_DISTANCE_HASH_HPP
@@ -0,0 +1,62 @@
+#ifndef REUSE_DISTANCE_HYPERLOGLOG_HPP
+#define REUSE_DISTANCE_HYPERLOGLOG_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace reuse_distance {
+
+/**
+ * Estimates the number of unique addresses in a stream in a fixed amount of memory.
+ *
+ * The sketch follows Flajolet et al. in, "HyperLogLog: the analysis of a near-optimal cardinality estimation
+ * algorithm." The top bits of a hashed address select one of 2^p registers, and the register keeps the longest run of
+ * leading zeros (plus one) seen in the remaining bits. The relative standard error of the estimate is about
+ * 1.04 / sqrt(2^p), e.g., 1.6% with the default precision of 12 (4 KiB of registers).
+ */
+class hyperloglog {
+public:
+  /**
+   * Constructor.
+   *
+   * @param precision The number of hash bits that select a register, in the range [4, 18].
+   *
+   * @throw std::invalid_argument if the precision is out of range.
+   */
+  explicit hyperloglog(unsigned precision = 12);
+
+  /**
+   * Add a hashed address to the sketch.
+   *
+   * @param hash The hash of the address (see reuse_distance::hash).
+   *
+   * @return true if a register was raised, false if the sketch is unchanged.
+   */
+  bool insert(std::uint64_t hash);
+
+  /**
+   * Estimate the number of unique addresses added to the sketch.
+   *
+   * Complexity: O(1)
+   *
+   * @return The estimated number of unique addresses.
+   */
+  double estimate() const;
+
+  /**
+   * @return The number of bytes allocated for the registers.
+   */
+  std::size_t memory_usage() const;
+
+private:
+  unsigned m_precision;
+  std::vector<std::uint8_t> m_registers;
+
+  // The sum of 2^-r over the registers, and the number of registers that are still zero, kept up to date by insert().
+  double m_sum;
+  std::size_t m_zeros;
+};
+} // namespace reuse_distance
+
+#endif //REUSE_DISTANCE_HYPERLOGLOG_HPP
@@ -0,0 +1,226 @@
+#ifndef REUSE_DISTANCE_MULTI_GRANULARITY_HPP
+#define REUSE_DISTANCE_MULTI_GRANULARITY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include <reuse-distance/snapshot.hpp>
+
+namespace reuse_distance {
+
+/**
+ * Computes the reuse distances of blocks of several power-of-two sizes in one pass over the accesses.
+ *
+ * Each level keeps its own tree, whose size follows the number of blocks on that level. The blocks are nested, so
+ * consecutive accesses often fall in the same block on the coarser levels, and such a block is still the most recent
+ * one on its level. Its reuse distance is 0 and touching it would not change the stack, so the level is skipped without
+ * hashing the block or updating the tree. On the 2 MiB level of a typical trace, nearly every access is skipped.
+ *
+ * A level only counts the accesses that reach its tree, so each level has its own clock.
+ *
+ * @tparam Tree The reuse-distance backend of each level (olken_tree, compact_tree, fenwick_tree, or bplus_tree).
+ */
+template <typename Tree>
+class multi_granularity {
+public:
+  /**
+   * Constructor.
+   *
+   * @param block_sizes The block size of each level, which must be powers of two in ascending order.
+   *
+   * @throw std::invalid_argument if there are no block sizes, or they are not ascending powers of two.
+   */
+  explicit multi_granularity(std::vector<std::uint64_t> block_sizes);
+
+  /**
+   * @return The number of levels.
+   */
+  std::size_t levels() const;
+
+  /**
+   * @return The block size of each level.
+   */
+  std::vector<std::uint64_t> const &block_sizes() const;
+
+  /**
+   * Check if every level is empty.
+   *
+   * @return true if no block is being tracked, false otherwise.
+   */
+  bool empty() const;
+
+  /**
+   * @param level The index of a level.
+   *
+   * @return The tree of the level, which tracks block numbers (i.e., addresses divided by the block size).
+   */
+  Tree const &level(std::size_t level) const;
+
+  /**
+   * @param level The index of a level.
+   *
+   * @return The logical time of the next access to reach the tree of the level.
+   */
+  std::uint64_t clock(std::size_t level) const;
+
+  /**
+   * @return The number of bytes allocated by the trees of all levels.
+   */
+  std::size_t memory_usage() const;
+
+  /**
+   * Prefetch the index slot of an address on the smallest level, which is the level least likely to be skipped.
+   *
+   * @param address The memory address that will be accessed.
+   */
+  void prefetch_address(std::uint64_t address) const;
+
+  /**
+   * Make an address the most recent access on every level.
+   *
+   * @param address The address of the memory access.
+   * @param distances Receives the stack distance of the block of the address on each level, or infinity if it was not
+   * accessed before. Must hold levels() elements.
+   */
+  void touch(std::uint64_t address, double *distances);
+
+  /**
+   * Make each address of a batch the most recent access on every level, in order.
+   *
+   * The blocks of a level that reach its tree are accessed as one batch, on several threads if requested (see
+   * parallel_access()).
+   *
+   * @param addresses The addresses being accessed, in order.
+   * @param count The number of addresses.
+   * @param distances Receives the stack distances of each access on every level, one row of levels() elements per
+   * access. Must hold count * levels() elements.
+   * @param threads The maximum number of threads to use.
+   */
+  void touch(std::uint64_t const *addresses, std::size_t count, double *distances, std::size_t threads = 1);
+
+  /**
+   * Stop tracking every block of one level that matches a predicate.
+   *
+   * @param level The index of the level.
+   * @param predicate Returns true for the block numbers to erase.
+   *
+   * @return The number of blocks that were erased.
+   */
+  std::size_t erase_if(std::size_t level, std::function<bool(std::uint64_t)> const &predicate);
+
+  /**
+   * Rebuild the empty trees of every level from a snapshot per level.
+   *
+   * @param snapshots The snapshot of the block numbers of each level, from any backend.
+   *
+   * @throw std::invalid_argument if a tree is not empty, or the number of snapshots is not the number of levels.
+   */
+  void restore(std::vector<snapshot> const &snapshots);
+
+private:
+  std::vector<std::uint64_t> m_block_sizes;
+  // The number of low address bits dropped to get the block on each level.
+  std::vector<unsigned> m_shifts;
+
+  // The most recent block of a level, if it is known.
+  struct recent_block {
+    std::uint64_t block = 0;
+    bool known = false;
+  };
+
+  std::vector<Tree> m_trees;
+  std::vector<std::uint64_t> m_clocks;
+  std::vector<recent_block> m_recent;
+};
+
+/**
+ * Compute the stack distance of an access on every level, then make it the most recent reference.
+ *
+ * Equivalent to calling access() on a separate tree per level with the block of the address, but a level is skipped
+ * when the access falls in its most recent block.
+ *
+ * Complexity: O(L log n), for L levels
+ *
+ * @param tree The levels to search and update.
+ * @param address The address being accessed.
+ * @param time The time of the access (unused, each level keeps its own clock).
+ * @param distances Receives the number of unique blocks referenced since the block was last accessed on each level, or
+ * infinity if it was not. Must hold tree.levels() elements.
+ */
+template <typename Tree>
+inline void access(multi_granularity<Tree> &tree, std::uint64_t address, std::uint64_t, double *distances)
+{
+  tree.touch(address, distances);
+}
+
+/**
+ * Compute the stack distances of a batch of accesses on every level, and make each address the most recent reference
+ * in order.
+ *
+ * Equivalent to calling access() for each address, but the blocks of each level are accessed as a batch, which
+ * prefetches the index slots of upcoming blocks.
+ *
+ * @param tree The levels to search and update.
+ * @param addresses The addresses being accessed, in order.
+ * @param count The number of addresses.
+ * @param time The time of the first access (unused, each level keeps its own clock).
+ * @param distances Receives the stack distances of each access on every level, one row of tree.levels() elements per
+ * access. Must hold count * tree.levels() elements.
+ */
+template <typename Tree>
+inline void access(multi_granularity<Tree> &tree,
+    std::uint64_t const *addresses,
+    std::size_t count,
+    std::uint64_t,
+    double *distances)
+{
+  tree.touch(addresses, count, distances);
+}
+
+/**
+ * Stop tracking every block of one level that matches a predicate.
+ *
+ * @param tree The levels to erase from.
+ * @param level The index of the level.
+ * @param predicate Returns true for the block numbers to erase.
+ *
+ * @return The number of blocks that were erased.
+ */
+template <typename Tree>
+inline std::size_t erase_if(multi_granularity<Tree> &tree,
+    std::size_t level,
+    std::function<bool(std::uint64_t)> const &predicate)
+{
+  return tree.erase_if(level, predicate);
+}
+
+/**
+ * Capture the tracked blocks of one level in order of recency.
+ *
+ * @param tree The levels to capture.
+ * @param level The index of the level.
+ *
+ * @return A snapshot of the block numbers on the clock of the level, which restore() can rebuild the level from.
+ */
+template <typename Tree>
+snapshot save(multi_granularity<Tree> const &tree, std::size_t level);
+
+/**
+ * Rebuild empty levels from a snapshot per level.
+ *
+ * @param tree The empty levels to rebuild.
+ * @param snapshots The snapshot of the block numbers of each level, from any backend.
+ *
+ * @throw std::invalid_argument if a level is not empty, or the number of snapshots is not the number of levels.
+ */
+template <typename Tree>
+inline void restore(multi_granularity<Tree> &tree, std::vector<snapshot> const &snapshots)
+{
+  tree.restore(snapshots);
+}
+
+} // namespace reuse_distance
+
+#endif //REUSE_DISTANCE_MULTI_GRANULARITY_HPP
@@ -0,0 +1,114 @@
+#ifndef REUSE_DISTANCE_NODE_POOL_HPP
+#define REUSE_DISTANCE_NODE_POOL_HPP
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace reuse_distance {
+
+/**
+ * A slab allocator for fixed-size objects.
+ *
+ * Objects are carved out of large contiguous chunks. Released objects are kept on an intrusive free list and are
+ * recycled by the next allocation, so a steady-state workload never returns to the system allocator. All chunks are
+ * freed when the pool is destroyed.
+ *
+ * @tparam T The type of object to allocate, must be trivially destructible.
+ */
+template <typename T>
+class node_pool {
+public:
+  /**
+   * Constructor.
+   *
+   * @param chunk_size The number of objects in each chunk.
+   */
+  explicit node_pool(std::size_t chunk_size = 4096) : m_chunk_size(chunk_size)
+  {
+  }
+
+  /**
+   * Construct an object in the pool.
+   *
+   * @param args The arguments forwarded to the constructor of T.
+   *
+   * @return A pointer to the constructed object.
+   */
+  template <typename... Args>
+  T *allocate(Args &&... args)
+  {
+    void *memory = nullptr;
+
+    if(m_free != nullptr) {
+      // Recycle the most recently released slot.
+      memory = m_free;
+      m_free = m_free->next;
+    } else {
+      if(m_next == m_chunk_size || m_chunks.empty()) {
+        m_chunks.emplace_back(new slot[m_chunk_size]);
+        m_next = 0;
+      }
+
+      memory = &m_chunks.back()[m_next++];
+    }
+
+    return new(memory) T(std::forward<Args>(args)...);
+  }
+
+  /**
+   * Return an object to the pool.
+   *
+   * @param object The object to release, must have been allocated by this pool.
+   */
+  void deallocate(T *object)
+  {
+    object->~T();
+
+    auto released = new(object) free_slot;
+    released->next = m_free;
+    m_free = released;
+  }
+
+  /**
+   * @return The number of bytes reserved by the pool.
+   */
+  std::size_t capacity() const
+  {
+    return m_chunks.size() * m_chunk_size * sizeof(slot);
+  }
+
+private:
+  static_assert(std::is_trivially_destructible<T>::value, "node_pool does not destroy live objects.");
+
+  /**
+   * An unused slot, linked to the next unused slot.
+   */
+  struct free_slot {
+    free_slot *next;
+  };
+
+  /**
+   * Storage large enough for either a T or a free_slot.
+   */
+  union slot {
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type object;
+    free_slot link;
+
+    slot()
+    {
+    }
+  };
+
+  std::size_t m_chunk_size;
+  std::size_t m_next = 0;
+
+  std::vector<std::unique_ptr<slot[]>> m_chunks;
+  free_slot *m_free = nullptr;
+};
+} // namespace reuse_distance
+
+#endif //REUSE_DISTANCE_NODE_POOL_HPP
@@ -3,7 +3,13 @@
 
 #include <cstdint>
 #include <memory>
-#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <reuse-distance/address-index.hpp>
+#include <reuse-distance/node-pool.hpp>
+#include <reuse-distance/snapshot.hpp>
+#include <reuse-distance/stats.hpp>
 
 namespace reuse_distance {
 
@@ -13,11 +19,20 @@ namespace reuse_distance {
  * The data structure follows the description by Olken in, "Efficient methods for calculating the success function of
  * fixed space replacement policies."
  *
- * There are actually two data structures: an ordered statistics tree and a hashmap.
+ * There are actually two data structures: an ordered statistics tree and a hashmap. The hashmap is an open-addressing
+ * address_index, so finding a node usually costs a single cache miss.
  *
  * The tree is key'd according to the logical time (i.e., order) of memory accesses. The hashmap is indexed based on
  * the address of the memory access. In this way, the hashmap can find a node from the tree in O(1) , and the tree can
  * be used to compute the reuse distance in O(log n).
+ *
+ * Nodes are allocated from a slab pool owned by the tree. Erased nodes are recycled by later inserts, and all nodes are
+ * released when the tree is destroyed.
+ *
+ * A windowed tree only tracks the recent past: nodes beyond a maximum stack position, or last accessed more than a
+ * maximum number of accesses ago, are evicted from the least recently used end. A reuse beyond that horizon is
+ * reported as infinity, like a first access, so the memory of a streaming trace is bounded by the window rather than
+ * by its footprint.
  */
 class olken_tree {
 public:
@@ -78,6 +93,35 @@ public:
     node *parent = nullptr;
   };
 
+  /**
+   * The work done on the hot paths of the tree, for relating its throughput to the shape of the tree and the
+   * behaviour of the hashmap. The counters are only updated if statistics are enabled (see STATS_ENABLED).
+   */
+  struct statistics {
+    /** The number of nodes linked into the tree, by inserts and by moves to the most recent position. */
+    std::uint64_t attaches = 0;
+    /** The number of nodes unlinked from the tree, by erases and by moves to the most recent position. */
+    std::uint64_t detaches = 0;
+    /** The number of rotations that rebalanced the tree after linking a node. */
+    std::uint64_t attach_rotations = 0;
+    /** The number of rotations that rebalanced the tree after unlinking a node. */
+    std::uint64_t detach_rotations = 0;
+    /** The number of stack positions calculated. */
+    std::uint64_t positions = 0;
+    /** The number of parents visited while calculating stack positions. */
+    std::uint64_t position_steps = 0;
+    /** The number of hashmap lookups. */
+    std::uint64_t lookups = 0;
+    /** The number of hashmap slots compared by those lookups. */
+    std::uint64_t probes = 0;
+    /** The number of nodes evicted by the window. */
+    std::uint64_t evictions = 0;
+    /** The number of nodes in the tree. */
+    std::size_t nodes = 0;
+    /** The height of the tree. */
+    std::size_t height = 0;
+  };
+
   /**
    * Constructor.
    *
@@ -85,6 +129,15 @@ public:
    */
   olken_tree();
 
+  /**
+   * Constructor of a windowed tree.
+   *
+   * @param max_distance The number of most recently used nodes to keep, or 0 to keep every node.
+   * @param max_age The number of accesses after which a node that has not been reused is evicted, or 0 to never evict
+   * a node for its age.
+   */
+  olken_tree(std::size_t max_distance, std::uint64_t max_age);
+
   /**
    * Check if the tree is empty.
    *
@@ -97,6 +150,39 @@ public:
    */
   std::size_t size() const;
 
+  /**
+   * @return The number of bytes allocated for the nodes and the hashmap.
+   */
+  std::size_t memory_usage() const;
+
+  /**
+   * @return The number of most recently used nodes that are kept, or 0 if the stack position is not bounded.
+   */
+  std::size_t max_distance() const;
+
+  /**
+   * @return The number of accesses a node is kept for without being reused, or 0 if the age is not bounded.
+   */
+  std::uint64_t max_age() const;
+
+  /**
+   * Measure the height of the tree, i.e., the number of nodes on the longest path from the root to a leaf.
+   *
+   * Complexity: O(n)
+   *
+   * @return The height of the tree, or 0 if the tree is empty.
+   */
+  std::size_t height() const;
+
+  /**
+   * Collect the counters of the tree, along with its current size and height.
+   *
+   * Complexity: O(n) to measure the height, or O(1) if statistics are disabled
+   *
+   * @return The statistics of the tree since it was created.
+   */
+  statistics stats() const;
+
   /**
    * Find the node with the next timestamp.
    *
@@ -136,6 +222,19 @@ public:
    */
   double calculate_position(node const *n) const;
 
+  /**
+   * Find the node at a stack position.
+   *
+   * Descends from the root using the subtree weights, i.e., the inverse of calculate_position.
+   *
+   * Complexity: O(log n)
+   *
+   * @param distance The stack position, where 0 is the most recently used node.
+   *
+   * @return The node at that stack position, or nullptr if the distance is not less than the size of the tree.
+   */
+  node *select_by_distance(std::size_t distance) const;
+
   /**
    * Find the node based on the memory address accessed.
    *
@@ -145,6 +244,21 @@ public:
    */
   node *find_address(std::uint64_t address) const;
 
+  /**
+   * Prefetch the hashmap slot of an address, ahead of find_address().
+   *
+   * @param address The memory address that will be searched for.
+   */
+  void prefetch_address(std::uint64_t address) const;
+
+  /**
+   * Prefetch the node of an address, ahead of calculating its position. The hashmap slot should have been prefetched
+   * first, as the node is found through the hashmap.
+   *
+   * @param address The memory address that will be accessed.
+   */
+  void prefetch_node(std::uint64_t address) const;
+
   /**
    * Add a node to the tree and hashmap.
    *
@@ -155,6 +269,29 @@ public:
    */
   olken_tree::node *insert(std::uint64_t time, std::uint64_t address);
 
+  /**
+   * Find the node for an address, inserting a new node if the address has not been seen before.
+   *
+   * Only probes the hashmap once.
+   *
+   * @param time The time of the access, used if a new node is inserted.
+   * @param address The address of the memory access.
+   *
+   * @return The node for the address, and true if the node was inserted.
+   */
+  std::pair<node *, bool> find_or_insert(std::uint64_t time, std::uint64_t address);
+
+  /**
+   * Make a node the most recently used node.
+   *
+   * The node is unlinked from the tree and linked back in with a new timestamp. The node itself is neither freed nor
+   * reallocated, so its hashmap entry remains valid.
+   *
+   * @param n The node that has been accessed again.
+   * @param time The time of the access, must be greater than the time of every node in the tree.
+   */
+  void move_to_most_recent(node *n, std::uint64_t time);
+
   /**
    * Delete a node from the tree and the hashmap.
    *
@@ -162,17 +299,63 @@ public:
    */
   void erase(node *z);
 
+  /**
+   * Evict the least recently used nodes that are beyond the window of the tree.
+   *
+   * A node is beyond the window if there are at least max_distance() more recent nodes, or if it was last accessed more
+   * than max_age() accesses before the given time. Does nothing if the tree is not windowed.
+   *
+   * Complexity: O(log n) per evicted node, amortised O(1) otherwise
+   *
+   * @param time The time of the next access.
+   *
+   * @return The number of nodes that were evicted.
+   */
+  std::size_t expire(std::uint64_t time);
+
+  /**
+   * Build an empty tree from the entries of a snapshot.
+   *
+   * The nodes are linked into a balanced tree directly from the sorted entries, rather than inserted one at a time.
+   *
+   * Complexity: O(n)
+   *
+   * @param entries The addresses and their times, in strictly descending order of time.
+   *
+   * @throw std::invalid_argument if the tree is not empty, or the entries are not in descending order of time.
+   * @throw std::runtime_error if an address appears more than once.
+   */
+  void build(std::vector<snapshot_entry> const &entries);
+
 private:
   std::unique_ptr<node> m_nil;
   node *m_root;
 
-  std::unordered_map<std::uint64_t, olken_tree::node *> m_hashmap;
+  node_pool<node> m_pool;
+
+  address_index<olken_tree::node *> m_hashmap;
+
+  std::size_t m_max_distance = 0;
+  std::uint64_t m_max_age = 0;
+
+  // A lower bound on the time of the least recently used node, so expire() only walks to it when it may be too old.
+  std::uint64_t m_oldest = 0;
+
+  // The counters of the hot paths, some of which are updated by const lookups.
+  mutable statistics m_stats;
+
+  void attach(node *z);
+  void detach(node *z);
+  void transplant(node *u, node *v);
 
   void fix_insert(node *z);
   void fix_delete(node *x);
 
-  void rotate_left(node *x);
-  void rotate_right(node *y);
+  void rotate_left(node *x, std::uint64_t &rotations);
+  void rotate_right(node *y, std::uint64_t &rotations);
+
+  node *link(std::vector<node *> const &nodes, std::size_t first, std::size_t last, node *parent, std::size_t depth,
+      std::size_t deepest);
 };
 } // namespace reuse_distance
 
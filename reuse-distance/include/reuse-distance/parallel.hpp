@@ -0,0 +1,60 @@
+#ifndef REUSE_DISTANCE_PARALLEL_HPP
+#define REUSE_DISTANCE_PARALLEL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <reuse-distance/approximate.hpp>
+#include <reuse-distance/bplus.hpp>
+#include <reuse-distance/compact.hpp>
+#include <reuse-distance/fenwick.hpp>
+#include <reuse-distance/olken.hpp>
+#include <reuse-distance/reuse-time.hpp>
+
+namespace reuse_distance {
+
+/**
+ * Compute the stack distances of a batch of accesses on several threads, and make each address the most recent
+ * reference in the order of the batch.
+ *
+ * The batch is split into one chunk per thread, and each thread computes the distances within its chunk using a local
+ * olken_tree. A reuse within a chunk only spans addresses of the same chunk, so its local distance is exact. The first
+ * access to each address in a chunk is then resolved on the shared tree, one chunk at a time: accessing the first
+ * accesses in order leaves exactly the addresses referenced since the previous access above each of them. Finally, the
+ * addresses of the chunk are reinserted in the order of their last access. The distances are the same as calling
+ * access() for each address in turn.
+ *
+ * Complexity: O((n / t + u) log n), where t is the number of threads and u is the number of unique addresses per chunk
+ *
+ * @tparam Tree The reuse-distance backend of the shared tree (e.g., reuse_distance::olken_tree).
+ *
+ * @param tree The tree to search and update.
+ * @param addresses The addresses being accessed, in order.
+ * @param time The time of the first access, each following access is one time unit later.
+ * @param distances The stack distance of each access, resized to the number of addresses.
+ * @param threads The maximum number of threads to use.
+ */
+template <typename Tree>
+void parallel_access(Tree &tree,
+    std::vector<std::uint64_t> const &addresses,
+    std::uint64_t time,
+    std::vector<double> &distances,
+    std::size_t threads);
+
+/**
+ * Measure the reuse times of a batch of accesses.
+ *
+ * A reuse time only depends on the time of the previous access, which is not known inside a chunk, and measuring one
+ * costs a single lookup. The batch is therefore processed on the calling thread.
+ */
+template <>
+void parallel_access(reuse_time_tracker &tracker,
+    std::vector<std::uint64_t> const &addresses,
+    std::uint64_t time,
+    std::vector<double> &reuse_times,
+    std::size_t threads);
+
+} // namespace reuse_distance
+
+#endif //REUSE_DISTANCE_PARALLEL_HPP
@@ -0,0 +1,28 @@
+#ifndef REUSE_DISTANCE_PREFETCH_HPP
+#define REUSE_DISTANCE_PREFETCH_HPP
+
+#include <cstddef>
+
+namespace reuse_distance {
+
+/** How many accesses ahead of the current one the batched functions prefetch. */
+constexpr std::size_t PREFETCH_DISTANCE = 8;
+
+/**
+ * Hint that a memory location will be read soon, so the cache line can be fetched while other work is done.
+ *
+ * The hint is a no-op on compilers without a prefetch intrinsic.
+ *
+ * @param location The memory location that will be read.
+ */
+inline void prefetch(void const *location)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_prefetch(location);
+#else
+  static_cast<void>(location);
+#endif
+}
+} // namespace reuse_distance
+
+#endif //REUSE_DISTANCE_PREFETCH_HPP
@@ -0,0 +1,98 @@
+#ifndef REUSE_DISTANCE_REUSE_TIME_TRACKER_HPP
+#define REUSE_DISTANCE_REUSE_TIME_TRACKER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+
+#include <reuse-distance/address-index.hpp>
+
+namespace reuse_distance {
+
+/**
+ * A lightweight alternative to the reuse-distance trees that measures reuse times.
+ *
+ * The reuse time of an access is the number of accesses (to any address) since the previous access to the same
+ * address. It only needs the time of the last access to each address, so an access costs a single lookup in an
+ * address_index and there is no tree to maintain. The tracker also keeps a histogram of every reuse time it measures,
+ * from which a statstack can estimate the corresponding reuse distances.
+ */
+class reuse_time_tracker {
+public:
+  /**
+   * Check if the tracker is empty.
+   *
+   * @return true if no addresses are tracked, false otherwise.
+   */
+  bool empty() const;
+
+  /**
+   * @return The number of unique addresses being tracked.
+   */
+  std::size_t size() const;
+
+  /**
+   * Find the time of the last access to an address.
+   *
+   * @param address The memory address to search for.
+   *
+   * @return A pointer to the time, or nullptr if the address has not been accessed.
+   */
+  std::uint64_t const *find_address(std::uint64_t address) const;
+
+  /**
+   * Prefetch the index slot of an address, ahead of touch().
+   *
+   * @param address The memory address that will be accessed.
+   */
+  void prefetch_address(std::uint64_t address) const;
+
+  /**
+   * Make an address the most recent access, and record its reuse time.
+   *
+   * @param address The address of the memory access.
+   *
+   * @return The number of accesses between the previous access to the address and this one, or infinity if there was
+   * none.
+   */
+  double touch(std::uint64_t address);
+
+  /**
+   * Stop tracking an address. The reuse times already recorded are kept.
+   *
+   * @param address The address to remove.
+   *
+   * @return true if the address was being tracked.
+   */
+  bool erase(std::uint64_t address);
+
+  /**
+   * Visit every address being tracked, in an unspecified order.
+   *
+   * @param visitor A callable that accepts an address.
+   */
+  template <typename Visitor>
+  void for_each(Visitor &&visitor) const
+  {
+    m_last_access.for_each([&visitor](std::uint64_t address, std::uint64_t) { visitor(address); });
+  }
+
+  /**
+   * @return The number of accesses with each reuse time, where first accesses have a reuse time of infinity.
+   */
+  std::map<double, std::uint64_t> histogram() const;
+
+private:
+  address_index<std::uint64_t> m_last_access;
+
+  // The number of accesses with each finite reuse time, and with no previous access.
+  std::unordered_map<std::uint64_t, std::uint64_t> m_reuse_times;
+  std::uint64_t m_first_accesses = 0;
+
+  // Logical time counter.
+  std::uint64_t m_time = 0;
+};
+} // namespace reuse_distance
+
+#endif //REUSE_DISTANCE_REUSE_TIME_TRACKER_HPP
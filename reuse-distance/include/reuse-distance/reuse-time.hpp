@@ -0,0 +1,82 @@
+#ifndef REUSE_DISTANCE_REUSE_TIME_HPP
+#define REUSE_DISTANCE_REUSE_TIME_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include <reuse-distance/reuse-time-tracker.hpp>
+
+namespace reuse_distance {
+
+/**
+ * Update the time last accessed and record the reuse time of the address.
+ *
+ * The reuse_time_tracker keeps its own logical clock, so only the order of calls matters.
+ *
+ * Complexity: O(1) amortized
+ *
+ * @param tracker The tracker to update.
+ * @param address The address that has become the most recent reference.
+ * @param time The time of the access (unused).
+ */
+void update(reuse_time_tracker &tracker, std::uint64_t address, std::uint64_t time);
+
+/**
+ * Measure the reuse time of the given address, then make it the most recent reference.
+ *
+ * Complexity: O(1) amortized
+ *
+ * @param tracker The tracker to search and update.
+ * @param address The address being accessed.
+ * @param time The time of the access (unused).
+ *
+ * @return The number of accesses between the time last accessed and now, or infinity for the first access.
+ */
+double access(reuse_time_tracker &tracker, std::uint64_t address, std::uint64_t time);
+
+/**
+ * Measure the reuse times of a batch of accesses, and make each address the most recent reference in order.
+ *
+ * Equivalent to calling access() for each address, but the index slots of upcoming addresses are prefetched while the
+ * current address is processed, so the cache misses of several accesses overlap.
+ *
+ * @param tracker The tracker to search and update.
+ * @param addresses The addresses being accessed, in order.
+ * @param count The number of addresses.
+ * @param time The time of the first access (unused).
+ * @param reuse_times Receives the reuse time of each access, must hold count elements.
+ */
+void access(reuse_time_tracker &tracker,
+    std::uint64_t const *addresses,
+    std::size_t count,
+    std::uint64_t time,
+    double *reuse_times);
+
+/**
+ * Stop tracking an address.
+ *
+ * Complexity: O(1)
+ *
+ * @param tracker The tracker to erase from.
+ * @param address The address to remove.
+ *
+ * @return true if the address was being tracked.
+ */
+bool erase(reuse_time_tracker &tracker, std::uint64_t address);
+
+/**
+ * Stop tracking every address that matches a predicate.
+ *
+ * Complexity: O(n)
+ *
+ * @param tracker The tracker to erase from.
+ * @param predicate Returns true for the addresses to erase.
+ *
+ * @return The number of addresses that were erased.
+ */
+std::size_t erase_if(reuse_time_tracker &tracker, std::function<bool(std::uint64_t)> const &predicate);
+
+} // namespace reuse_distance
+
+#endif //REUSE_DISTANCE_REUSE_TIME_HPP
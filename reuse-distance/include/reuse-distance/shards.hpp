@@ -0,0 +1,110 @@
+#ifndef REUSE_DISTANCE_SHARDS_HPP
+#define REUSE_DISTANCE_SHARDS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <unordered_set>
+
+namespace reuse_distance {
+
+/**
+ * Spatially hashed sampling of memory addresses.
+ *
+ * The sampling follows Waldspurger et al. in, "Efficient MRC Construction with SHARDS." An address is sampled if its
+ * hash falls under a threshold, so every access to a sampled address is tracked and every access to any other address
+ * is ignored. Reuse distances measured over the sampled addresses are scaled up by the inverse of the sampling rate.
+ *
+ * The sampling rate is always a power of two (i.e., 1/2^k), so distances and counts are scaled by an exact integer. In
+ * fixed-size mode the rate is halved whenever more than a maximum number of addresses are being tracked, and the
+ * addresses that are no longer sampled must be evicted by the caller.
+ */
+class shards {
+public:
+  /**
+   * Constructor.
+   *
+   * @param rate The fraction of addresses to sample, rounded down to a power of two. A rate of 1 samples everything.
+   * @param max_samples The maximum number of addresses to track, or 0 for a fixed sampling rate.
+   */
+  explicit shards(double rate = 1.0, std::size_t max_samples = 0);
+
+  /**
+   * Check if an address is sampled at the current rate.
+   *
+   * @param address The address (or block) being accessed.
+   *
+   * @return true if accesses to the address should be tracked.
+   */
+  bool sample(std::uint64_t address) const;
+
+  /**
+   * Start tracking a sampled address that has not been seen before.
+   *
+   * In fixed-size mode, this may lower the sampling rate.
+   *
+   * @param address The newly sampled address.
+   *
+   * @return true if the sampling rate was lowered, in which case the caller must evict all tracked addresses for which
+   * sample() is now false.
+   */
+  bool track(std::uint64_t address);
+
+  /**
+   * Check if a sampled address is being tracked, i.e., track() was called for it and it has not been dropped since.
+   *
+   * @param address The address (or block) being accessed.
+   *
+   * @return true if the address is tracked (always false in fixed-rate mode).
+   */
+  bool tracking(std::uint64_t address) const;
+
+  /**
+   * @return The fraction of addresses that are sampled.
+   */
+  double rate() const;
+
+  /**
+   * @return The inverse of the sampling rate, i.e., the number of accesses each sampled access stands for.
+   */
+  std::uint64_t scale() const;
+
+  /**
+   * @return The number of addresses being tracked (only counted in fixed-size mode).
+   */
+  std::size_t tracked() const;
+
+  /**
+   * @return The maximum number of addresses to track, or 0 for a fixed sampling rate.
+   */
+  std::size_t max_samples() const;
+
+  /**
+   * Write the sampling rate and the tracked addresses, in the binary format of reuse_distance::write_snapshot.
+   *
+   * @param stream The binary stream to write to.
+   *
+   * @throw std::runtime_error if the stream fails.
+   */
+  void save(std::ostream &stream) const;
+
+  /**
+   * Replace the sampling rate and the tracked addresses with those written by save().
+   *
+   * @param stream The binary stream to read from.
+   *
+   * @throw std::runtime_error if the stream does not hold a valid sampler.
+   */
+  void restore(std::istream &stream);
+
+private:
+  // An address is sampled if the top m_shift bits of its hash are zero.
+  unsigned m_shift = 0;
+
+  std::size_t m_max_samples;
+  std::unordered_set<std::uint64_t> m_tracked;
+};
+} // namespace reuse_distance
+
+#endif //REUSE_DISTANCE_SHARDS_HPP
@@ -0,0 +1,84 @@
+#ifndef REUSE_DISTANCE_SNAPSHOT_HPP
+#define REUSE_DISTANCE_SNAPSHOT_HPP
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+namespace reuse_distance {
+
+/**
+ * An address being tracked, and the time it was last accessed.
+ */
+struct snapshot_entry {
+  std::uint64_t time;
+  std::uint64_t address;
+};
+
+/**
+ * The state of a reuse-distance backend, from which an equivalent backend can be rebuilt.
+ *
+ * Every backend computes distances from the recency order of the tracked addresses alone, so a snapshot taken from one
+ * backend can be restored into any other. The times only need to be ordered and less than the clock.
+ */
+struct snapshot {
+  /**
+   * The logical time of the next access.
+   */
+  std::uint64_t clock = 0;
+
+  /**
+   * The tracked addresses from the most to the least recently used, i.e., in strictly descending order of time.
+   */
+  std::vector<snapshot_entry> entries;
+};
+
+/**
+ * Sort entries into the order of a snapshot, from the most to the least recently used.
+ *
+ * @param entries The entries to sort.
+ */
+void sort_by_recency(std::vector<snapshot_entry> &entries);
+
+/**
+ * Write a snapshot in a compact binary format.
+ *
+ * The gaps between consecutive times and between consecutive addresses are written as variable-length integers, so a
+ * snapshot usually takes a few bytes per address.
+ *
+ * @param stream The binary stream to write to.
+ * @param s The snapshot to write.
+ *
+ * @throw std::invalid_argument if the entries are not in descending order of time, or a time is not before the clock.
+ * @throw std::runtime_error if the stream fails.
+ */
+void write_snapshot(std::ostream &stream, snapshot const &s);
+
+/**
+ * Read a snapshot written by write_snapshot().
+ *
+ * @param stream The binary stream to read from.
+ *
+ * @return The snapshot.
+ *
+ * @throw std::runtime_error if the stream does not hold a valid snapshot.
+ */
+snapshot read_snapshot(std::istream &stream);
+
+/**
+ * Write an unsigned integer in 7-bit groups, least significant first.
+ *
+ * @throw std::runtime_error if the stream fails.
+ */
+void write_varint(std::ostream &stream, std::uint64_t value);
+
+/**
+ * Read an unsigned integer written by write_varint().
+ *
+ * @throw std::runtime_error if the stream ends or the integer is malformed.
+ */
+std::uint64_t read_varint(std::istream &stream);
+} // namespace reuse_distance
+
+#endif //REUSE_DISTANCE_SNAPSHOT_HPP
@@ -0,0 +1,35 @@
+#ifndef REUSE_DISTANCE_STATS_HPP
+#define REUSE_DISTANCE_STATS_HPP
+
+#include <cstdint>
+
+namespace reuse_distance {
+
+/**
+ * Whether the trees count the work done on their hot paths, which is enabled by the REUSE_DISTANCE_STATS CMake option.
+ * Without it, every counter stays at zero and counting compiles to nothing.
+ */
+#ifdef REUSE_DISTANCE_STATS
+constexpr bool STATS_ENABLED = true;
+#else
+constexpr bool STATS_ENABLED = false;
+#endif
+
+/**
+ * Add to a statistics counter, if statistics are enabled.
+ *
+ * @param counter The counter to add to.
+ * @param amount The amount to add.
+ */
+inline void tally(std::uint64_t &counter, std::uint64_t amount = 1)
+{
+#ifdef REUSE_DISTANCE_STATS
+  counter += amount;
+#else
+  static_cast<void>(counter);
+  static_cast<void>(amount);
+#endif
+}
+} // namespace reuse_distance
+
+#endif //REUSE_DISTANCE_STATS_HPP
@@ -0,0 +1,63 @@
+#ifndef REUSE_DISTANCE_STATSTACK_HPP
+#define REUSE_DISTANCE_STATSTACK_HPP
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+namespace reuse_distance {
+
+/**
+ * Estimates reuse distances from a distribution of reuse times.
+ *
+ * The estimate follows Eklov and Hagersten in, "StatStack: Efficient Modeling of LRU Caches." An access inside the
+ * reuse window of another access adds a unique address to its stack distance if that access is the last one to its
+ * address inside the window, i.e., if its own (forward) reuse time reaches past the end of the window. Assuming the
+ * distribution of reuse times is the same throughout the trace, the expected stack distance of a reuse time r is
+ *
+ *     sd(r) = P(R >= 1) + P(R >= 2) + ... + P(R >= r),
+ *
+ * where R is the reuse time of a random access and first accesses have an infinite reuse time.
+ */
+class statstack {
+public:
+  /**
+   * Constructor.
+   *
+   * @param reuse_times The number of accesses with each reuse time, where first accesses have a reuse time of infinity.
+   */
+  explicit statstack(std::map<double, std::uint64_t> const &reuse_times);
+
+  /**
+   * Estimate the stack distance of a reuse time.
+   *
+   * Complexity: O(log n), where n is the number of distinct reuse times
+   *
+   * @param reuse_time The number of accesses between two accesses to the same address.
+   *
+   * @return The expected number of unique addresses referenced between the two accesses, or infinity if the reuse time
+   * is infinite.
+   */
+  double distance(double reuse_time) const;
+
+  /**
+   * Convert a histogram of reuse times into a histogram of reuse distances.
+   *
+   * The estimated distances are rounded to the nearest integer, so reuse times with the same estimate share a bin.
+   *
+   * @param reuse_times The number of accesses with each reuse time.
+   *
+   * @return The number of accesses with each estimated reuse distance.
+   */
+  std::map<double, std::uint64_t> convert(std::map<double, std::uint64_t> const &reuse_times) const;
+
+private:
+  // The distinct finite reuse times in ascending order, and the estimated stack distance of each one.
+  std::vector<double> m_times;
+  std::vector<double> m_distances;
+  // The fraction of accesses with a reuse time of at least each of m_times (and, at the end, of infinity).
+  std::vector<double> m_at_least;
+};
+} // namespace reuse_distance
+
+#endif //REUSE_DISTANCE_STATSTACK_HPP
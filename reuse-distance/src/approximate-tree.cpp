@@ -0,0 +1,163 @@
+#include "reuse-distance/approximate-tree.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace reuse_distance {
+
+approximate_tree::approximate_tree(double error, std::size_t capacity)
+    : m_error(error), m_counts(capacity > 0 ? capacity : 1)
+{
+  if(!(error >= 0.0 && error < 1.0)) {
+    throw std::invalid_argument("The relative error must be in the range [0, 1).");
+  }
+
+  m_first.reserve(m_counts.size());
+  m_count.reserve(m_counts.size());
+}
+
+bool approximate_tree::empty() const
+{
+  return m_last_access.empty();
+}
+
+std::size_t approximate_tree::size() const
+{
+  return m_last_access.size();
+}
+
+double approximate_tree::error() const
+{
+  return m_error;
+}
+
+std::size_t approximate_tree::buckets() const
+{
+  return m_first.size();
+}
+
+std::size_t approximate_tree::memory_usage() const
+{
+  return m_first.capacity() * sizeof(std::uint64_t) + m_count.capacity() * sizeof(std::uint32_t)
+         + m_counts.memory_usage() + m_last_access.memory_usage();
+}
+
+std::uint64_t const *approximate_tree::find_address(std::uint64_t address) const
+{
+  return m_last_access.find(address);
+}
+
+double approximate_tree::calculate_position(std::uint64_t time) const
+{
+  auto const bucket = find_bucket(time);
+
+  // The addresses in newer buckets were all accessed after the time.
+  auto const newer = size() - m_counts.prefix_sum(bucket + 1);
+
+  // On average, half of the other addresses in the same bucket were accessed after the time.
+  auto const same = (m_count[bucket] - 1) / 2;
+
+  return static_cast<double>(newer + same);
+}
+
+void approximate_tree::prefetch_address(std::uint64_t address) const
+{
+  m_last_access.prefetch(address);
+}
+
+double approximate_tree::touch(std::uint64_t address)
+{
+  double distance = std::numeric_limits<double>::infinity();
+
+  auto const entry = m_last_access.insert(address, m_time);
+  if(!entry.second) {
+    distance = calculate_position(*entry.first);
+
+    auto const bucket = find_bucket(*entry.first);
+    m_count[bucket]--;
+    m_counts.add(bucket, -1);
+  }
+
+  // Compaction only rewrites the buckets, so the entry is still valid afterwards.
+  if(m_first.size() == m_counts.size()) {
+    compact();
+  }
+
+  m_first.push_back(m_time);
+  m_count.push_back(1);
+  m_counts.add(m_first.size() - 1, 1);
+
+  *entry.first = m_time++;
+
+  return distance;
+}
+
+bool approximate_tree::erase(std::uint64_t address)
+{
+  auto const time = m_last_access.find(address);
+  if(time == nullptr) {
+    return false;
+  }
+
+  auto const bucket = find_bucket(*time);
+  m_count[bucket]--;
+  m_counts.add(bucket, -1);
+
+  return m_last_access.erase(address);
+}
+
+std::size_t approximate_tree::find_bucket(std::uint64_t time) const
+{
+  assert(!m_first.empty() && m_first.front() <= time);
+
+  auto const after = std::upper_bound(m_first.begin(), m_first.end(), time);
+
+  return static_cast<std::size_t>(after - m_first.begin()) - 1;
+}
+
+void approximate_tree::compact()
+{
+  // Merge from the newest to the oldest bucket, so the merged buckets are built in descending order.
+  std::vector<std::uint64_t> first;
+  std::vector<std::uint32_t> count;
+
+  // The number of addresses in the merged buckets that are newer than the one being built.
+  std::uint64_t newer = 0;
+
+  for(auto i = m_first.size(); i-- > 0;) {
+    // An estimate from a bucket of c addresses is off by at most (c - 1) / 2, rounded up.
+    auto const limit = 2 * static_cast<std::uint64_t>(std::floor(m_error * static_cast<double>(newer))) + 1;
+
+    if(!count.empty() && std::uint64_t{count.back()} + m_count[i] <= limit) {
+      first.back() = m_first[i];
+      count.back() += m_count[i];
+    } else {
+      if(!count.empty()) {
+        newer += count.back();
+      }
+
+      first.push_back(m_first[i]);
+      count.push_back(m_count[i]);
+    }
+  }
+
+  std::reverse(first.begin(), first.end());
+  std::reverse(count.begin(), count.end());
+
+  // Grow the buckets if compaction would not free at least half of them.
+  auto new_capacity = m_counts.size();
+  while(2 * first.size() > new_capacity) {
+    new_capacity *= 2;
+  }
+
+  m_counts.reset(new_capacity, count);
+
+  m_first = std::move(first);
+  m_count = std::move(count);
+  m_first.reserve(new_capacity);
+  m_count.reserve(new_capacity);
+}
+} // namespace reuse_distance
@@ -0,0 +1,95 @@
+#include "reuse-distance/approximate.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace reuse_distance {
+
+double compute_distance(approximate_tree const &tree, std::uint64_t address)
+{
+  auto const slot = tree.find_address(address); // O(1)
+
+  if(slot == nullptr) {
+    return std::numeric_limits<double>::infinity();
+  }
+
+  return tree.calculate_position(*slot);
+}
+
+void update(approximate_tree &tree, std::uint64_t address, std::uint64_t)
+{
+  tree.touch(address);
+}
+
+double access(approximate_tree &tree, std::uint64_t address, std::uint64_t)
+{
+  return tree.touch(address);
+}
+
+void access(approximate_tree &tree,
+    std::uint64_t const *addresses,
+    std::size_t count,
+    std::uint64_t time,
+    double *distances)
+{
+  for(std::size_t i = 0; i < std::min(count, PREFETCH_DISTANCE); i++) {
+    tree.prefetch_address(addresses[i]);
+  }
+
+  for(std::size_t i = 0; i < count; i++) {
+    if(i + PREFETCH_DISTANCE < count) {
+      tree.prefetch_address(addresses[i + PREFETCH_DISTANCE]);
+    }
+
+    distances[i] = access(tree, addresses[i], time + i);
+  }
+}
+
+bool erase(approximate_tree &tree, std::uint64_t address)
+{
+  return tree.erase(address);
+}
+
+std::size_t erase_if(approximate_tree &tree, std::function<bool(std::uint64_t)> const &predicate)
+{
+  std::vector<std::uint64_t> matches;
+
+  tree.for_each([&predicate, &matches](std::uint64_t address) {
+    if(predicate(address)) {
+      matches.push_back(address);
+    }
+  });
+
+  for(auto const address : matches) {
+    tree.erase(address);
+  }
+
+  return matches.size();
+}
+
+snapshot save(approximate_tree const &tree, std::uint64_t clock)
+{
+  snapshot s;
+  s.clock = clock;
+  s.entries.reserve(tree.size());
+
+  tree.for_each([&tree, &s](std::uint64_t address) { s.entries.push_back({*tree.find_address(address), address}); });
+  sort_by_recency(s.entries);
+
+  return s;
+}
+
+void restore(approximate_tree &tree, snapshot const &s)
+{
+  if(!tree.empty()) {
+    throw std::invalid_argument("Only an empty tree can be restored from a snapshot.");
+  }
+
+  for(auto e = s.entries.rbegin(); e != s.entries.rend(); ++e) {
+    update(tree, e->address, e->time);
+  }
+}
+
+} // namespace reuse_distance
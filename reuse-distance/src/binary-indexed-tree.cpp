@@ -0,0 +1,80 @@
+#include "reuse-distance/binary-indexed-tree.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace reuse_distance {
+
+inline std::size_t lowbit(std::size_t i)
+{
+  return i & (~i + 1);
+}
+
+binary_indexed_tree::binary_indexed_tree(std::size_t size) : m_tree(size, 0)
+{
+}
+
+std::size_t binary_indexed_tree::size() const
+{
+  return m_tree.size();
+}
+
+std::size_t binary_indexed_tree::memory_usage() const
+{
+  return m_tree.capacity() * sizeof(std::uint32_t);
+}
+
+void binary_indexed_tree::add(std::size_t index, std::int32_t delta)
+{
+  assert(index < m_tree.size());
+
+  for(auto i = index + 1; i <= m_tree.size(); i += lowbit(i)) {
+    m_tree[i - 1] = static_cast<std::uint32_t>(static_cast<std::int64_t>(m_tree[i - 1]) + delta);
+  }
+}
+
+std::uint64_t binary_indexed_tree::prefix_sum(std::size_t end) const
+{
+  assert(end <= m_tree.size());
+
+  std::uint64_t sum = 0;
+  for(auto i = end; i > 0; i -= lowbit(i)) {
+    sum += m_tree[i - 1];
+  }
+
+  return sum;
+}
+
+void binary_indexed_tree::reset(std::size_t size, std::size_t ones)
+{
+  assert(ones <= size);
+
+  m_tree.assign(size, 0);
+
+  // Each element covers the counters (i - lowbit(i), i], so count how many of those are in the leading ones.
+  for(std::size_t i = 1; i <= size; i++) {
+    auto const first = i - lowbit(i);
+
+    if(first < ones) {
+      m_tree[i - 1] = static_cast<std::uint32_t>(std::min(i, ones) - first);
+    }
+  }
+}
+
+void binary_indexed_tree::reset(std::size_t size, std::vector<std::uint32_t> const &counters)
+{
+  assert(counters.size() <= size);
+
+  m_tree.assign(size, 0);
+  std::copy(counters.begin(), counters.end(), m_tree.begin());
+
+  // Push each partial sum up to the next element that covers it.
+  for(std::size_t i = 1; i <= size; i++) {
+    auto const parent = i + lowbit(i);
+
+    if(parent <= size) {
+      m_tree[parent - 1] += m_tree[i - 1];
+    }
+  }
+}
+} // namespace reuse_distance
@@ -0,0 +1,460 @@
+#include "reuse-distance/bplus-tree.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <stdexcept>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace reuse_distance {
+
+constexpr std::size_t bplus_tree::FANOUT;
+constexpr std::uint32_t bplus_tree::SENTINEL;
+
+static_assert(sizeof(bplus_tree::leaf) == CACHE_LINE_SIZE, "A leaf must fill one cache line.");
+static_assert(
+    sizeof(bplus_tree::inner) == 2 * CACHE_LINE_SIZE, "An inner node must fill two cache lines.");
+
+#if defined(__SSE2__)
+inline std::uint32_t horizontal_sum(__m128i lanes)
+{
+  lanes = _mm_add_epi32(lanes, _mm_srli_si128(lanes, 8));
+  lanes = _mm_add_epi32(lanes, _mm_srli_si128(lanes, 4));
+
+  return static_cast<std::uint32_t>(_mm_cvtsi128_si32(lanes));
+}
+#endif
+
+/**
+ * Count the keys of a node that are less than a bound.
+ */
+inline std::uint32_t count_less(std::uint32_t const *keys, std::uint32_t bound)
+{
+#if defined(__SSE2__)
+  // Keys are below 2^31, so comparing them as signed integers is exact. A lane that compares true holds -1.
+  auto const b = _mm_set1_epi32(static_cast<int>(bound));
+
+  auto total = _mm_setzero_si128();
+  for(std::size_t i = 0; i < bplus_tree::FANOUT; i += 4) {
+    auto const k = _mm_loadu_si128(reinterpret_cast<__m128i const *>(keys + i));
+    total = _mm_sub_epi32(total, _mm_cmplt_epi32(k, b));
+  }
+
+  return horizontal_sum(total);
+#else
+  std::uint32_t total = 0;
+  for(std::size_t i = 0; i < bplus_tree::FANOUT; i++) {
+    total += keys[i] < bound ? 1u : 0u;
+  }
+
+  return total;
+#endif
+}
+
+/**
+ * Sum the number of keys below the children of a node whose first key is greater than a key.
+ */
+inline std::uint32_t count_greater(bplus_tree::inner const &node, std::uint32_t key)
+{
+#if defined(__SSE2__)
+  auto const b = _mm_set1_epi32(static_cast<int>(key));
+
+  auto total = _mm_setzero_si128();
+  for(std::size_t i = 0; i < bplus_tree::FANOUT; i += 4) {
+    auto const k = _mm_loadu_si128(reinterpret_cast<__m128i const *>(node.keys + i));
+    auto const c = _mm_loadu_si128(reinterpret_cast<__m128i const *>(node.counts + i));
+    total = _mm_add_epi32(total, _mm_and_si128(_mm_cmpgt_epi32(k, b), c));
+  }
+
+  return horizontal_sum(total);
+#else
+  std::uint32_t total = 0;
+  for(std::size_t i = 0; i < bplus_tree::FANOUT; i++) {
+    total += node.keys[i] > key ? node.counts[i] : 0u;
+  }
+
+  return total;
+#endif
+}
+
+inline bplus_tree::leaf empty_leaf()
+{
+  bplus_tree::leaf l;
+  std::fill(std::begin(l.keys), std::end(l.keys), bplus_tree::SENTINEL);
+
+  return l;
+}
+
+inline bplus_tree::inner empty_inner()
+{
+  bplus_tree::inner n;
+  std::fill(std::begin(n.keys), std::end(n.keys), bplus_tree::SENTINEL);
+  std::fill(std::begin(n.counts), std::end(n.counts), 0u);
+
+  return n;
+}
+
+inline std::uint32_t total_count(bplus_tree::inner const &node)
+{
+  std::uint32_t total = 0;
+  for(auto const count : node.counts) {
+    total += count;
+  }
+
+  return total;
+}
+
+bool bplus_tree::empty() const
+{
+  return m_keys.empty();
+}
+
+std::size_t bplus_tree::size() const
+{
+  return m_keys.size();
+}
+
+std::size_t bplus_tree::memory_usage() const
+{
+  auto bytes = m_leaves.capacity() * sizeof(leaf) + m_keys.memory_usage();
+  for(auto const &level : m_levels) {
+    bytes += level.capacity() * sizeof(inner);
+  }
+
+  return bytes;
+}
+
+std::size_t bplus_tree::height() const
+{
+  return m_leaves.empty() ? 0 : m_levels.size() + 1;
+}
+
+std::uint32_t const *bplus_tree::find_address(std::uint64_t address) const
+{
+  return m_keys.find(address);
+}
+
+std::uint64_t bplus_tree::time_of(std::uint32_t key) const
+{
+  return m_epoch + key;
+}
+
+double bplus_tree::calculate_position(std::uint32_t key) const
+{
+  std::uint64_t position = 0;
+  std::uint32_t leaf_size = 0;
+  std::size_t index = 0;
+
+  for(auto level = m_levels.size(); level-- > 0;) {
+    auto const &node = m_levels[level][index];
+
+    // The key is below the last child whose first key is not greater, and every later child only holds later keys.
+    auto const child = count_less(node.keys, key + 1) - 1;
+    position += count_greater(node, key);
+
+    leaf_size = node.counts[child];
+    index = index * FANOUT + child;
+  }
+
+  auto const earlier = count_less(m_leaves[index].keys, key);
+  assert(m_leaves[index].keys[earlier] == key);
+
+  return static_cast<double>(position + leaf_size - earlier - 1);
+}
+
+void bplus_tree::prefetch_address(std::uint64_t address) const
+{
+  m_keys.prefetch(address);
+}
+
+double bplus_tree::touch(std::uint64_t address, std::uint64_t time)
+{
+  double distance = std::numeric_limits<double>::infinity();
+
+  // Keys are only ever appended, so an earlier time would end up in the wrong leaf.
+  if(empty()) {
+    if(time < m_epoch) {
+      m_leaves.clear();
+      m_levels.clear();
+      m_epoch = time;
+    }
+  } else if(time <= latest_time()) {
+    throw std::invalid_argument("An access must be later than every access in the bplus_tree.");
+  }
+
+  // Every key (and the offset of the time after renumbering) must stay below SENTINEL.
+  if(size() >= SENTINEL - 1 && m_keys.find(address) == nullptr) {
+    throw std::length_error("The bplus_tree cannot hold more than 2^31 - 2 addresses.");
+  }
+
+  // Renumbering rewrites the key of every address, so it must happen before the address is looked up.
+  auto const key = offset(time);
+
+  auto const entry = m_keys.insert(address, key);
+  if(!entry.second) {
+    distance = remove(*entry.first);
+    *entry.first = key;
+  }
+
+  append(key);
+  m_latest = time;
+  m_latest_known = true;
+
+  return distance;
+}
+
+bool bplus_tree::erase(std::uint64_t address)
+{
+  auto const key = m_keys.find(address);
+  if(key == nullptr) {
+    return false;
+  }
+
+  // The latest time is found again when it is needed, if it was the time of this address.
+  if(time_of(*key) == m_latest) {
+    m_latest_known = false;
+  }
+
+  remove(*key);
+
+  return m_keys.erase(address);
+}
+
+std::uint64_t bplus_tree::latest_time()
+{
+  if(m_latest_known) {
+    return m_latest;
+  }
+
+  // Follow the last child that holds a key down to a leaf, whose last key in use is the latest.
+  std::size_t index = 0;
+  std::uint32_t used = 0;
+  for(auto level = m_levels.size(); level-- > 0;) {
+    auto const &node = m_levels[level][index];
+
+    auto child = FANOUT - 1;
+    while(node.counts[child] == 0) {
+      child--;
+    }
+
+    used = node.counts[child];
+    index = index * FANOUT + child;
+  }
+
+  m_latest = time_of(m_leaves[index].keys[used - 1]);
+  m_latest_known = true;
+
+  return m_latest;
+}
+
+std::uint32_t bplus_tree::offset(std::uint64_t time)
+{
+  assert(time >= m_epoch);
+
+  if(time - m_epoch >= SENTINEL) {
+    renumber(time);
+  }
+
+  return static_cast<std::uint32_t>(time - m_epoch);
+}
+
+double bplus_tree::remove(std::uint32_t key)
+{
+  std::uint64_t position = 0;
+  std::uint32_t leaf_size = 0;
+  std::size_t index = 0;
+
+  for(auto level = m_levels.size(); level-- > 0;) {
+    auto &node = m_levels[level][index];
+
+    auto const child = count_less(node.keys, key + 1) - 1;
+    position += count_greater(node, key);
+
+    leaf_size = node.counts[child]--;
+    index = index * FANOUT + child;
+  }
+
+  // Close the gap, so the keys in use stay in front of the leaf.
+  auto &keys = m_leaves[index].keys;
+  auto const earlier = count_less(keys, key);
+  assert(keys[earlier] == key);
+
+  std::copy(keys + earlier + 1, keys + leaf_size, keys + earlier);
+  keys[leaf_size - 1] = SENTINEL;
+
+  return static_cast<double>(position + leaf_size - earlier - 1);
+}
+
+void bplus_tree::append(std::uint32_t key)
+{
+  trim(key);
+
+  // The number of keys in the last leaf is counted by its parent.
+  auto index = m_leaves.size() - 1;
+  auto used = m_leaves.empty() ? FANOUT : m_levels[0][index / FANOUT].counts[index % FANOUT];
+
+  auto created = false;
+  if(used == FANOUT) {
+    // The new key is already in the index, but not in a leaf.
+    if(2 * size() < m_leaves.size() * FANOUT) {
+      rebuild(live_keys());
+      append(key);
+      return;
+    }
+
+    m_leaves.push_back(empty_leaf());
+    index = m_leaves.size() - 1;
+    used = 0;
+    created = true;
+  }
+
+  m_leaves[index].keys[used] = key;
+
+  // Count the key in each ancestor. A new node starts with the key, and needs a new node above it when it is the first
+  // child of that node, or a new root when it is the second node of the top level.
+  for(std::size_t level = 0;; ++level) {
+    if(level == m_levels.size()) {
+      m_levels.emplace_back();
+    }
+
+    auto &nodes = m_levels[level];
+    auto const node = index / FANOUT;
+    auto const child = index % FANOUT;
+
+    auto const created_node = node == nodes.size();
+    if(created_node) {
+      nodes.push_back(empty_inner());
+    }
+
+    if(created) {
+      nodes[node].keys[child] = key;
+    }
+    nodes[node].counts[child]++;
+
+    created = created_node;
+    index = node;
+
+    if(level + 1 == m_levels.size()) {
+      if(nodes.size() == 1) {
+        break;
+      }
+
+      // The old root becomes the first child of the new root, the loop then adds the new node as the second.
+      auto root = empty_inner();
+      root.keys[0] = nodes[0].keys[0];
+      root.counts[0] = total_count(nodes[0]);
+
+      m_levels.emplace_back(1, root);
+    }
+  }
+}
+
+void bplus_tree::trim(std::uint32_t key)
+{
+  // A new key is later than every key in the tree, but not necessarily than the keys that have been removed. The
+  // leaves that were started with such a key are empty, and are dropped so that the new key ends up in the last leaf.
+  while(!m_leaves.empty()) {
+    auto index = m_leaves.size() - 1;
+    if(m_levels[0][index / FANOUT].keys[index % FANOUT] <= key) {
+      break;
+    }
+
+    m_leaves.pop_back();
+
+    // Unlink the leaf from its parent, and drop each ancestor that it was the first child of.
+    for(auto &nodes : m_levels) {
+      auto &node = nodes[index / FANOUT];
+      assert(node.counts[index % FANOUT] == 0);
+      node.keys[index % FANOUT] = SENTINEL;
+
+      if(index % FANOUT != 0) {
+        break;
+      }
+
+      nodes.pop_back();
+      index /= FANOUT;
+    }
+  }
+
+  if(m_leaves.empty()) {
+    m_levels.clear();
+  }
+}
+
+std::vector<std::uint32_t> bplus_tree::live_keys() const
+{
+  std::vector<std::uint32_t> keys;
+  keys.reserve(size());
+
+  for(std::size_t i = 0; i < m_leaves.size(); i++) {
+    auto const used = m_levels[0][i / FANOUT].counts[i % FANOUT];
+    keys.insert(keys.end(), m_leaves[i].keys, m_leaves[i].keys + used);
+  }
+
+  return keys;
+}
+
+void bplus_tree::renumber(std::uint64_t time)
+{
+  auto keys = live_keys();
+  auto const latest = keys.empty() ? time - 1 : m_epoch + keys.back();
+
+  // Number the keys in order.
+  m_keys.for_each([&keys](std::uint64_t, std::uint32_t &key) {
+    auto const rank = std::lower_bound(keys.begin(), keys.end(), key) - keys.begin();
+    key = static_cast<std::uint32_t>(rank);
+  });
+
+  for(std::size_t i = 0; i < keys.size(); i++) {
+    keys[i] = static_cast<std::uint32_t>(i);
+  }
+
+  // Later times may be anywhere after the latest key (e.g., when a batch is reinserted), so the offsets continue from
+  // there, unless the gap up to the time is too long to hold.
+  m_epoch = latest + 1 - keys.size();
+  if(time - m_epoch >= SENTINEL) {
+    m_epoch = time - keys.size();
+  }
+
+  rebuild(keys);
+}
+
+void bplus_tree::rebuild(std::vector<std::uint32_t> const &keys)
+{
+  // Refill the leaves, then build each level of inner nodes from the level below.
+  m_leaves.assign((keys.size() + FANOUT - 1) / FANOUT, empty_leaf());
+  m_levels.clear();
+
+  if(keys.empty()) {
+    return;
+  }
+
+  for(std::size_t i = 0; i < keys.size(); i++) {
+    m_leaves[i / FANOUT].keys[i % FANOUT] = keys[i];
+  }
+
+  m_levels.emplace_back((m_leaves.size() + FANOUT - 1) / FANOUT, empty_inner());
+  for(std::size_t i = 0; i < m_leaves.size(); i++) {
+    auto &parent = m_levels[0][i / FANOUT];
+    parent.keys[i % FANOUT] = m_leaves[i].keys[0];
+    auto const used = std::min(FANOUT, keys.size() - i * FANOUT);
+    parent.counts[i % FANOUT] = static_cast<std::uint32_t>(used);
+  }
+
+  while(m_levels.back().size() > 1) {
+    auto const &below = m_levels.back();
+
+    auto const nodes = (below.size() + FANOUT - 1) / FANOUT;
+    std::vector<inner, cache_aligned_allocator<inner>> level(nodes, empty_inner());
+    for(std::size_t i = 0; i < below.size(); i++) {
+      level[i / FANOUT].keys[i % FANOUT] = below[i].keys[0];
+      level[i / FANOUT].counts[i % FANOUT] = total_count(below[i]);
+    }
+
+    m_levels.push_back(std::move(level));
+  }
+}
+} // namespace reuse_distance
@@ -0,0 +1,109 @@
+#include "reuse-distance/bplus.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include <reuse-distance/prefetch.hpp>
+
+namespace reuse_distance {
+
+double compute_distance(bplus_tree const &tree, std::uint64_t address)
+{
+  auto const key = tree.find_address(address); // O(1)
+
+  if(key == nullptr) {
+    return std::numeric_limits<double>::infinity();
+  }
+
+  return tree.calculate_position(*key);
+}
+
+void update(bplus_tree &tree, std::uint64_t address, std::uint64_t time)
+{
+  tree.touch(address, time);
+}
+
+double access(bplus_tree &tree, std::uint64_t address, std::uint64_t time)
+{
+  return tree.touch(address, time);
+}
+
+void access(bplus_tree &tree,
+    std::uint64_t const *addresses,
+    std::size_t count,
+    std::uint64_t time,
+    double *distances)
+{
+  for(std::size_t i = 0; i < std::min(count, PREFETCH_DISTANCE); i++) {
+    tree.prefetch_address(addresses[i]);
+  }
+
+  for(std::size_t i = 0; i < count; i++) {
+    if(i + PREFETCH_DISTANCE < count) {
+      tree.prefetch_address(addresses[i + PREFETCH_DISTANCE]);
+    }
+
+    distances[i] = tree.touch(addresses[i], time + i);
+  }
+}
+
+bool erase(bplus_tree &tree, std::uint64_t address)
+{
+  return tree.erase(address);
+}
+
+std::size_t erase_if(bplus_tree &tree, std::function<bool(std::uint64_t)> const &predicate)
+{
+  std::vector<std::uint64_t> matches;
+
+  tree.for_each([&predicate, &matches](std::uint64_t address) {
+    if(predicate(address)) {
+      matches.push_back(address);
+    }
+  });
+
+  for(auto const address : matches) {
+    tree.erase(address);
+  }
+
+  return matches.size();
+}
+
+snapshot save(bplus_tree const &tree, std::uint64_t clock)
+{
+  snapshot s;
+  s.clock = clock;
+  s.entries.reserve(tree.size());
+
+  tree.for_each([&tree, &s](std::uint64_t address) {
+    s.entries.push_back({tree.time_of(*tree.find_address(address)), address});
+  });
+  sort_by_recency(s.entries);
+
+  return s;
+}
+
+void restore(bplus_tree &tree, snapshot const &s)
+{
+  if(!tree.empty()) {
+    throw std::invalid_argument("Only an empty tree can be restored from a snapshot.");
+  }
+
+  // The entries are inserted from the oldest, each of which must be later than the ones before.
+  auto time = s.clock;
+  for(auto const &e : s.entries) {
+    if(e.time >= time) {
+      throw std::invalid_argument("The entries of a snapshot must be in descending order of time, before the clock.");
+    }
+
+    time = e.time;
+  }
+
+  for(auto e = s.entries.rbegin(); e != s.entries.rend(); ++e) {
+    update(tree, e->address, e->time);
+  }
+}
+
+} // namespace reuse_distance
@@ -0,0 +1,541 @@
+#include "reuse-distance/compact-tree.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <stdexcept>
+
+namespace reuse_distance {
+
+constexpr compact_tree::node_index compact_tree::NIL;
+
+// The top bit of size_and_colour marks a red node.
+constexpr std::uint32_t RED_BIT = std::uint32_t{1} << 31u;
+constexpr std::uint32_t SIZE_MASK = RED_BIT - 1;
+
+compact_tree::compact_tree() : m_nodes(1, node{0, NIL, NIL, NIL, 0})
+{
+}
+
+bool compact_tree::empty() const
+{
+  return m_hashmap.empty();
+}
+
+std::size_t compact_tree::size() const
+{
+  return m_hashmap.size();
+}
+
+std::size_t compact_tree::memory_usage() const
+{
+  return m_nodes.capacity() * sizeof(node) + m_hashmap.memory_usage();
+}
+
+std::size_t compact_tree::height() const
+{
+  std::size_t height = 0;
+
+  // A depth-first walk, where the stack holds at most one pending subtree per level.
+  std::vector<std::pair<node_index, std::size_t>> pending;
+  if(m_root != NIL) {
+    pending.emplace_back(m_root, 1);
+  }
+
+  while(!pending.empty()) {
+    auto const current = pending.back();
+    pending.pop_back();
+
+    height = std::max(height, current.second);
+    if(m_nodes[current.first].left != NIL) {
+      pending.emplace_back(m_nodes[current.first].left, current.second + 1);
+    }
+    if(m_nodes[current.first].right != NIL) {
+      pending.emplace_back(m_nodes[current.first].right, current.second + 1);
+    }
+  }
+
+  return height;
+}
+
+compact_tree::node_index compact_tree::successor(node_index x) const
+{
+  auto y = m_nodes[x].right;
+  if(y != NIL) {
+    // The node x has a right subtree, the successor should be here.
+    while(m_nodes[y].left != NIL) {
+      y = m_nodes[y].left;
+    }
+
+    return y;
+  }
+
+  // The node x does not have a right subtree, check the parents.
+  y = m_nodes[x].parent;
+  while(y != NIL && x == m_nodes[y].right) {
+    x = y;
+    y = m_nodes[y].parent;
+  }
+
+  return y;
+}
+
+compact_tree::node_index compact_tree::least_recently_used() const
+{
+  auto x = m_root;
+  while(x != NIL && m_nodes[x].left != NIL) {
+    x = m_nodes[x].left;
+  }
+
+  return x;
+}
+
+std::uint64_t compact_tree::time_of(node_index n) const
+{
+  return m_epoch + m_nodes[n].time;
+}
+
+double compact_tree::calculate_position(node_index n) const
+{
+  auto const time = m_nodes[n].time;
+
+  std::uint64_t position = size_of(m_nodes[n].right);
+
+  for(auto i = m_nodes[n].parent; i != NIL; i = m_nodes[i].parent) {
+    if(time < m_nodes[i].time) {
+      // n is in the left subtree of i
+      position += size_of(m_nodes[i].right) + 1;
+    }
+  }
+
+  return static_cast<double>(position);
+}
+
+compact_tree::node_index compact_tree::find_address(std::uint64_t address) const
+{
+  auto const it = m_hashmap.find(address);
+
+  return it == nullptr ? NIL : *it;
+}
+
+void compact_tree::prefetch_address(std::uint64_t address) const
+{
+  m_hashmap.prefetch(address);
+}
+
+void compact_tree::prefetch_node(std::uint64_t address) const
+{
+  auto const n = find_address(address);
+
+  if(n != NIL) {
+    prefetch(&m_nodes[n]);
+  }
+}
+
+std::pair<compact_tree::node_index, bool> compact_tree::find_or_insert(std::uint64_t time, std::uint64_t address)
+{
+  auto const slot = m_hashmap.insert(address, NIL);
+
+  if(!slot.second) {
+    return {*slot.first, false};
+  }
+
+  // Renumbering does not touch the hashmap, so the slot is still valid afterwards.
+  auto const t = offset(time);
+
+  auto const z = allocate();
+  *slot.first = z;
+
+  m_nodes[z].time = t;
+  attach(z);
+
+  return {z, true};
+}
+
+void compact_tree::move_to_most_recent(node_index n, std::uint64_t time)
+{
+  auto const t = offset(time);
+
+  // If n is already the rightmost node, the new timestamp keeps the tree ordered.
+  auto i = n;
+  while(m_nodes[i].parent != NIL && i == m_nodes[m_nodes[i].parent].right) {
+    i = m_nodes[i].parent;
+  }
+
+  if(m_nodes[n].right == NIL && i == m_root) {
+    m_nodes[n].time = t;
+    return;
+  }
+
+  detach(n);
+  m_nodes[n].time = t;
+  attach(n);
+}
+
+bool compact_tree::erase(std::uint64_t address)
+{
+  auto const z = find_address(address);
+  if(z == NIL) {
+    return false;
+  }
+
+  detach(z);
+  m_hashmap.erase(address);
+
+  m_nodes[z].parent = m_free;
+  m_free = z;
+
+  return true;
+}
+
+compact_tree::node_index compact_tree::allocate()
+{
+  if(m_free != NIL) {
+    auto const n = m_free;
+    m_free = m_nodes[n].parent;
+
+    return n;
+  }
+
+  if(m_nodes.size() > SIZE_MASK) {
+    throw std::length_error("The compact_tree cannot hold more than 2^31 - 1 addresses.");
+  }
+
+  // Grow by a quarter rather than doubling, so at most a fifth of the array is unused.
+  if(m_nodes.size() == m_nodes.capacity()) {
+    m_nodes.reserve(m_nodes.size() + m_nodes.size() / 4 + 1024);
+  }
+
+  m_nodes.emplace_back();
+
+  return static_cast<node_index>(m_nodes.size() - 1);
+}
+
+std::uint32_t compact_tree::offset(std::uint64_t time)
+{
+  assert(time >= m_epoch);
+
+  if(time - m_epoch > std::numeric_limits<std::uint32_t>::max()) {
+    renumber(time);
+  }
+
+  return static_cast<std::uint32_t>(time - m_epoch);
+}
+
+void compact_tree::renumber(std::uint64_t time)
+{
+  // Number the nodes in order, so the next time is one after the most recently used node.
+  std::uint32_t t = 0;
+  for(auto n = least_recently_used(); n != NIL; n = successor(n)) {
+    m_nodes[n].time = t++;
+  }
+
+  m_epoch = time - t;
+}
+
+std::uint32_t compact_tree::size_of(node_index n) const
+{
+  return m_nodes[n].size_and_colour & SIZE_MASK;
+}
+
+void compact_tree::set_size(node_index n, std::uint32_t size)
+{
+  m_nodes[n].size_and_colour = (m_nodes[n].size_and_colour & RED_BIT) | size;
+}
+
+bool compact_tree::is_red(node_index n) const
+{
+  return (m_nodes[n].size_and_colour & RED_BIT) != 0;
+}
+
+void compact_tree::set_red(node_index n, bool red)
+{
+  m_nodes[n].size_and_colour = (m_nodes[n].size_and_colour & SIZE_MASK) | (red ? RED_BIT : 0);
+}
+
+void compact_tree::attach(node_index z)
+{
+  auto y = NIL;
+  auto x = m_root;
+
+  while(x != NIL) {
+    m_nodes[x].size_and_colour++;
+    y = x;
+
+    if(m_nodes[x].time > m_nodes[z].time) {
+      x = m_nodes[x].left;
+    } else {
+      x = m_nodes[x].right;
+    }
+  }
+
+  m_nodes[z].parent = y;
+  if(y == NIL) {
+    m_root = z;
+  } else if(m_nodes[z].time < m_nodes[y].time) {
+    m_nodes[y].left = z;
+  } else {
+    m_nodes[y].right = z;
+  }
+
+  m_nodes[z].left = NIL;
+  m_nodes[z].right = NIL;
+  m_nodes[z].size_and_colour = RED_BIT | 1;
+
+  fix_insert(z);
+}
+
+void compact_tree::detach(node_index z)
+{
+  // y is the node that is physically removed from its position: z itself, or z's successor (no left child).
+  auto y = z;
+  if(m_nodes[z].left != NIL && m_nodes[z].right != NIL) {
+    y = m_nodes[z].right;
+    while(m_nodes[y].left != NIL) {
+      y = m_nodes[y].left;
+    }
+  }
+
+  // Update subtree sizes by traversing from y's position back to the root.
+  for(auto i = m_nodes[y].parent; i != NIL; i = m_nodes[i].parent) {
+    m_nodes[i].size_and_colour--;
+  }
+
+  bool removed_red = is_red(y);
+
+  // x will either be nil or the node that moves into y's position.
+  auto x = NIL;
+  if(m_nodes[z].left == NIL) {
+    x = m_nodes[z].right;
+    transplant(z, x);
+  } else if(m_nodes[z].right == NIL) {
+    x = m_nodes[z].left;
+    transplant(z, x);
+  } else {
+    // The successor y takes z's place (and colour and size).
+    x = m_nodes[y].right;
+
+    if(m_nodes[y].parent == z) {
+      m_nodes[x].parent = y;
+    } else {
+      transplant(y, x);
+      m_nodes[y].right = m_nodes[z].right;
+      m_nodes[m_nodes[y].right].parent = y;
+    }
+
+    transplant(z, y);
+    m_nodes[y].left = m_nodes[z].left;
+    m_nodes[m_nodes[y].left].parent = y;
+    m_nodes[y].size_and_colour = m_nodes[z].size_and_colour;
+  }
+
+  if(!removed_red) {
+    fix_delete(x);
+  }
+}
+
+void compact_tree::transplant(node_index u, node_index v)
+{
+  auto const parent = m_nodes[u].parent;
+
+  if(parent == NIL) {
+    m_root = v;
+  } else if(u == m_nodes[parent].left) {
+    m_nodes[parent].left = v;
+  } else {
+    m_nodes[parent].right = v;
+  }
+
+  m_nodes[v].parent = parent;
+}
+
+void compact_tree::fix_insert(node_index z)
+{
+  while(is_red(m_nodes[z].parent)) {
+    auto const parent = m_nodes[z].parent;
+    auto const grandparent = m_nodes[parent].parent;
+
+    if(parent == m_nodes[grandparent].left) {
+      // z's parent is on the left side of z's grandparent
+      auto const y = m_nodes[grandparent].right;
+
+      if(is_red(y)) {
+        set_red(parent, false);
+        set_red(y, false);
+        set_red(grandparent, true);
+
+        z = grandparent;
+      } else {
+        if(z == m_nodes[parent].right) {
+          // z is on the right side of its parent
+          z = parent;
+          rotate_left(z);
+        }
+
+        set_red(m_nodes[z].parent, false);
+        set_red(m_nodes[m_nodes[z].parent].parent, true);
+        rotate_right(m_nodes[m_nodes[z].parent].parent);
+      }
+    } else {
+      // symmetric to the above if-clause
+      auto const y = m_nodes[grandparent].left;
+
+      if(is_red(y)) {
+        set_red(parent, false);
+        set_red(y, false);
+        set_red(grandparent, true);
+
+        z = grandparent;
+      } else {
+        if(z == m_nodes[parent].left) {
+          z = parent;
+          rotate_right(z);
+        }
+
+        set_red(m_nodes[z].parent, false);
+        set_red(m_nodes[m_nodes[z].parent].parent, true);
+        rotate_left(m_nodes[m_nodes[z].parent].parent);
+      }
+    }
+  }
+
+  set_red(m_root, false);
+}
+
+void compact_tree::fix_delete(node_index x)
+{
+  while(x != m_root && !is_red(x)) {
+    auto const parent = m_nodes[x].parent;
+
+    if(x == m_nodes[parent].left) {
+      auto w = m_nodes[parent].right;
+
+      if(is_red(w)) {
+        // Case 1
+        set_red(w, false);
+        set_red(parent, true);
+
+        rotate_left(parent);
+        w = m_nodes[parent].right;
+      }
+
+      if(!is_red(m_nodes[w].left) && !is_red(m_nodes[w].right)) {
+        // Case 2
+        set_red(w, true);
+        x = parent;
+      } else {
+        if(!is_red(m_nodes[w].right)) {
+          // Case 3
+          set_red(m_nodes[w].left, false);
+          set_red(w, true);
+
+          rotate_right(w);
+          w = m_nodes[parent].right;
+        }
+
+        // Case 4
+        set_red(w, is_red(parent));
+        set_red(parent, false);
+        set_red(m_nodes[w].right, false);
+
+        rotate_left(parent);
+        x = m_root;
+      }
+    } else {
+      auto w = m_nodes[parent].left;
+
+      if(is_red(w)) {
+        // Case 1
+        set_red(w, false);
+        set_red(parent, true);
+
+        rotate_right(parent);
+        w = m_nodes[parent].left;
+      }
+
+      if(!is_red(m_nodes[w].right) && !is_red(m_nodes[w].left)) {
+        // Case 2
+        set_red(w, true);
+        x = parent;
+      } else {
+        if(!is_red(m_nodes[w].left)) {
+          // Case 3
+          set_red(m_nodes[w].right, false);
+          set_red(w, true);
+
+          rotate_left(w);
+          w = m_nodes[parent].left;
+        }
+
+        // Case 4
+        set_red(w, is_red(parent));
+        set_red(parent, false);
+        set_red(m_nodes[w].left, false);
+
+        rotate_right(parent);
+        x = m_root;
+      }
+    }
+  }
+
+  set_red(x, false);
+}
+
+void compact_tree::rotate_left(node_index x)
+{
+  // y is x's right subtree
+  auto const y = m_nodes[x].right;
+  // Turn y's left subtree into x's right subtree
+  m_nodes[x].right = m_nodes[y].left;
+
+  if(m_nodes[y].left != NIL) {
+    m_nodes[m_nodes[y].left].parent = x;
+  }
+
+  // Link x's parent to y
+  auto const parent = m_nodes[x].parent;
+  m_nodes[y].parent = parent;
+
+  if(parent == NIL) {
+    m_root = y;
+  } else if(x == m_nodes[parent].left) {
+    m_nodes[parent].left = y;
+  } else {
+    m_nodes[parent].right = y;
+  }
+
+  // Put x on y's left
+  m_nodes[y].left = x;
+  m_nodes[x].parent = y;
+
+  set_size(y, size_of(x));
+  set_size(x, size_of(m_nodes[x].left) + size_of(m_nodes[x].right) + 1);
+}
+
+void compact_tree::rotate_right(node_index y)
+{
+  auto const x = m_nodes[y].left;
+  m_nodes[y].left = m_nodes[x].right;
+
+  if(m_nodes[x].right != NIL) {
+    m_nodes[m_nodes[x].right].parent = y;
+  }
+
+  auto const parent = m_nodes[y].parent;
+  m_nodes[x].parent = parent;
+
+  if(parent == NIL) {
+    m_root = x;
+  } else if(y == m_nodes[parent].left) {
+    m_nodes[parent].left = x;
+  } else {
+    m_nodes[parent].right = x;
+  }
+
+  m_nodes[x].right = y;
+  m_nodes[y].parent = x;
+
+  set_size(x, size_of(y));
+  set_size(y, size_of(m_nodes[y].left) + size_of(m_nodes[y].right) + 1);
+}
+} // namespace reuse_distance
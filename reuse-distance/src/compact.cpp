@@ -0,0 +1,116 @@
+#include "reuse-distance/compact.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace reuse_distance {
+
+double compute_distance(compact_tree const &tree, std::uint64_t address)
+{
+  auto const node = tree.find_address(address); // O(1)
+
+  if(node == compact_tree::NIL) {
+    return std::numeric_limits<double>::infinity();
+  }
+
+  return tree.calculate_position(node);
+}
+
+void update(compact_tree &tree, std::uint64_t address, std::uint64_t time)
+{
+  auto const result = tree.find_or_insert(time, address); // O(1)
+
+  if(!result.second) {
+    tree.move_to_most_recent(result.first, time);
+  }
+}
+
+double access(compact_tree &tree, std::uint64_t address, std::uint64_t time)
+{
+  auto const result = tree.find_or_insert(time, address); // O(1)
+
+  if(result.second) {
+    return std::numeric_limits<double>::infinity();
+  }
+
+  auto const distance = tree.calculate_position(result.first);
+  tree.move_to_most_recent(result.first, time);
+
+  return distance;
+}
+
+void access(compact_tree &tree,
+    std::uint64_t const *addresses,
+    std::size_t count,
+    std::uint64_t time,
+    double *distances)
+{
+  // The node of an address is found through its hashmap slot, so the slots are prefetched a window further ahead.
+  for(std::size_t i = 0; i < std::min(count, 2 * PREFETCH_DISTANCE); i++) {
+    tree.prefetch_address(addresses[i]);
+  }
+
+  for(std::size_t i = 0; i < count; i++) {
+    if(i + 2 * PREFETCH_DISTANCE < count) {
+      tree.prefetch_address(addresses[i + 2 * PREFETCH_DISTANCE]);
+    }
+
+    if(i + PREFETCH_DISTANCE < count) {
+      tree.prefetch_node(addresses[i + PREFETCH_DISTANCE]);
+    }
+
+    distances[i] = access(tree, addresses[i], time + i);
+  }
+}
+
+bool erase(compact_tree &tree, std::uint64_t address)
+{
+  return tree.erase(address);
+}
+
+std::size_t erase_if(compact_tree &tree, std::function<bool(std::uint64_t)> const &predicate)
+{
+  std::vector<std::uint64_t> matches;
+
+  tree.for_each([&predicate, &matches](std::uint64_t address) {
+    if(predicate(address)) {
+      matches.push_back(address);
+    }
+  });
+
+  for(auto const address : matches) {
+    tree.erase(address);
+  }
+
+  return matches.size();
+}
+
+snapshot save(compact_tree const &tree, std::uint64_t clock)
+{
+  snapshot s;
+  s.clock = clock;
+  s.entries.reserve(tree.size());
+
+  // The nodes do not store their address, so the addresses are collected from the hashmap and sorted.
+  tree.for_each([&tree, &s](std::uint64_t address) {
+    s.entries.push_back({tree.time_of(tree.find_address(address)), address});
+  });
+  sort_by_recency(s.entries);
+
+  return s;
+}
+
+void restore(compact_tree &tree, snapshot const &s)
+{
+  if(!tree.empty()) {
+    throw std::invalid_argument("Only an empty tree can be restored from a snapshot.");
+  }
+
+  for(auto e = s.entries.rbegin(); e != s.entries.rend(); ++e) {
+    update(tree, e->address, e->time);
+  }
+}
+
+} // namespace reuse_distance
@@ -0,0 +1,218 @@
+#include "reuse-distance/counter-stacks.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+#include "reuse-distance/hash.hpp"
+
+namespace reuse_distance {
+
+counter_stacks::counter_stacks(std::uint64_t step, double pruning, unsigned precision)
+    : m_step(step), m_pruning(pruning), m_precision(precision)
+{
+  if(step == 0) {
+    throw std::invalid_argument("The step of the counter stacks must be greater than zero.");
+  }
+
+  if(!(pruning >= 0.0 && pruning < 1.0)) {
+    throw std::invalid_argument("The pruning threshold must be in the range [0, 1).");
+  }
+
+  // Validate the precision before the first counter is needed.
+  static_cast<void>(hyperloglog(precision));
+}
+
+void counter_stacks::access(std::uint64_t address)
+{
+  if(m_step_count == 0) {
+    m_counters.push_back({hyperloglog(m_precision), 0.0});
+  }
+
+  // An older counter has seen every address a newer one has, so once a counter is unchanged, so are all older ones.
+  auto const h = hash(address);
+  for(auto c = m_counters.rbegin(); c != m_counters.rend() && c->sketch.insert(h); ++c) {
+  }
+
+  m_count++;
+  if(++m_step_count == m_step) {
+    end_step();
+  }
+}
+
+void counter_stacks::flush()
+{
+  if(m_step_count > 0) {
+    end_step();
+  }
+}
+
+std::uint64_t counter_stacks::count() const
+{
+  return m_count;
+}
+
+std::size_t counter_stacks::counters() const
+{
+  return m_counters.size();
+}
+
+std::size_t counter_stacks::memory_usage() const
+{
+  std::size_t bytes = m_counters.capacity() * sizeof(counter);
+  for(auto const &c : m_counters) {
+    bytes += c.sketch.memory_usage();
+  }
+
+  return bytes;
+}
+
+std::map<double, std::uint64_t> counter_stacks::histogram() const
+{
+  std::map<double, std::uint64_t> histogram;
+
+  double previous = 0.0;
+  for(auto const &point : cumulative()) {
+    auto const count = std::llround(point.second - previous);
+    if(count > 0) {
+      histogram[point.first] = static_cast<std::uint64_t>(count);
+    }
+    previous = point.second;
+  }
+
+  return histogram;
+}
+
+std::map<double, double> counter_stacks::miss_ratio_curve() const
+{
+  std::map<double, double> curve;
+
+  auto const points = cumulative();
+  if(points.empty() || points.back().second <= 0.0) {
+    return curve;
+  }
+
+  // An access hits in a cache that holds more addresses than its reuse distance.
+  auto const total = points.back().second;
+  curve[0.0] = 1.0;
+  for(auto const &point : points) {
+    if(std::isinf(point.first)) {
+      break;
+    }
+
+    curve[point.first + 1.0] = (total - point.second) / total;
+  }
+
+  return curve;
+}
+
+std::vector<std::pair<double, double>> counter_stacks::cumulative() const
+{
+  std::vector<std::pair<double, double>> points;
+  points.reserve(m_distances.size());
+
+  double total = 0.0;
+  for(auto const &bin : m_distances) {
+    total += bin.second;
+  }
+
+  double sum = 0.0;
+  for(auto const &bin : m_distances) {
+    sum += bin.second;
+    points.emplace_back(bin.first, sum);
+  }
+
+  // The accesses with an infinite distance are the growth of the oldest counter, so the count of the finite distances
+  // is the best estimate, and the curve below it is fitted to it.
+  auto const finite = points.empty() || !std::isinf(points.back().first) ? points.size() : points.size() - 1;
+  if(finite == 0) {
+    return points;
+  }
+
+  auto const reused = std::min(std::max(points[finite - 1].second, 0.0), total);
+
+  // Noise in the estimates can make a bin negative, which the bins above it make up for. Fit the counts with the
+  // closest non-decreasing sequence (pool adjacent violators), which, unlike a running maximum, is not biased upward by
+  // every excursion of the noise. Each block holds the mean of the counts it pools, and its number of points.
+  std::vector<std::pair<double, std::size_t>> blocks;
+  blocks.reserve(finite);
+  for(std::size_t i = 0; i + 1 < finite; i++) {
+    blocks.emplace_back(points[i].second, 1);
+    while(blocks.size() > 1 && blocks[blocks.size() - 2].first > blocks.back().first) {
+      auto const last = blocks.back();
+      blocks.pop_back();
+
+      auto &previous = blocks.back();
+      auto const size = previous.second + last.second;
+      previous.first = (previous.first * static_cast<double>(previous.second)
+                           + last.first * static_cast<double>(last.second))
+          / static_cast<double>(size);
+      previous.second = size;
+    }
+  }
+
+  // Clamping the fit keeps it non-decreasing, and bounded by the count of the finite distances.
+  std::size_t i = 0;
+  for(auto const &block : blocks) {
+    for(std::size_t j = 0; j < block.second; j++, i++) {
+      points[i].second = std::min(std::max(block.first, 0.0), reused);
+    }
+  }
+
+  points[finite - 1].second = reused;
+  if(finite < points.size()) {
+    points.back().second = total;
+  }
+
+  return points;
+}
+
+void counter_stacks::end_step()
+{
+  auto const accesses = static_cast<double>(m_step_count);
+  m_step_count = 0;
+
+  std::vector<double> values(m_counters.size());
+  std::vector<double> growth(m_counters.size());
+  for(std::size_t i = 0; i < m_counters.size(); i++) {
+    values[i] = std::round(m_counters[i].sketch.estimate());
+    growth[i] = values[i] - m_counters[i].previous;
+  }
+
+  auto record = [this](double distance, double weight) {
+    if(weight != 0.0) {
+      m_distances[distance] += weight;
+    }
+  };
+
+  // Accesses whose previous access was in this step.
+  auto const newest = m_counters.size() - 1;
+  record(values[newest], accesses - growth[newest]);
+
+  // Accesses whose previous access was between the start of counter i and the start of counter i + 1.
+  for(std::size_t i = 0; i < newest; i++) {
+    record(values[i], growth[i + 1] - growth[i]);
+  }
+
+  // Accesses to addresses not seen since the oldest counter, which started with the trace.
+  record(std::numeric_limits<double>::infinity(), growth[0]);
+
+  // Prune the counters that have (nearly) converged with the next older counter that is kept.
+  std::vector<counter> kept;
+  kept.reserve(m_counters.size());
+  auto kept_value = 0.0;
+  for(std::size_t i = 0; i < m_counters.size(); i++) {
+    if(i > 0 && values[i] >= (1.0 - m_pruning) * kept_value) {
+      continue;
+    }
+
+    m_counters[i].previous = values[i];
+    kept_value = values[i];
+    kept.push_back(std::move(m_counters[i]));
+  }
+
+  m_counters = std::move(kept);
+}
+} // namespace reuse_distance
@@ -0,0 +1,143 @@
+#include "reuse-distance/fenwick-tree.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+namespace reuse_distance {
+
+// The slot of an address that has been inserted into the index, but not yet placed on the time axis.
+constexpr std::uint64_t NO_SLOT = std::numeric_limits<std::uint64_t>::max();
+
+fenwick_tree::fenwick_tree(std::size_t capacity)
+    : m_live(capacity > 0 ? capacity : 1), m_is_live(m_live.size(), false), m_times(m_live.size(), 0)
+{
+}
+
+bool fenwick_tree::empty() const
+{
+  return m_last_access.empty();
+}
+
+std::size_t fenwick_tree::size() const
+{
+  return m_last_access.size();
+}
+
+std::size_t fenwick_tree::capacity() const
+{
+  return m_live.size();
+}
+
+std::size_t fenwick_tree::memory_usage() const
+{
+  return m_live.memory_usage() + m_is_live.capacity() / 8 + m_times.capacity() * sizeof(std::uint64_t)
+      + m_last_access.memory_usage();
+}
+
+std::uint64_t const *fenwick_tree::find_address(std::uint64_t address) const
+{
+  return m_last_access.find(address);
+}
+
+std::uint64_t fenwick_tree::time_of(std::uint64_t slot) const
+{
+  return m_times[static_cast<std::size_t>(slot)];
+}
+
+double fenwick_tree::calculate_position(std::uint64_t slot) const
+{
+  // Count the live slots after the given slot.
+  auto const up_to_slot = m_live.prefix_sum(static_cast<std::size_t>(slot) + 1);
+
+  return static_cast<double>(size() - up_to_slot);
+}
+
+void fenwick_tree::prefetch_address(std::uint64_t address) const
+{
+  m_last_access.prefetch(address);
+}
+
+double fenwick_tree::touch(std::uint64_t address, std::uint64_t time)
+{
+  double distance = std::numeric_limits<double>::infinity();
+
+  auto const entry = m_last_access.insert(address, NO_SLOT);
+  if(!entry.second) {
+    auto const previous = static_cast<std::size_t>(*entry.first);
+    distance = calculate_position(previous);
+
+    m_live.add(previous, -1);
+    m_is_live[previous] = false;
+  }
+
+  // Compaction only rewrites the slots of live entries, so the entry is still valid afterwards.
+  auto const slot = allocate_slot();
+  *entry.first = slot;
+
+  m_live.add(static_cast<std::size_t>(slot), 1);
+  m_is_live[static_cast<std::size_t>(slot)] = true;
+  m_times[static_cast<std::size_t>(slot)] = time;
+
+  return distance;
+}
+
+bool fenwick_tree::erase(std::uint64_t address)
+{
+  auto const slot = m_last_access.find(address);
+  if(slot == nullptr) {
+    return false;
+  }
+
+  m_live.add(static_cast<std::size_t>(*slot), -1);
+  m_is_live[static_cast<std::size_t>(*slot)] = false;
+
+  return m_last_access.erase(address);
+}
+
+std::uint64_t fenwick_tree::allocate_slot()
+{
+  if(m_next == capacity()) {
+    compact();
+  }
+
+  return m_next++;
+}
+
+void fenwick_tree::compact()
+{
+  // Renumber the live slots in order.
+  std::vector<std::uint64_t> renumbered(m_is_live.size());
+
+  std::uint64_t live = 0;
+  for(std::size_t i = 0; i < m_is_live.size(); i++) {
+    renumbered[i] = live;
+
+    // The live slots only move down, so their times can be moved in place.
+    if(m_is_live[i]) {
+      m_times[static_cast<std::size_t>(live)] = m_times[i];
+      live++;
+    }
+  }
+
+  m_last_access.for_each([this, &renumbered](std::uint64_t, std::uint64_t &slot) {
+    if(slot != NO_SLOT && m_is_live[static_cast<std::size_t>(slot)]) {
+      slot = renumbered[static_cast<std::size_t>(slot)];
+    }
+  });
+
+  // Grow the time axis if compaction would not free at least half of it.
+  auto new_capacity = capacity();
+  if(2 * live > new_capacity) {
+    new_capacity *= 2;
+  }
+
+  auto const live_count = static_cast<std::size_t>(live);
+  m_is_live.assign(new_capacity, false);
+  std::fill(m_is_live.begin(), m_is_live.begin() + static_cast<std::ptrdiff_t>(live_count), true);
+  m_live.reset(new_capacity, live_count);
+  m_times.resize(new_capacity, 0);
+
+  m_next = live;
+}
+} // namespace reuse_distance
@@ -0,0 +1,64 @@
+#include "reuse-distance/hyperloglog.hpp"
+
+#include <cmath>
+#include <stdexcept>
+
+namespace reuse_distance {
+
+constexpr unsigned MIN_PRECISION = 4;
+constexpr unsigned MAX_PRECISION = 18;
+
+hyperloglog::hyperloglog(unsigned precision)
+    : m_precision(precision), m_registers(std::size_t{1} << (precision <= MAX_PRECISION ? precision : 0), 0),
+      m_sum(static_cast<double>(m_registers.size())), m_zeros(m_registers.size())
+{
+  if(precision < MIN_PRECISION || precision > MAX_PRECISION) {
+    throw std::invalid_argument("The precision of a HyperLogLog sketch must be in the range [4, 18].");
+  }
+}
+
+bool hyperloglog::insert(std::uint64_t hash)
+{
+  auto const index = static_cast<std::size_t>(hash >> (64u - m_precision));
+
+  // The position of the first set bit after the index bits, where a sentinel bit caps the run of zeros.
+  auto const rest = (hash << m_precision) | (std::uint64_t{1} << (m_precision - 1));
+  std::uint8_t rank = 1;
+  for(auto bit = std::uint64_t{1} << 63u; (rest & bit) == 0; bit >>= 1u) {
+    rank++;
+  }
+
+  auto &r = m_registers[index];
+  if(r >= rank) {
+    return false;
+  }
+
+  if(r == 0) {
+    m_zeros--;
+  }
+  m_sum += std::ldexp(1.0, -static_cast<int>(rank)) - std::ldexp(1.0, -static_cast<int>(r));
+  r = rank;
+
+  return true;
+}
+
+double hyperloglog::estimate() const
+{
+  auto const m = static_cast<double>(m_registers.size());
+
+  auto const alpha = 0.7213 / (1.0 + 1.079 / m);
+  auto const raw = alpha * m * m / m_sum;
+
+  // Linear counting is more accurate while many registers are still empty.
+  if(raw <= 2.5 * m && m_zeros > 0) {
+    return m * std::log(m / static_cast<double>(m_zeros));
+  }
+
+  return raw;
+}
+
+std::size_t hyperloglog::memory_usage() const
+{
+  return m_registers.capacity() * sizeof(std::uint8_t);
+}
+} // namespace reuse_distance
@@ -0,0 +1,190 @@
+#include "reuse-distance/multi-granularity.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#include <reuse-distance/parallel.hpp>
+
+namespace reuse_distance {
+
+template <typename Tree>
+multi_granularity<Tree>::multi_granularity(std::vector<std::uint64_t> block_sizes)
+    : m_block_sizes(std::move(block_sizes))
+    , m_trees(m_block_sizes.size())
+    , m_clocks(m_block_sizes.size(), 0)
+    , m_recent(m_block_sizes.size())
+{
+  if(m_block_sizes.empty()) {
+    throw std::invalid_argument("A multi_granularity needs at least one block size.");
+  }
+
+  for(std::size_t level = 0; level < m_block_sizes.size(); ++level) {
+    auto const block_size = m_block_sizes[level];
+    if(block_size == 0 || (block_size & (block_size - 1)) != 0) {
+      throw std::invalid_argument("The block sizes of a multi_granularity must be powers of two.");
+    }
+
+    if(level > 0 && block_size <= m_block_sizes[level - 1]) {
+      throw std::invalid_argument("The block sizes of a multi_granularity must be in ascending order.");
+    }
+
+    unsigned shift = 0;
+    while((std::uint64_t{1} << shift) != block_size) {
+      shift++;
+    }
+
+    m_shifts.push_back(shift);
+  }
+}
+
+template <typename Tree>
+std::size_t multi_granularity<Tree>::levels() const
+{
+  return m_block_sizes.size();
+}
+
+template <typename Tree>
+std::vector<std::uint64_t> const &multi_granularity<Tree>::block_sizes() const
+{
+  return m_block_sizes;
+}
+
+template <typename Tree>
+bool multi_granularity<Tree>::empty() const
+{
+  return std::all_of(m_trees.begin(), m_trees.end(), [](Tree const &tree) { return tree.empty(); });
+}
+
+template <typename Tree>
+Tree const &multi_granularity<Tree>::level(std::size_t level) const
+{
+  return m_trees[level];
+}
+
+template <typename Tree>
+std::uint64_t multi_granularity<Tree>::clock(std::size_t level) const
+{
+  return m_clocks[level];
+}
+
+template <typename Tree>
+std::size_t multi_granularity<Tree>::memory_usage() const
+{
+  std::size_t bytes = 0;
+  for(auto const &tree : m_trees) {
+    bytes += tree.memory_usage();
+  }
+
+  return bytes;
+}
+
+template <typename Tree>
+void multi_granularity<Tree>::prefetch_address(std::uint64_t address) const
+{
+  m_trees.front().prefetch_address(address >> m_shifts.front());
+}
+
+template <typename Tree>
+void multi_granularity<Tree>::touch(std::uint64_t address, double *distances)
+{
+  for(std::size_t level = 0; level < levels(); ++level) {
+    auto const block = address >> m_shifts[level];
+
+    // The block is already on top of the stack.
+    if(m_recent[level].known && block == m_recent[level].block) {
+      distances[level] = 0.0;
+      continue;
+    }
+
+    distances[level] = access(m_trees[level], block, m_clocks[level]++);
+    m_recent[level] = {block, true};
+  }
+}
+
+template <typename Tree>
+void multi_granularity<Tree>::touch(std::uint64_t const *addresses,
+    std::size_t count,
+    double *distances,
+    std::size_t threads)
+{
+  std::vector<std::uint64_t> blocks;
+  std::vector<std::size_t> positions;
+  std::vector<double> block_distances;
+
+  for(std::size_t level = 0; level < levels(); ++level) {
+    blocks.clear();
+    positions.clear();
+
+    // Only the accesses that leave the most recent block of the level reach its tree.
+    auto recent = m_recent[level];
+    for(std::size_t i = 0; i < count; i++) {
+      auto const block = addresses[i] >> m_shifts[level];
+
+      if(recent.known && block == recent.block) {
+        distances[i * levels() + level] = 0.0;
+      } else {
+        blocks.push_back(block);
+        positions.push_back(i);
+        recent = {block, true};
+      }
+    }
+
+    parallel_access(m_trees[level], blocks, m_clocks[level], block_distances, threads);
+
+    for(std::size_t j = 0; j < positions.size(); j++) {
+      distances[positions[j] * levels() + level] = block_distances[j];
+    }
+
+    m_clocks[level] += blocks.size();
+    m_recent[level] = recent;
+  }
+}
+
+template <typename Tree>
+std::size_t multi_granularity<Tree>::erase_if(std::size_t level, std::function<bool(std::uint64_t)> const &predicate)
+{
+  if(m_recent[level].known && predicate(m_recent[level].block)) {
+    m_recent[level] = recent_block();
+  }
+
+  return reuse_distance::erase_if(m_trees[level], predicate);
+}
+
+template <typename Tree>
+void multi_granularity<Tree>::restore(std::vector<snapshot> const &snapshots)
+{
+  if(!empty()) {
+    throw std::invalid_argument("Only an empty tree can be restored from a snapshot.");
+  }
+
+  if(snapshots.size() != levels()) {
+    throw std::invalid_argument("A multi_granularity is restored from one snapshot per level.");
+  }
+
+  for(std::size_t level = 0; level < levels(); ++level) {
+    auto const &s = snapshots[level];
+    reuse_distance::restore(m_trees[level], s);
+
+    m_clocks[level] = s.clock;
+    m_recent[level] = s.entries.empty() ? recent_block() : recent_block{s.entries.front().address, true};
+  }
+}
+
+template <typename Tree>
+snapshot save(multi_granularity<Tree> const &tree, std::size_t level)
+{
+  return save(tree.level(level), tree.clock(level));
+}
+
+template class multi_granularity<olken_tree>;
+template class multi_granularity<compact_tree>;
+template class multi_granularity<fenwick_tree>;
+template class multi_granularity<bplus_tree>;
+
+template snapshot save(multi_granularity<olken_tree> const &tree, std::size_t level);
+template snapshot save(multi_granularity<compact_tree> const &tree, std::size_t level);
+template snapshot save(multi_granularity<fenwick_tree> const &tree, std::size_t level);
+template snapshot save(multi_granularity<bplus_tree> const &tree, std::size_t level);
+
+} // namespace reuse_distance
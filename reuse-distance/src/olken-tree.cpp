@@ -1,6 +1,10 @@
 #include "reuse-distance/olken-tree.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <stdexcept>
+#include <vector>
+
 #include <reuse-distance/olken-tree.hpp>
 
 namespace reuse_distance {
@@ -12,6 +16,12 @@ olken_tree::olken_tree() : m_nil(std::make_unique<node>(-1, -1)), m_root(m_nil.g
   m_nil->parent = m_nil.get();
 }
 
+olken_tree::olken_tree(std::size_t max_distance, std::uint64_t max_age) : olken_tree()
+{
+  m_max_distance = max_distance;
+  m_max_age = max_age;
+}
+
 bool olken_tree::empty() const
 {
   return m_hashmap.empty();
@@ -22,6 +32,58 @@ std::size_t olken_tree::size() const
   return m_hashmap.size();
 }
 
+std::size_t olken_tree::memory_usage() const
+{
+  return sizeof(node) + m_pool.capacity() + m_hashmap.memory_usage();
+}
+
+std::size_t olken_tree::max_distance() const
+{
+  return m_max_distance;
+}
+
+std::uint64_t olken_tree::max_age() const
+{
+  return m_max_age;
+}
+
+std::size_t olken_tree::height() const
+{
+  std::size_t height = 0;
+
+  // A depth-first walk, where the stack holds at most one pending subtree per level.
+  std::vector<std::pair<node const *, std::size_t>> pending;
+  if(m_root != m_nil.get()) {
+    pending.emplace_back(m_root, 1);
+  }
+
+  while(!pending.empty()) {
+    auto const current = pending.back();
+    pending.pop_back();
+
+    height = std::max(height, current.second);
+    if(current.first->left != m_nil.get()) {
+      pending.emplace_back(current.first->left, current.second + 1);
+    }
+    if(current.first->right != m_nil.get()) {
+      pending.emplace_back(current.first->right, current.second + 1);
+    }
+  }
+
+  return height;
+}
+
+olken_tree::statistics olken_tree::stats() const
+{
+  auto result = m_stats;
+  result.lookups = m_hashmap.lookups();
+  result.probes = m_hashmap.probes();
+  result.nodes = size();
+  result.height = STATS_ENABLED ? height() : 0;
+
+  return result;
+}
+
 olken_tree::node *olken_tree::successor(olken_tree::node *x) const
 {
   node *y = x->right;
@@ -90,10 +152,14 @@ double olken_tree::calculate_position(olken_tree::node const *n) const
 {
   assert(m_root->parent == m_nil.get());
 
+  tally(m_stats.positions);
+
   double position = n->right->size;
 
   node *i = n->parent;
   while(i != m_nil.get()) {
+    tally(m_stats.position_steps);
+
     if(n->time < i->time) {
       // n is in the left subtree of i
       position += i->right->size;
@@ -106,24 +172,208 @@ double olken_tree::calculate_position(olken_tree::node const *n) const
   return position;
 }
 
+olken_tree::node *olken_tree::select_by_distance(std::size_t distance) const
+{
+  if(distance >= size()) {
+    return nullptr;
+  }
+
+  auto remaining = distance;
+
+  node *x = m_root;
+  while(x != m_nil.get()) {
+    // Every node in the right subtree is more recent than x.
+    auto const more_recent = static_cast<std::size_t>(x->right->size);
+
+    if(remaining < more_recent) {
+      x = x->right;
+    } else if(remaining == more_recent) {
+      break;
+    } else {
+      remaining -= more_recent + 1;
+      x = x->left;
+    }
+  }
+
+  assert(x != m_nil.get());
+  assert(static_cast<std::size_t>(calculate_position(x)) == distance);
+
+  return x;
+}
+
 olken_tree::node *olken_tree::find_address(std::uint64_t address) const
 {
   auto const it = m_hashmap.find(address);
 
-  if(it == m_hashmap.end()) {
+  if(it == nullptr) {
     return nullptr;
   }
 
-  return it->second;
+  return *it;
+}
+
+void olken_tree::prefetch_address(std::uint64_t address) const
+{
+  m_hashmap.prefetch(address);
+}
+
+void olken_tree::prefetch_node(std::uint64_t address) const
+{
+  auto const n = find_address(address);
+
+  if(n != nullptr) {
+    prefetch(n);
+  }
 }
 
 olken_tree::node *olken_tree::insert(std::uint64_t const time, std::uint64_t const address)
 {
-  auto new_node = new node(time, address);
-  new_node->size = 1;
-  m_hashmap[address] = new_node;
+  auto new_node = m_pool.allocate(time, address);
+  m_hashmap.assign(address, new_node);
+
+  attach(new_node);
+
+  return new_node;
+}
+
+std::pair<olken_tree::node *, bool> olken_tree::find_or_insert(std::uint64_t time, std::uint64_t address)
+{
+  auto const slot = m_hashmap.insert(address, nullptr);
+
+  if(!slot.second) {
+    return {*slot.first, false};
+  }
+
+  auto new_node = m_pool.allocate(time, address);
+  *slot.first = new_node;
+
+  attach(new_node);
+
+  return {new_node, true};
+}
+
+void olken_tree::move_to_most_recent(olken_tree::node *n, std::uint64_t time)
+{
+  assert(m_root->parent == m_nil.get());
+
+  // If n is already the rightmost node, the new timestamp keeps the tree ordered.
+  node const *i = n;
+  while(i->parent != m_nil.get() && i == i->parent->right) {
+    i = i->parent;
+  }
+
+  if(n->right == m_nil.get() && i == m_root) {
+    n->time = time;
+    return;
+  }
+
+  detach(n);
+  n->time = time;
+  attach(n);
+}
+
+void olken_tree::erase(node *z)
+{
+  assert(m_root->parent == m_nil.get());
+
+  detach(z);
+
+  m_hashmap.erase(z->address);
+  m_pool.deallocate(z);
+}
+
+std::size_t olken_tree::expire(std::uint64_t time)
+{
+  auto const too_far = [this]() { return m_max_distance != 0 && size() > m_max_distance; };
+  auto const too_old = [this, time]() { return m_max_age != 0 && m_oldest < time && time - m_oldest > m_max_age; };
+
+  std::size_t evicted = 0;
+  while(!empty() && (too_far() || too_old())) {
+    // The bound may be stale if the oldest node has been reused since, so look up the actual oldest node.
+    auto const lru = least_recently_used();
+    m_oldest = lru->time;
+
+    if(!too_far() && !too_old()) {
+      break;
+    }
+
+    erase(lru);
+    evicted++;
+  }
+
+  tally(m_stats.evictions, evicted);
+
+  return evicted;
+}
+
+void olken_tree::build(std::vector<snapshot_entry> const &entries)
+{
+  if(!empty()) {
+    throw std::invalid_argument("Only an empty tree can be built from a snapshot.");
+  }
+
+  for(std::size_t i = 1; i < entries.size(); i++) {
+    if(entries[i].time >= entries[i - 1].time) {
+      throw std::invalid_argument("The entries of a snapshot must be in descending order of time.");
+    }
+  }
+
+  // Index every address before allocating any node, so a duplicate leaves the tree empty.
+  m_hashmap.reserve(entries.size());
+  for(auto const &e : entries) {
+    if(!m_hashmap.insert(e.address, nullptr).second) {
+      m_hashmap.clear();
+      throw std::runtime_error("The snapshot tracks an address more than once.");
+    }
+  }
+
+  // An in-order walk visits the nodes in ascending order of time, the reverse of the entries.
+  std::vector<node *> nodes(entries.size());
+  for(std::size_t i = 0; i < entries.size(); i++) {
+    auto const &e = entries[entries.size() - 1 - i];
+
+    nodes[i] = m_pool.allocate(e.time, e.address);
+    *m_hashmap.find(e.address) = nodes[i];
+  }
+
+  std::size_t deepest = 0;
+  while((std::size_t{1} << deepest) <= nodes.size()) {
+    deepest++;
+  }
+
+  m_root = link(nodes, 0, nodes.size(), m_nil.get(), 1, deepest);
+}
+
+olken_tree::node *olken_tree::link(std::vector<node *> const &nodes,
+    std::size_t first,
+    std::size_t last,
+    node *parent,
+    std::size_t depth,
+    std::size_t deepest)
+{
+  if(first == last) {
+    return m_nil.get();
+  }
+
+  // Splitting at the middle keeps every leaf on one of the two deepest levels.
+  auto const middle = first + (last - first) / 2;
+  auto n = nodes[middle];
+
+  n->parent = parent;
+  n->left = link(nodes, first, middle, n, depth + 1, deepest);
+  n->right = link(nodes, middle + 1, last, n, depth + 1, deepest);
+  n->size = static_cast<int>(last - first);
+
+  // Every path to a leaf then has deepest - 1 black nodes if the nodes on the deepest level are red.
+  n->red = depth == deepest && depth > 1;
+
+  return n;
+}
+
+void olken_tree::attach(olken_tree::node *z)
+{
+  tally(m_stats.attaches);
 
-  node *z = new_node;
   node *y = m_nil.get();
   node *x = m_root;
 
@@ -147,73 +397,77 @@ olken_tree::node *olken_tree::insert(std::uint64_t const time, std::uint64_t con
     y->right = z;
   }
 
+  z->size = 1;
   z->left = m_nil.get();
   z->right = m_nil.get();
   z->red = true;
 
   fix_insert(z);
-
-  return new_node;
 }
 
-void olken_tree::erase(node *z)
+void olken_tree::detach(olken_tree::node *z)
 {
-  assert(m_root->parent == m_nil.get());
-
-  auto const address = z->address;
+  tally(m_stats.detaches);
 
-  // y will either be z or z's successor, which has no left child
-  node *y = nullptr;
-  if(z->left == m_nil.get() || z->right == m_nil.get()) {
-    // z has at most one child
-    y = z;
-  } else {
-    // z has two children
-    y = successor(z);
+  // y is the node that is physically removed from its position: z itself, or z's successor (no left child).
+  node *y = z;
+  if(z->left != m_nil.get() && z->right != m_nil.get()) {
+    y = z->right;
+    while(y->left != m_nil.get()) {
+      y = y->left;
+    }
   }
 
-  // y will be spliced out, update subtree sizes by traversing back to root
-  node *i = y->parent;
-  do {
-    if(i->size > 0) {
-      i->size--;
-    }
+  // Update subtree sizes by traversing from y's position back to the root.
+  for(node *i = y->parent; i != m_nil.get(); i = i->parent) {
+    i->size--;
+  }
 
-    i = i->parent;
-  } while(i != m_nil.get());
+  bool removed_red = y->red;
 
-  // x will either be nil or the non-nil child of y
+  // x will either be nil or the node that moves into y's position.
   node *x = nullptr;
-  if(y->left != m_nil.get()) {
-    x = y->left;
+  if(z->left == m_nil.get()) {
+    x = z->right;
+    transplant(z, z->right);
+  } else if(z->right == m_nil.get()) {
+    x = z->left;
+    transplant(z, z->left);
   } else {
+    // The successor y takes z's place (and colour), instead of copying y's payload into z.
     x = y->right;
-  }
 
-  x->parent = y->parent;
-
-  if(y->parent == m_nil.get()) {
-    m_root = x;
-  } else {
-    if(y == y->parent->left) {
-      y->parent->left = x;
+    if(y->parent == z) {
+      x->parent = y;
     } else {
-      y->parent->right = x;
+      transplant(y, y->right);
+      y->right = z->right;
+      y->right->parent = y;
     }
-  }
 
-  if(y != z) {
-    z->time = y->time;
-    z->address = y->address;
-    m_hashmap[z->address] = z;
+    transplant(z, y);
+    y->left = z->left;
+    y->left->parent = y;
+    y->red = z->red;
+    y->size = z->size;
   }
 
-  if(!y->red) {
+  if(!removed_red) {
     fix_delete(x);
   }
+}
 
-  delete y;
-  m_hashmap.erase(address);
+void olken_tree::transplant(olken_tree::node *u, olken_tree::node *v)
+{
+  if(u->parent == m_nil.get()) {
+    m_root = v;
+  } else if(u == u->parent->left) {
+    u->parent->left = v;
+  } else {
+    u->parent->right = v;
+  }
+
+  v->parent = u->parent;
 }
 
 void olken_tree::fix_insert(olken_tree::node *z)
@@ -233,12 +487,12 @@ void olken_tree::fix_insert(olken_tree::node *z)
         if(z == z->parent->right) {
           // z is on the right side of its parent
           z = z->parent;
-          rotate_left(z);
+          rotate_left(z, m_stats.attach_rotations);
         }
 
         z->parent->red = false;
         z->parent->parent->red = true;
-        rotate_right(z->parent->parent);
+        rotate_right(z->parent->parent, m_stats.attach_rotations);
       }
     } else {
       // symmetric to the above if-clause
@@ -253,12 +507,12 @@ void olken_tree::fix_insert(olken_tree::node *z)
       } else {
         if(z == z->parent->left) {
           z = z->parent;
-          rotate_right(z);
+          rotate_right(z, m_stats.attach_rotations);
         }
 
         z->parent->red = false;
         z->parent->parent->red = true;
-        rotate_left(z->parent->parent);
+        rotate_left(z->parent->parent, m_stats.attach_rotations);
       }
     }
   }
@@ -277,7 +531,7 @@ void olken_tree::fix_delete(olken_tree::node *x)
         w->red = false;
         x->parent->red = true;
 
-        rotate_left(x->parent);
+        rotate_left(x->parent, m_stats.detach_rotations);
         w = x->parent->right;
       }
 
@@ -291,7 +545,7 @@ void olken_tree::fix_delete(olken_tree::node *x)
           w->left->red = false;
           w->red = true;
 
-          rotate_right(w);
+          rotate_right(w, m_stats.detach_rotations);
           w = x->parent->right;
         }
 
@@ -300,7 +554,7 @@ void olken_tree::fix_delete(olken_tree::node *x)
         x->parent->red = false;
         w->right->red = false;
 
-        rotate_left(x->parent);
+        rotate_left(x->parent, m_stats.detach_rotations);
         x = m_root;
       }
     } else {
@@ -311,7 +565,7 @@ void olken_tree::fix_delete(olken_tree::node *x)
         w->red = false;
         x->parent->red = true;
 
-        rotate_right(x->parent);
+        rotate_right(x->parent, m_stats.detach_rotations);
         w = x->parent->left;
       }
 
@@ -325,7 +579,7 @@ void olken_tree::fix_delete(olken_tree::node *x)
           w->right->red = false;
           w->red = true;
 
-          rotate_left(w);
+          rotate_left(w, m_stats.detach_rotations);
           w = x->parent->left;
         }
 
@@ -334,7 +588,7 @@ void olken_tree::fix_delete(olken_tree::node *x)
         x->parent->red = false;
         w->left->red = false;
 
-        rotate_right(x->parent);
+        rotate_right(x->parent, m_stats.detach_rotations);
         x = m_root;
       }
     }
@@ -343,8 +597,10 @@ void olken_tree::fix_delete(olken_tree::node *x)
   x->red = false;
 }
 
-void olken_tree::rotate_left(olken_tree::node *x)
+void olken_tree::rotate_left(olken_tree::node *x, std::uint64_t &rotations)
 {
+  tally(rotations);
+
   // y is x's right subtree
   node *y = x->right;
   // Turn y's left subtree into x's right subtree
@@ -375,8 +631,10 @@ void olken_tree::rotate_left(olken_tree::node *x)
   x->size = x->left->size + x->right->size + 1;
 }
 
-void olken_tree::rotate_right(olken_tree::node *y)
+void olken_tree::rotate_right(olken_tree::node *y, std::uint64_t &rotations)
 {
+  tally(rotations);
+
   node *x = y->left;
   y->left = x->right;
 
@@ -2,11 +2,23 @@
 
 #include "reuse-distance/olken.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <stdexcept>
+#include <vector>
 
 namespace reuse_distance {
 
 double compute_distance(olken_tree const &tree, uint64_t address)
+{
+  if(tree.max_age() != 0) {
+    throw std::invalid_argument("The distance in a tree with a maximum age depends on the time of the access.");
+  }
+
+  return compute_distance(tree, address, 0);
+}
+
+double compute_distance(olken_tree const &tree, std::uint64_t address, std::uint64_t time)
 {
   auto node = tree.find_address(address); // O(1)
 
@@ -14,18 +26,121 @@ double compute_distance(olken_tree const &tree, uint64_t address)
     return std::numeric_limits<double>::infinity();
   }
 
-  return tree.calculate_position(node);
+  // The same horizon as olken_tree::expire(), so the node would be evicted by the update of this access.
+  if(tree.max_age() != 0 && node->time < time && time - node->time > tree.max_age()) {
+    return std::numeric_limits<double>::infinity();
+  }
+
+  auto const position = tree.calculate_position(node);
+  if(tree.max_distance() != 0 && position >= static_cast<double>(tree.max_distance())) {
+    return std::numeric_limits<double>::infinity();
+  }
+
+  return position;
 }
 
 void update(olken_tree &tree, std::uint64_t address, std::uint64_t time)
+{
+  tree.expire(time);
+
+  auto const result = tree.find_or_insert(time, address); // O(1)
+
+  if(!result.second) {
+    tree.move_to_most_recent(result.first, time);
+  }
+}
+
+double access(olken_tree &tree, std::uint64_t address, std::uint64_t time)
+{
+  tree.expire(time);
+
+  auto const result = tree.find_or_insert(time, address); // O(1)
+
+  if(result.second) {
+    return std::numeric_limits<double>::infinity();
+  }
+
+  auto const distance = tree.calculate_position(result.first);
+  tree.move_to_most_recent(result.first, time);
+
+  return distance;
+}
+
+void access(olken_tree &tree,
+    std::uint64_t const *addresses,
+    std::size_t count,
+    std::uint64_t time,
+    double *distances)
+{
+  // The node of an address is found through its hashmap slot, so the slots are prefetched a window further ahead.
+  for(std::size_t i = 0; i < std::min(count, 2 * PREFETCH_DISTANCE); i++) {
+    tree.prefetch_address(addresses[i]);
+  }
+
+  for(std::size_t i = 0; i < count; i++) {
+    if(i + 2 * PREFETCH_DISTANCE < count) {
+      tree.prefetch_address(addresses[i + 2 * PREFETCH_DISTANCE]);
+    }
+
+    if(i + PREFETCH_DISTANCE < count) {
+      tree.prefetch_node(addresses[i + PREFETCH_DISTANCE]);
+    }
+
+    distances[i] = access(tree, addresses[i], time + i);
+  }
+}
+
+bool erase(olken_tree &tree, std::uint64_t address)
 {
   auto node = tree.find_address(address); // O(1)
 
-  if(node != nullptr) {
-    tree.erase(node);
+  if(node == nullptr) {
+    return false;
   }
 
-  tree.insert(time, address);
+  tree.erase(node);
+
+  return true;
+}
+
+std::size_t erase_if(olken_tree &tree, std::function<bool(std::uint64_t)> const &predicate)
+{
+  std::vector<olken_tree::node *> matches;
+
+  auto node = tree.least_recently_used();
+  for(std::size_t i = 0; i < tree.size(); i++) {
+    if(predicate(node->address)) {
+      matches.push_back(node);
+    }
+
+    node = tree.successor(node);
+  }
+
+  for(auto n : matches) {
+    tree.erase(n);
+  }
+
+  return matches.size();
+}
+
+snapshot save(olken_tree const &tree, std::uint64_t clock)
+{
+  snapshot s;
+  s.clock = clock;
+  s.entries.reserve(tree.size());
+
+  auto node = tree.most_recently_used();
+  for(std::size_t i = 0; i < tree.size(); i++) {
+    s.entries.push_back({node->time, node->address});
+    node = tree.predecessor(node);
+  }
+
+  return s;
+}
+
+void restore(olken_tree &tree, snapshot const &s)
+{
+  tree.build(s.entries);
 }
 
 } // namespace reuse_distance
\ No newline at end of file
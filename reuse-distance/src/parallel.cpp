@@ -0,0 +1,123 @@
+#include "reuse-distance/parallel.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <thread>
+
+namespace reuse_distance {
+
+// Chunks with fewer accesses than this are not worth a thread.
+constexpr std::size_t MIN_CHUNK_SIZE = 4096;
+
+template <typename Tree>
+void parallel_access(Tree &tree,
+    std::vector<std::uint64_t> const &addresses,
+    std::uint64_t time,
+    std::vector<double> &distances,
+    std::size_t threads)
+{
+  constexpr double INF = std::numeric_limits<double>::infinity();
+
+  auto const count = addresses.size();
+  distances.resize(count);
+
+  auto const chunks = std::max<std::size_t>(1, std::min(threads, count / MIN_CHUNK_SIZE));
+  auto const chunk_size = (count + chunks - 1) / chunks;
+
+  if(chunks == 1) {
+    access(tree, addresses.data(), count, time, distances.data());
+
+    return;
+  }
+
+  // The local stack of each chunk, and the positions of the first access to each address in the chunk.
+  std::vector<olken_tree> local(chunks);
+  std::vector<std::vector<std::size_t>> first_accesses(chunks);
+
+  auto const analyze_chunk = [&](std::size_t chunk) {
+    auto const begin = chunk * chunk_size;
+    auto const end = std::min(count, begin + chunk_size);
+
+    access(local[chunk], addresses.data() + begin, end - begin, time + begin, distances.data() + begin);
+
+    for(auto i = begin; i < end; i++) {
+      if(distances[i] == INF) {
+        first_accesses[chunk].push_back(i);
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for(std::size_t chunk = 1; chunk < chunks; chunk++) {
+    workers.emplace_back(analyze_chunk, chunk);
+  }
+
+  analyze_chunk(0);
+
+  for(auto &worker : workers) {
+    worker.join();
+  }
+
+  // Resolve the first accesses against the shared tree, in the order of the chunks.
+  for(std::size_t chunk = 0; chunk < chunks; chunk++) {
+    for(auto const i : first_accesses[chunk]) {
+      distances[i] = access(tree, addresses[i], time + i);
+    }
+
+    // The addresses of the chunk are now ordered by their first access, reinsert them ordered by their last access.
+    auto node = local[chunk].least_recently_used();
+    for(std::size_t i = 0; i < local[chunk].size(); i++) {
+      erase(tree, node->address);
+      node = local[chunk].successor(node);
+    }
+
+    node = local[chunk].least_recently_used();
+    for(std::size_t i = 0; i < local[chunk].size(); i++) {
+      update(tree, node->address, node->time);
+      node = local[chunk].successor(node);
+    }
+  }
+}
+
+template <>
+void parallel_access(reuse_time_tracker &tracker,
+    std::vector<std::uint64_t> const &addresses,
+    std::uint64_t time,
+    std::vector<double> &reuse_times,
+    std::size_t)
+{
+  reuse_times.resize(addresses.size());
+
+  access(tracker, addresses.data(), addresses.size(), time, reuse_times.data());
+}
+
+template void parallel_access(olken_tree &tree,
+    std::vector<std::uint64_t> const &addresses,
+    std::uint64_t time,
+    std::vector<double> &distances,
+    std::size_t threads);
+
+template void parallel_access(fenwick_tree &tree,
+    std::vector<std::uint64_t> const &addresses,
+    std::uint64_t time,
+    std::vector<double> &distances,
+    std::size_t threads);
+
+template void parallel_access(compact_tree &tree,
+    std::vector<std::uint64_t> const &addresses,
+    std::uint64_t time,
+    std::vector<double> &distances,
+    std::size_t threads);
+
+template void parallel_access(bplus_tree &tree,
+    std::vector<std::uint64_t> const &addresses,
+    std::uint64_t time,
+    std::vector<double> &distances,
+    std::size_t threads);
+
+template void parallel_access(approximate_tree &tree,
+    std::vector<std::uint64_t> const &addresses,
+    std::uint64_t time,
+    std::vector<double> &distances,
+    std::size_t threads);
+} // namespace reuse_distance
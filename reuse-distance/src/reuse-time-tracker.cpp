@@ -0,0 +1,66 @@
+#include "reuse-distance/reuse-time-tracker.hpp"
+
+#include <limits>
+
+namespace reuse_distance {
+
+bool reuse_time_tracker::empty() const
+{
+  return m_last_access.empty();
+}
+
+std::size_t reuse_time_tracker::size() const
+{
+  return m_last_access.size();
+}
+
+std::uint64_t const *reuse_time_tracker::find_address(std::uint64_t address) const
+{
+  return m_last_access.find(address);
+}
+
+void reuse_time_tracker::prefetch_address(std::uint64_t address) const
+{
+  m_last_access.prefetch(address);
+}
+
+double reuse_time_tracker::touch(std::uint64_t address)
+{
+  auto const entry = m_last_access.insert(address, m_time);
+  auto const previous = *entry.first;
+
+  *entry.first = m_time++;
+
+  if(entry.second) {
+    m_first_accesses++;
+
+    return std::numeric_limits<double>::infinity();
+  }
+
+  // The accesses strictly between the previous access and this one.
+  auto const reuse_time = m_time - previous - 2;
+  m_reuse_times[reuse_time]++;
+
+  return static_cast<double>(reuse_time);
+}
+
+bool reuse_time_tracker::erase(std::uint64_t address)
+{
+  return m_last_access.erase(address);
+}
+
+std::map<double, std::uint64_t> reuse_time_tracker::histogram() const
+{
+  std::map<double, std::uint64_t> result;
+
+  for(auto const &bin : m_reuse_times) {
+    result[static_cast<double>(bin.first)] = bin.second;
+  }
+
+  if(m_first_accesses > 0) {
+    result[std::numeric_limits<double>::infinity()] = m_first_accesses;
+  }
+
+  return result;
+}
+} // namespace reuse_distance
@@ -0,0 +1,59 @@
+#include "reuse-distance/reuse-time.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace reuse_distance {
+
+void update(reuse_time_tracker &tracker, std::uint64_t address, std::uint64_t)
+{
+  tracker.touch(address);
+}
+
+double access(reuse_time_tracker &tracker, std::uint64_t address, std::uint64_t)
+{
+  return tracker.touch(address);
+}
+
+void access(reuse_time_tracker &tracker,
+    std::uint64_t const *addresses,
+    std::size_t count,
+    std::uint64_t,
+    double *reuse_times)
+{
+  for(std::size_t i = 0; i < std::min(count, PREFETCH_DISTANCE); i++) {
+    tracker.prefetch_address(addresses[i]);
+  }
+
+  for(std::size_t i = 0; i < count; i++) {
+    if(i + PREFETCH_DISTANCE < count) {
+      tracker.prefetch_address(addresses[i + PREFETCH_DISTANCE]);
+    }
+
+    reuse_times[i] = tracker.touch(addresses[i]);
+  }
+}
+
+bool erase(reuse_time_tracker &tracker, std::uint64_t address)
+{
+  return tracker.erase(address);
+}
+
+std::size_t erase_if(reuse_time_tracker &tracker, std::function<bool(std::uint64_t)> const &predicate)
+{
+  std::vector<std::uint64_t> matches;
+
+  tracker.for_each([&predicate, &matches](std::uint64_t address) {
+    if(predicate(address)) {
+      matches.push_back(address);
+    }
+  });
+
+  for(auto const address : matches) {
+    tracker.erase(address);
+  }
+
+  return matches.size();
+}
+
+} // namespace reuse_distance
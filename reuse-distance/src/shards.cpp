@@ -0,0 +1,118 @@
+#include "reuse-distance/shards.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include "reuse-distance/hash.hpp"
+#include "reuse-distance/snapshot.hpp"
+
+namespace reuse_distance {
+
+constexpr unsigned MAX_SHIFT = 63;
+
+shards::shards(double rate, std::size_t max_samples) : m_max_samples(max_samples)
+{
+  if(!(rate > 0.0 && rate <= 1.0)) {
+    throw std::invalid_argument("The sampling rate must be in the range (0, 1].");
+  }
+
+  // Round the rate down to a power of two.
+  while(m_shift < MAX_SHIFT && rate < 1.0 / static_cast<double>(scale())) {
+    m_shift++;
+  }
+}
+
+bool shards::sample(std::uint64_t address) const
+{
+  if(m_shift == 0) {
+    return true;
+  }
+
+  return (hash(address) >> (64u - m_shift)) == 0;
+}
+
+bool shards::track(std::uint64_t address)
+{
+  if(m_max_samples == 0) {
+    return false;
+  }
+
+  m_tracked.insert(address);
+  if(m_tracked.size() <= m_max_samples) {
+    return false;
+  }
+
+  // Halve the rate until the sample fits, i.e., drop the addresses whose next hash bit is set.
+  while(m_tracked.size() > m_max_samples && m_shift < MAX_SHIFT) {
+    m_shift++;
+
+    for(auto it = m_tracked.begin(); it != m_tracked.end();) {
+      if(sample(*it)) {
+        ++it;
+      } else {
+        it = m_tracked.erase(it);
+      }
+    }
+  }
+
+  return true;
+}
+
+bool shards::tracking(std::uint64_t address) const
+{
+  return m_tracked.count(address) != 0;
+}
+
+double shards::rate() const
+{
+  return 1.0 / static_cast<double>(scale());
+}
+
+std::uint64_t shards::scale() const
+{
+  return std::uint64_t{1} << m_shift;
+}
+
+std::size_t shards::tracked() const
+{
+  return m_tracked.size();
+}
+
+std::size_t shards::max_samples() const
+{
+  return m_max_samples;
+}
+
+void shards::save(std::ostream &stream) const
+{
+  write_varint(stream, m_shift);
+  write_varint(stream, m_max_samples);
+
+  // Sorted, so the same sample is always written the same way.
+  std::vector<std::uint64_t> tracked(m_tracked.begin(), m_tracked.end());
+  std::sort(tracked.begin(), tracked.end());
+
+  write_varint(stream, tracked.size());
+  for(auto const address : tracked) {
+    write_varint(stream, address);
+  }
+}
+
+void shards::restore(std::istream &stream)
+{
+  auto const shift = read_varint(stream);
+  if(shift > MAX_SHIFT) {
+    throw std::runtime_error("The snapshot holds an invalid sampling rate.");
+  }
+
+  m_shift = static_cast<unsigned>(shift);
+  m_max_samples = static_cast<std::size_t>(read_varint(stream));
+
+  auto const tracked = read_varint(stream);
+  m_tracked.clear();
+  for(std::uint64_t i = 0; i < tracked; i++) {
+    m_tracked.insert(read_varint(stream));
+  }
+}
+} // namespace reuse_distance
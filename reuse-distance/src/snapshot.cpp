@@ -0,0 +1,126 @@
+#include "reuse-distance/snapshot.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace reuse_distance {
+
+constexpr char SNAPSHOT_MAGIC[] = {'R', 'D', 'S', 'N'};
+constexpr std::uint64_t SNAPSHOT_VERSION = 1;
+
+// Map a signed difference to an unsigned integer, so small differences of either sign stay small.
+inline std::uint64_t zigzag(std::uint64_t difference)
+{
+  return (difference << 1u) ^ (0 - (difference >> 63u));
+}
+
+inline std::uint64_t unzigzag(std::uint64_t value)
+{
+  return (value >> 1u) ^ (0 - (value & 1u));
+}
+
+void sort_by_recency(std::vector<snapshot_entry> &entries)
+{
+  std::sort(entries.begin(), entries.end(), [](snapshot_entry const &a, snapshot_entry const &b) {
+    return a.time > b.time;
+  });
+}
+
+void write_varint(std::ostream &stream, std::uint64_t value)
+{
+  char buffer[10];
+  std::size_t length = 0;
+
+  while(value >= 0x80) {
+    buffer[length++] = static_cast<char>((value & 0x7fu) | 0x80u);
+    value >>= 7u;
+  }
+  buffer[length++] = static_cast<char>(value);
+
+  if(!stream.write(buffer, static_cast<std::streamsize>(length))) {
+    throw std::runtime_error("Failed to write to the snapshot.");
+  }
+}
+
+std::uint64_t read_varint(std::istream &stream)
+{
+  std::uint64_t value = 0;
+
+  for(unsigned shift = 0; shift < 64; shift += 7) {
+    auto const byte = stream.get();
+    if(byte == std::istream::traits_type::eof()) {
+      throw std::runtime_error("The snapshot ended unexpectedly.");
+    }
+
+    value |= (static_cast<std::uint64_t>(byte) & 0x7fu) << shift;
+    if((byte & 0x80) == 0) {
+      return value;
+    }
+  }
+
+  throw std::runtime_error("The snapshot holds a malformed integer.");
+}
+
+void write_snapshot(std::ostream &stream, snapshot const &s)
+{
+  if(!stream.write(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC))) {
+    throw std::runtime_error("Failed to write to the snapshot.");
+  }
+
+  write_varint(stream, SNAPSHOT_VERSION);
+  write_varint(stream, s.clock);
+  write_varint(stream, s.entries.size());
+
+  auto time = s.clock;
+  std::uint64_t address = 0;
+  for(auto const &e : s.entries) {
+    if(e.time >= time) {
+      throw std::invalid_argument("The entries of a snapshot must be in descending order of time, before the clock.");
+    }
+
+    // The gap is at least one, so the stored value is one less.
+    write_varint(stream, time - e.time - 1);
+    write_varint(stream, zigzag(e.address - address));
+
+    time = e.time;
+    address = e.address;
+  }
+}
+
+snapshot read_snapshot(std::istream &stream)
+{
+  char magic[sizeof(SNAPSHOT_MAGIC)];
+  if(!stream.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), SNAPSHOT_MAGIC)) {
+    throw std::runtime_error("The stream does not hold a reuse-distance snapshot.");
+  }
+
+  if(read_varint(stream) != SNAPSHOT_VERSION) {
+    throw std::runtime_error("The version of the reuse-distance snapshot is not supported.");
+  }
+
+  snapshot s;
+  s.clock = read_varint(stream);
+
+  auto const count = read_varint(stream);
+  if(count > s.clock) {
+    throw std::runtime_error("The snapshot holds more addresses than accesses.");
+  }
+  s.entries.reserve(count);
+
+  auto time = s.clock;
+  std::uint64_t address = 0;
+  for(std::uint64_t i = 0; i < count; i++) {
+    auto const gap = read_varint(stream);
+    if(gap >= time) {
+      throw std::runtime_error("The snapshot holds a time before the start of the trace.");
+    }
+
+    time -= gap + 1;
+    address += unzigzag(read_varint(stream));
+
+    s.entries.push_back({time, address});
+  }
+
+  return s;
+}
+} // namespace reuse_distance
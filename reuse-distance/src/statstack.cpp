@@ -0,0 +1,85 @@
+#include "reuse-distance/statstack.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace reuse_distance {
+
+statstack::statstack(std::map<double, std::uint64_t> const &reuse_times)
+{
+  constexpr double INF = std::numeric_limits<double>::infinity();
+
+  std::uint64_t total = 0;
+  for(auto const &bin : reuse_times) {
+    total += bin.second;
+  }
+
+  if(total == 0) {
+    m_at_least.push_back(0.0);
+    return;
+  }
+
+  // The number of accesses with a reuse time of at least the current bin.
+  auto remaining = total;
+
+  double previous_time = 0.0;
+  double previous_distance = 0.0;
+
+  for(auto const &bin : reuse_times) {
+    auto const at_least = static_cast<double>(remaining) / static_cast<double>(total);
+    m_at_least.push_back(at_least);
+
+    if(bin.first == INF) {
+      break;
+    }
+
+    // P(R >= k) is constant for k in (previous_time, bin.first], so the sum over that range is a product.
+    previous_distance += (bin.first - previous_time) * at_least;
+    previous_time = bin.first;
+
+    m_times.push_back(bin.first);
+    m_distances.push_back(previous_distance);
+
+    remaining -= bin.second;
+  }
+
+  // Past the largest finite reuse time, only first accesses remain.
+  if(m_at_least.size() == m_times.size()) {
+    m_at_least.push_back(0.0);
+  }
+}
+
+double statstack::distance(double reuse_time) const
+{
+  if(reuse_time == std::numeric_limits<double>::infinity()) {
+    return reuse_time;
+  }
+
+  // Find the first known reuse time that is not smaller, and interpolate from the one before it.
+  auto const next = std::lower_bound(m_times.begin(), m_times.end(), reuse_time);
+  auto const i = static_cast<std::size_t>(next - m_times.begin());
+
+  if(next != m_times.end() && *next == reuse_time) {
+    return m_distances[i];
+  }
+
+  auto const previous_time = i == 0 ? 0.0 : m_times[i - 1];
+  auto const previous_distance = i == 0 ? 0.0 : m_distances[i - 1];
+
+  return previous_distance + (reuse_time - previous_time) * m_at_least[i];
+}
+
+std::map<double, std::uint64_t> statstack::convert(std::map<double, std::uint64_t> const &reuse_times) const
+{
+  std::map<double, std::uint64_t> distances;
+
+  for(auto const &bin : reuse_times) {
+    auto const d = distance(bin.first);
+
+    distances[std::isinf(d) ? d : std::round(d)] += bin.second;
+  }
+
+  return distances;
+}
+} // namespace reuse_distance
@@ -1,6 +1,5 @@
 #include "modelgen.hpp"
 
-#include <fstream>
 
 #include "spdlog/spdlog.h"
 #include "spdlog/sinks/stdout_sinks.h"
@@ -27,8 +26,8 @@ void generate_stm_model(std::string const &input_filename,
   spdlog::get("log")->info("Stride Depth: {}", parameters.stride_depth);
   spdlog::get("log")->info("Interval Size: {}", interval_size);
 
-  std::ifstream input_file(input_filename);
-  iogem5::packet_trace_reader trace(input_file);
+  // Decompress the trace on another thread, while this one updates the model.
+  iogem5::packet_trace_reader trace(input_filename, ioproto::read_mode::async);
   spdlog::get("log")->info("Opened trace file: {}", input_filename);
 
   ioproto::ofstream output(output_filename, GEM5_MAGIC_NUMBER);
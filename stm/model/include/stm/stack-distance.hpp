@@ -4,14 +4,19 @@
 #include <cstdint>
 #include <vector>
 
+#include "reuse-distance/fenwick.hpp"
 #include "reuse-distance/olken.hpp"
 
 namespace stm {
 
 /**
  * The Stack Distance Count (SDC) table captures tight reuse distances in a tagged cache-like structure.
+ *
+ * @tparam Tree The reuse-distance backend (e.g., reuse_distance::olken_tree), which must support
+ * reuse_distance::access.
  */
-class sdc_table {
+template <typename Tree>
+class basic_sdc_table {
 public:
   /**
    * Constructor.
@@ -19,21 +24,21 @@ public:
    * @param num_rows Number of rows in the table.
    * @param num_columns Number of reuse distances to track, starting from 0.
    */
-  sdc_table(std::size_t num_rows, std::size_t num_columns);
+  basic_sdc_table(std::size_t num_rows, std::size_t num_columns);
 
   /**
    * Copy Constructor.
    *
    * Does not copy intermediate data structures used for tracking.
    */
-  sdc_table(sdc_table const &table);
+  basic_sdc_table(basic_sdc_table const &table);
 
   /**
    * Copy on assignment.
    *
    * Resets intermediate data structures used for tracking.
    */
-  sdc_table& operator=(sdc_table const &table);
+  basic_sdc_table &operator=(basic_sdc_table const &table);
 
   /**
    * Update the table based on the accessed address.
@@ -82,9 +87,14 @@ private:
 
   std::size_t col_count;
 
-  reuse_distance::olken_tree olken;
+  Tree tree;
   std::uint64_t time = 0;
 };
+
+/**
+ * An SDC table that uses the olken_tree to calculate reuse distances.
+ */
+using sdc_table = basic_sdc_table<reuse_distance::olken_tree>;
 } // namespace stm
 
 #endif //STM_CLONING_SDC_TABLE_HPP
@@ -1,6 +1,7 @@
 #ifndef STM_CLONING_SPC_TABLE_HPP
 #define STM_CLONING_SPC_TABLE_HPP
 
+#include <cstddef>
 #include <cstdint>
 #include <deque>
 #include <map>
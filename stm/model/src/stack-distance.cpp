@@ -1,36 +1,60 @@
 #include "stm/stack-distance.hpp"
 
+#include <algorithm>
 #include <cmath>
 
 namespace stm {
 
-sdc_table::sdc_table(std::size_t num_rows, std::size_t num_columns)
-    : rows(num_rows), row_count(num_rows), col_count(num_columns)
+/**
+ * Create the tree for a table of a number of columns.
+ */
+template <typename Tree>
+inline Tree make_tree(std::size_t)
+{
+  return Tree{};
+}
+
+/**
+ * Distances from the last column onwards are counted in the last column, so the olken_tree only needs to keep the
+ * blocks in front of it.
+ */
+template <>
+inline reuse_distance::olken_tree make_tree<reuse_distance::olken_tree>(std::size_t num_columns)
+{
+  return reuse_distance::olken_tree(std::max<std::size_t>(num_columns, 2) - 1, 0);
+}
+
+template <typename Tree>
+basic_sdc_table<Tree>::basic_sdc_table(std::size_t num_rows, std::size_t num_columns)
+    : rows(num_rows), row_count(num_rows), col_count(num_columns), tree(make_tree<Tree>(num_columns))
 {
   for(auto &r : rows) {
     r.columns.resize(num_columns);
   }
 }
 
-sdc_table::sdc_table(sdc_table const &table)
-    : rows(table.rows), row_count(table.row_count), col_count(table.col_count)
+template <typename Tree>
+basic_sdc_table<Tree>::basic_sdc_table(basic_sdc_table const &table)
+    : rows(table.rows), row_count(table.row_count), col_count(table.col_count), tree(make_tree<Tree>(table.col_count))
 {
 }
 
-sdc_table &sdc_table::operator=(sdc_table const &table)
+template <typename Tree>
+basic_sdc_table<Tree> &basic_sdc_table<Tree>::operator=(basic_sdc_table const &table)
 {
   rows = table.rows;
   row_count = table.row_count;
   col_count = table.col_count;
 
-  olken = reuse_distance::olken_tree{};
+  tree = make_tree<Tree>(col_count);
   time = 0;
 
   return *this;
 }
 
 
-bool sdc_table::update(uint64_t const address)
+template <typename Tree>
+bool basic_sdc_table<Tree>::update(uint64_t const address)
 {
   if(rows.empty()) {
     return false;
@@ -45,13 +69,13 @@ bool sdc_table::update(uint64_t const address)
 
   auto &r = rows.at(row_index);
 
-  // the stack distance needs to be clamped to the maximum column index
-  auto const stack_distance =
-      static_cast<std::size_t>(reuse_distance::compute_distance(olken, address));
-  reuse_distance::update(olken, address, time);
+  auto const stack_distance = reuse_distance::access(tree, address, time);
   time = time + 1;
 
-  auto const column_index = std::min(stack_distance, column_size() - 1);
+  // the stack distance needs to be clamped to the maximum column index, so a cold (infinite) distance goes to the
+  // last column with the other distances that are too large for the table
+  auto const max_column = static_cast<double>(column_size() - 1);
+  auto const column_index = static_cast<std::size_t>(std::min(stack_distance, max_column));
 
   auto &c = r.columns.at(column_index);
 
@@ -75,4 +99,7 @@ bool sdc_table::update(uint64_t const address)
   }
 }
 
+template class basic_sdc_table<reuse_distance::olken_tree>;
+template class basic_sdc_table<reuse_distance::fenwick_tree>;
+
 } // namespace stm
\ No newline at end of file
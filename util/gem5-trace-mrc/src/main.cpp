@@ -0,0 +1,112 @@
+#include <fstream>
+#include <iostream>
+
+#include "argagg.hpp"
+
+#include <iogem5/packet-trace.hpp>
+#include <reuse-distance/counter-stacks.hpp>
+
+argagg::parser create_command_line_interface()
+{
+  return {{{"help", {"-h", "--help"}, "Display help information.", 0},
+      {"input", {"-i", "--input"}, "gem5 packet trace.", 1},
+      {"output", {"-o", "--output"}, "Output CSV file of cache sizes and miss ratios.", 1},
+      {"block", {"--block-size"}, "Cache block size in bytes (default: 64).", 1},
+      {"step", {"--step"}, "Number of accesses between two counters (default: 1024).", 1},
+      {"pruning", {"--pruning"}, "Prune a counter within this fraction of an older counter (default: 0.02).", 1},
+      {"precision", {"--precision"}, "Precision of the HyperLogLog counters, 4 to 18 (default: 12).", 1}}};
+}
+
+void print_usage(std::ostream &stream, argagg::parser const &arguments)
+{
+  argagg::fmt_ostream help(stream);
+
+  help << "Estimate the LRU miss-ratio curve of a gem5 packet trace in one pass, using counter stacks.\n\n";
+  help << "gem5-trace-mrc [options] ARG [ARG...]\n\n";
+  help << arguments;
+}
+
+void ensure_file_exists(std::string const &path_to_file)
+{
+  std::ifstream file(path_to_file);
+  if(!file.good()) {
+    throw std::runtime_error("The file " + path_to_file + " does not exist.");
+  }
+}
+
+void validate(argagg::parser_results const &arguments)
+{
+  if(arguments["input"].count() == 0) {
+    throw std::runtime_error("Missing path gem5 packet trace.");
+  } else {
+    ensure_file_exists(arguments["input"].as<std::string>());
+  }
+
+  if(arguments["output"].count() == 0) {
+    throw std::runtime_error("Missing path to output file.");
+  }
+
+  if(arguments["block"].as<std::uint64_t>(64) == 0) {
+    throw std::runtime_error("The block size must be greater than zero.");
+  }
+}
+
+void estimate_mrc(std::string const &input_filename,
+    std::string const &output_filename,
+    std::uint64_t block_size,
+    reuse_distance::counter_stacks stacks)
+{
+  iogem5::packet_trace_reader reader(input_filename);
+
+  iogem5::packet packet{};
+  while(reader.read(&packet)) {
+    stacks.access(packet.address / block_size);
+  }
+  stacks.flush();
+
+  std::ofstream output(output_filename);
+  output << "blocks,bytes,miss_ratio\n";
+  for(auto const &point : stacks.miss_ratio_curve()) {
+    auto const blocks = static_cast<std::uint64_t>(point.first);
+    output << blocks << ',' << blocks * block_size << ',' << point.second << '\n';
+  }
+
+  std::cout << "Read " << stacks.count() << " packets from " << input_filename << " using " << stacks.counters()
+            << " counters (" << stacks.memory_usage() << " bytes)." << std::endl;
+  std::cout << "Wrote the miss-ratio curve to " << output_filename << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+  try {
+    // Parse the command line.
+    auto interface = create_command_line_interface();
+    auto const arguments = interface.parse(argc, argv);
+
+    // Check if help was requested.
+    if(arguments["help"]) {
+      print_usage(std::cout, interface);
+
+      return EXIT_SUCCESS;
+    }
+
+    // Make sure we have the required arguments.
+    validate(arguments);
+
+    auto const input_filename = arguments["input"].as<std::string>();
+    auto const output_filename = arguments["output"].as<std::string>();
+    auto const block_size = arguments["block"].as<std::uint64_t>(64);
+
+    reuse_distance::counter_stacks stacks(arguments["step"].as<std::uint64_t>(1024),
+        arguments["pruning"].as<double>(0.02),
+        arguments["precision"].as<unsigned>(12));
+
+    estimate_mrc(input_filename, output_filename, block_size, std::move(stacks));
+  } catch(std::exception const &e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
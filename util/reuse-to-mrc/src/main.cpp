@@ -0,0 +1,313 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "argagg.hpp"
+
+#include <hrd/metadata.hpp>
+#include <hrd/reuse-histogram.hpp>
+#include <iogem5/packet-trace.hpp>
+#include <ioproto/istream.hpp>
+#include <reuse-distance/bplus.hpp>
+
+static constexpr std::uint32_t GEM5_MAGIC_NUMBER = 0x356d6567;
+
+// The number of packets whose reuse distances are calculated as one batch.
+static constexpr std::size_t BATCH_SIZE = std::size_t{1} << 16u;
+
+argagg::parser create_command_line_interface()
+{
+  return {{{"help", {"-h", "--help"}, "Display help information.", 0},
+      {"input", {"-i", "--input"}, "gem5 packet trace, or HRD model with --model.", 1},
+      {"model", {"--model"}, "The input is an HRD model instead of a gem5 packet trace.", 0},
+      {"output", {"-o", "--output"}, "Output CSV file of fully-associative cache sizes and miss ratios.", 1},
+      {"block", {"--block-size"}, "Cache block size in bytes of a trace, a model uses its smallest layer (default: 64).", 1},
+      {"precision", {"--precision"}, "Significant bits kept of the reuse distances of a trace, 1 to 24 (default: 10).", 1},
+      {"ways", {"--associativity"}, "Comma-separated associativities to estimate set-associative miss ratios for (e.g., 1,2,4,8,16).", 1},
+      {"ways_output", {"--associative-output"}, "Output CSV file of set-associative miss ratios per power-of-two cache size.", 1}}};
+}
+
+void print_usage(std::ostream &stream, argagg::parser const &arguments)
+{
+  argagg::fmt_ostream help(stream);
+
+  help << "Compute the LRU miss-ratio curves of a gem5 packet trace or an HRD model from its reuse distances.\n\n";
+  help << "reuse-to-mrc [options] ARG [ARG...]\n\n";
+  help << arguments;
+}
+
+void ensure_file_exists(std::string const &path_to_file)
+{
+  std::ifstream file(path_to_file);
+  if(!file.good()) {
+    throw std::runtime_error("The file " + path_to_file + " does not exist.");
+  }
+}
+
+void validate(argagg::parser_results const &arguments)
+{
+  if(arguments["input"].count() == 0) {
+    throw std::runtime_error("Missing path to gem5 packet trace or HRD model.");
+  } else {
+    ensure_file_exists(arguments["input"].as<std::string>());
+  }
+
+  if(arguments["output"].count() == 0) {
+    throw std::runtime_error("Missing path to output file.");
+  }
+
+  if(arguments["block"].as<std::uint64_t>(64) == 0) {
+    throw std::runtime_error("The block size must be greater than zero.");
+  }
+
+  if(arguments["ways"].count() != arguments["ways_output"].count()) {
+    throw std::runtime_error("The associativities and the set-associative output file must be given together.");
+  }
+}
+
+std::vector<std::uint64_t> parse_associativities(std::string const &argument)
+{
+  std::stringstream stream(argument);
+  std::string substring;
+
+  std::vector<std::uint64_t> associativities;
+
+  while(std::getline(stream, substring, ',')) {
+    std::uint64_t const ways = std::stoull(substring);
+    if(ways == 0) {
+      throw std::runtime_error("The associativity must be greater than zero.");
+    }
+
+    associativities.push_back(ways);
+  }
+
+  return associativities;
+}
+
+/**
+ * Calculate the reuse distance of every packet of a trace in blocks.
+ */
+hrd::reuse_histogram read_trace(std::string const &filename, std::uint64_t block_size, unsigned precision)
+{
+  iogem5::packet_trace_reader reader(filename);
+
+  hrd::reuse_histogram histogram(precision);
+  reuse_distance::bplus_tree tree;
+  std::uint64_t time = 0;
+
+  std::vector<std::uint64_t> blocks;
+  std::vector<double> distances(BATCH_SIZE);
+
+  auto const flush = [&]() {
+    reuse_distance::access(tree, blocks.data(), blocks.size(), time, distances.data());
+    for(std::size_t i = 0; i < blocks.size(); i++) {
+      histogram.add(distances[i]);
+    }
+
+    time += blocks.size();
+    blocks.clear();
+  };
+
+  iogem5::packet packet{};
+  while(reader.read(&packet)) {
+    blocks.push_back(packet.address / block_size);
+
+    if(blocks.size() == BATCH_SIZE) {
+      flush();
+    }
+  }
+  flush();
+
+  std::cout << "Read " << time << " packets from " << filename << " (" << tree.size() << " unique blocks of "
+            << block_size << " bytes)." << std::endl;
+
+  return histogram;
+}
+
+/**
+ * Take the reuse distances of the smallest layer of an HRD model, which counts every request of the trace.
+ */
+hrd::reuse_histogram read_model(std::string const &filename, std::uint64_t *block_size)
+{
+  ioproto::istream input(filename, GEM5_MAGIC_NUMBER);
+
+  std::uint64_t request_count = 0;
+  auto profile = hrd::read(input, &request_count);
+  if(profile.layers.empty()) {
+    throw std::runtime_error("The HRD model has no layers.");
+  }
+
+  *block_size = profile.layers.front();
+
+  std::cout << "Read an HRD model of " << request_count << " requests from " << filename << " (" << *block_size
+            << " byte blocks)." << std::endl;
+
+  return std::move(profile.reuse_model.front());
+}
+
+/**
+ * Write the miss ratio of a fully-associative LRU cache of every size at which it changes.
+ *
+ * An access hits in a cache of c blocks if its reuse distance is less than c.
+ */
+void write_fully_associative(std::string const &filename,
+    hrd::reuse_histogram const &histogram,
+    std::uint64_t block_size)
+{
+  std::ofstream output(filename);
+  output << "blocks,bytes,miss_ratio\n";
+
+  auto const total = static_cast<double>(histogram.total());
+  auto misses = histogram.total();
+
+  output << 0 << ',' << 0 << ',' << 1.0 << '\n';
+  histogram.for_each([&](double distance, std::uint64_t count) {
+    if(std::isinf(distance)) {
+      return;
+    }
+
+    misses -= count;
+
+    auto const blocks = static_cast<std::uint64_t>(std::floor(distance)) + 1;
+    output << blocks << ',' << blocks * block_size << ',' << static_cast<double>(misses) / total << '\n';
+  });
+
+  std::cout << "Wrote the fully-associative miss-ratio curve to " << filename << std::endl;
+}
+
+/**
+ * Estimate the probability that an access hits in a set-associative LRU cache.
+ *
+ * Assuming blocks map to sets uniformly at random, each of the distance blocks accessed since the last access to a
+ * block maps to its set with probability 1 / sets. The access hits if fewer than ways of them do, which is the lower
+ * tail of a binomial distribution (Smith, "A Comparative Study of Set Associative Memory Mapping Algorithms and Their
+ * Use for Cache and Main Memory").
+ */
+double hit_probability(double distance, std::uint64_t blocks, std::uint64_t ways)
+{
+  // A single set is fully associative.
+  if(blocks <= ways) {
+    return distance < static_cast<double>(blocks) ? 1.0 : 0.0;
+  }
+
+  auto const p = static_cast<double>(ways) / static_cast<double>(blocks);
+  auto const log_p = std::log(p);
+  auto const log_q = std::log1p(-p);
+
+  // Sum the terms in logarithms, so neither the binomial coefficients nor the powers overflow.
+  double probability = 0.0;
+  for(std::uint64_t k = 0; k < ways && static_cast<double>(k) <= distance; k++) {
+    auto const kd = static_cast<double>(k);
+    auto const log_term = std::lgamma(distance + 1.0) - std::lgamma(kd + 1.0) - std::lgamma(distance - kd + 1.0) +
+                          kd * log_p + (distance - kd) * log_q;
+
+    probability += std::exp(log_term);
+  }
+
+  return std::min(probability, 1.0);
+}
+
+/**
+ * Write the estimated miss ratios of set-associative LRU caches, for each power-of-two number of blocks up to one that
+ * holds every reuse.
+ */
+void write_set_associative(std::string const &filename,
+    hrd::reuse_histogram const &histogram,
+    std::uint64_t block_size,
+    std::vector<std::uint64_t> const &associativities)
+{
+  std::vector<std::pair<double, std::uint64_t>> bins;
+  histogram.for_each([&bins](double distance, std::uint64_t count) {
+    if(!std::isinf(distance)) {
+      bins.emplace_back(distance, count);
+    }
+  });
+
+  auto const largest = bins.empty() ? 0.0 : bins.back().first;
+  auto const total = static_cast<double>(histogram.total());
+
+  std::ofstream output(filename);
+  output << "blocks,bytes,fully_associative";
+  for(auto const ways : associativities) {
+    output << ',' << ways << "_way";
+  }
+  output << '\n';
+
+  for(std::uint64_t blocks = 1;; blocks *= 2) {
+    double hits = 0.0;
+    for(auto const &bin : bins) {
+      if(bin.first < static_cast<double>(blocks)) {
+        hits += static_cast<double>(bin.second);
+      }
+    }
+
+    output << blocks << ',' << blocks * block_size << ',' << 1.0 - hits / total;
+
+    for(auto const ways : associativities) {
+      double expected_hits = 0.0;
+      for(auto const &bin : bins) {
+        expected_hits += static_cast<double>(bin.second) * hit_probability(bin.first, blocks, ways);
+      }
+
+      output << ',' << 1.0 - expected_hits / total;
+    }
+    output << '\n';
+
+    if(static_cast<double>(blocks) > largest) {
+      break;
+    }
+  }
+
+  std::cout << "Wrote the set-associative miss ratios to " << filename << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+  try {
+    // Parse the command line.
+    auto interface = create_command_line_interface();
+    auto const arguments = interface.parse(argc, argv);
+
+    // Check if help was requested.
+    if(arguments["help"]) {
+      print_usage(std::cout, interface);
+
+      return EXIT_SUCCESS;
+    }
+
+    // Make sure we have the required arguments.
+    validate(arguments);
+
+    auto const input_filename = arguments["input"].as<std::string>();
+    auto const output_filename = arguments["output"].as<std::string>();
+
+    auto block_size = arguments["block"].as<std::uint64_t>(64);
+    auto const histogram = arguments["model"]
+                               ? read_model(input_filename, &block_size)
+                               : read_trace(input_filename, block_size, arguments["precision"].as<unsigned>(10));
+
+    if(histogram.total() == 0) {
+      throw std::runtime_error("The input holds no requests.");
+    }
+
+    write_fully_associative(output_filename, histogram, block_size);
+
+    if(arguments["ways"]) {
+      write_set_associative(arguments["ways_output"].as<std::string>(),
+          histogram,
+          block_size,
+          parse_associativities(arguments["ways"].as<std::string>()));
+    }
+  } catch(std::exception const &e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -51,9 +51,7 @@ void truncate_trace(std::string const &input_filename,
     std::string const &output_filename,
     int maximum_size)
 {
-  std::ifstream input_file(input_filename);
-
-  iogem5::packet_trace_reader reader(input_file);
+  iogem5::packet_trace_reader reader(input_filename);
   iogem5::packet_trace_writer writer(output_filename, reader.get_tick_frequency());
 
   int count = 0;